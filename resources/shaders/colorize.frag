@@ -0,0 +1,70 @@
+#version 410 core
+
+// Coloring pass: maps the iteration buffer written by fractal.frag to
+// palette colors. Cost is independent of the iteration count.
+//
+// The buffer may be smaller than the output (coarse preview, upsampled by
+// nearest texel) or an integer multiple of it (supersampling, every texel
+// under the pixel is shaded and the colors averaged).
+//
+// Palettes are rows of a 1D texture array, see core/Palette.h, so a
+// palette costs one fetch and new ones need no shader change.
+//
+// ShaderManager builds one program for the escape-time fractals and one
+// for Sierpinski, with this defined after the #version line:
+//   FRACTAL_TYPE  0: Mandelbrot or Julia, 2: Sierpinski
+
+uniform sampler2D u_iterationTexture;
+uniform sampler1DArray u_palettes;
+uniform int u_paletteLayer;
+uniform float u_paletteCycle; // 0: the row spans u_maxIterations
+uniform float u_palettePhase; // Sierpinski only, the palette ID
+uniform int u_maxIterations;
+uniform vec2 u_bufferScale; // Iteration buffer size / output size
+
+// Output color
+out vec4 outColor;
+
+// Color of one iteration buffer texel
+vec3 shade(vec4 data) {
+#if FRACTAL_TYPE == 2
+    // Sierpinski Triangle: r holds the orbit trap distance
+    float t = 0.5 + 0.5 * sin(data.r * 4.0 + u_palettePhase);
+    vec4 color = texture(u_palettes, vec2(t, float(u_paletteLayer)));
+
+    // Make background black-ish
+    if (data.g < 0.5) color *= 0.0;
+
+    // Invert colors completely (Sierpinski only)
+    return 1.0 - color.rgb;
+#else
+    bool escaped = data.g > 0.5;
+
+    if (escaped) {
+        float smooth_i = data.r;
+        float u = u_paletteCycle > 0.0
+            ? mod(smooth_i, u_paletteCycle) / u_paletteCycle
+            : smooth_i / float(u_maxIterations);
+        return texture(u_palettes, vec2(u, float(u_paletteLayer))).rgb;
+    }
+    return vec3(0.0);
+#endif
+}
+
+void main() {
+    if (u_bufferScale.x <= 1.0) {
+        ivec2 texel = ivec2(gl_FragCoord.xy * u_bufferScale);
+        outColor = vec4(shade(texelFetch(u_iterationTexture, texel, 0)), 1.0);
+        return;
+    }
+
+    int samples = int(u_bufferScale.x + 0.5);
+    ivec2 base = ivec2(gl_FragCoord.xy) * samples;
+    vec3 sum = vec3(0.0);
+    for (int y = 0; y < samples; y++) {
+        for (int x = 0; x < samples; x++) {
+            sum += shade(texelFetch(u_iterationTexture, base + ivec2(x, y), 0));
+        }
+    }
+    outColor = vec4(sum / float(samples * samples), 1.0);
+}
@@ -1,8 +1,28 @@
 #version 410 core
 
+// Iteration pass: writes escape data to an RGBA32F buffer that colorize.frag
+// turns into pixels, so palette changes never re-run this shader.
+//   r = smooth iteration count (Sierpinski: orbit trap distance)
+//   g = 1.0 if escaped (Sierpinski: 1.0 if inside the gasket)
+//
+// ShaderManager builds one program per fractal type and precision mode,
+// with these defined after the #version line:
+//   FRACTAL_TYPE   0: Mandelbrot, 1: Julia, 2: Sierpinski, 3: Burning Ship,
+//                  4: Tricorn, 5-7: Multibrot z^3 to z^5 (core/Formula.h)
+//   FORMULA_POWER  exponent of z per iteration
+//   PRECISION      one of the PRECISION_* values below
+
+#define PRECISION_FLOAT 0
+#define PRECISION_DOUBLE 1        // Native fp64
+#define PRECISION_DOUBLE_FLOAT 2  // Emulated double, .x = high, .y = low
+#define PRECISION_PERTURBATION 3
+
+// Formulas other than z^2 + c go through formulaStep() and formulaDelta(),
+// Mandelbrot and Julia keep their hand-written loops
+#define GENERIC_FORMULA (FRACTAL_TYPE > 2)
+
 uniform vec2 u_resolution;
 // Double precision emulation: .x = high, .y = low
-// Double precision emulation: .x = high, .y = low
 uniform float u_zoomCenter_x_hi;
 uniform float u_zoomCenter_x_lo;
 uniform float u_zoomCenter_y_hi;
@@ -10,19 +30,67 @@ uniform float u_zoomCenter_y_lo;
 uniform float u_zoomSize_hi;
 uniform float u_zoomSize_lo;
 uniform int u_maxIterations;
-uniform int u_paletteId;
-uniform bool u_highPrecision;
-uniform sampler2D u_paletteTexture;
 
-// Fractal type uniforms
-uniform int u_fractalType; // 0: Mandelbrot, 1: Julia, 2: Sierpinski
-uniform vec2 u_juliaC;
+#if PRECISION == PRECISION_DOUBLE
+uniform dvec2 u_zoomCenter;
+uniform double u_zoomSize;
+#endif
+
+// Brent periodicity check: an orbit that comes back within this distance
+// (squared) of a snapshot is cycling and never escapes. Snapshots are taken
+// at power-of-two iterations, so every period is eventually caught.
+uniform float u_periodEpsilonSq;
+
+uniform vec2 u_juliaC; // Julia only
+
+// Perturbation uniforms: the reference orbit Z_n is computed on the CPU in
+// arbitrary precision, pixels only iterate their offset from it. Offsets are
+// scaled by 2^u_zoomExponent so they survive below float's 1e-38 range.
+uniform isampler2D u_orbitTexture; // RG32I, packed Z_n stored row-major
+uniform int u_orbitLength;
+uniform vec2 u_referenceOffset;   // (center - reference) / 2^u_zoomExponent
+uniform float u_zoomMantissa;     // zoomSize / 2^u_zoomExponent
+uniform int u_zoomExponent;
+
+// Series approximation: delta at iteration u_seriesSkip is a cubic in the
+// pixel offset. Coefficients are scaled by 2^-u_seriesExponent.
+uniform int u_seriesSkip; // 0 disables the series
+uniform vec2 u_seriesA;
+uniform vec2 u_seriesB;
+uniform vec2 u_seriesC;
+uniform int u_seriesExponent;
 
-// Output color
-out vec4 outColor;
+// Boundary fill (Mariani-Silver). Pixels on every u_boundaryStep-th row and
+// column are iterated first into their own textures, then the main pass
+// copies those and fills every cell whose whole boundary stayed inside.
+uniform int u_boundaryStep;      // 0 disables the fill
+uniform int u_boundaryPass;      // 0: main pass, 1: sample rows, 2: sample columns
+uniform vec2 u_boundaryOrigin;   // First sample row and column, in pixels
+uniform sampler2D u_boundaryRows;    // Texel (x, j) is pixel (x, j * step)
+uniform sampler2D u_boundaryColumns; // Texel (i, y) is pixel (i * step, y)
+
+// Temporal accumulation: main pass samples are moved off the pixel center
+// by this, in pixels within [-0.5, 0.5). Zero for the regular view.
+uniform vec2 u_jitter;
+
+// Output iteration data
+out vec4 outIteration;
 
 // Constants
 const float split = 8193.0;
+const int ORBIT_TEXTURE_WIDTH = 4096; // Must match ReferenceOrbit::kTextureWidth
+const int ORBIT_MANTISSA_BITS = 25;   // ReferenceOrbit::kMantissaBits
+const int ORBIT_EXPONENT_BIAS = 8192; // ReferenceOrbit::kExponentBias
+const int ITERATION_LIMIT = 10000; // Must match CpuFractalEngine::kIterationLimit
+
+// Perturbation periodicity: the reference returns to its snapshot within
+// float resolution and the pixel's delta repeats to this relative accuracy
+const float REFERENCE_CYCLE_EPSILON_SQ = 1e-14;
+const float DELTA_CYCLE_EPSILON_SQ = 1e-10;
+
+// Rebasing only compares z and delta where |Z| / 2^e stays below 2^this.
+// Deltas are renormalized well below it, so a larger Z is never closer.
+const int REBASE_EXPONENT_LIMIT = 24;
 
 // Emulated double math functions for deep zoom
 vec2 ds_add(vec2 dsa, vec2 dsb) {
@@ -102,195 +170,550 @@ vec2 ds_sqr(vec2 dsa) {
     return dsc;
 }
 
-// Cosine gradient palette function
-vec3 palette(float t, vec3 a, vec3 b, vec3 c, vec3 d) {
-    return a + b*cos(6.28318*(c*t+d));
+vec2 c_mul(vec2 a, vec2 b) {
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+// Main cardioid or period-2 bulb of the Mandelbrot set. The margin keeps
+// rounding of c, good to about 1e-7, from claiming pixels just outside.
+bool inMainBulbs(vec2 c) {
+    float x = c.x - 0.25;
+    float y2 = c.y * c.y;
+    float q = x * x + y2;
+    if (q * (q + x) < 0.25 * y2 - 1e-5) return true;
+    float b = c.x + 1.0;
+    return b * b + y2 < 0.0625 - 1e-5;
+}
+
+#if GENERIC_FORMULA
+// f(z) of the formula, without c: Burning Ship folds z into the first
+// quadrant, Tricorn conjugates it, then it is raised to FORMULA_POWER
+vec2 formulaStep(vec2 z) {
+#if FRACTAL_TYPE == 3
+    z = abs(z);
+#elif FRACTAL_TYPE == 4
+    z.y = -z.y;
+#endif
+#if FORMULA_POWER == 2
+    return vec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y);
+#else
+    vec2 p = z;
+    for (int k = 1; k < FORMULA_POWER; k++) {
+        p = c_mul(p, z);
+    }
+    return p;
+#endif
+}
+
+#if PRECISION == PRECISION_DOUBLE
+dvec2 c_mul(dvec2 a, dvec2 b) {
+    return dvec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+dvec2 formulaStep(dvec2 z) {
+#if FRACTAL_TYPE == 3
+    z = abs(z);
+#elif FRACTAL_TYPE == 4
+    z.y = -z.y;
+#endif
+#if FORMULA_POWER == 2
+    return dvec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y);
+#else
+    dvec2 p = z;
+    for (int k = 1; k < FORMULA_POWER; k++) {
+        p = c_mul(p, z);
+    }
+    return p;
+#endif
+}
+#endif
+
+// formulaStep() on emulated doubles, in place
+void formulaStepDS(inout vec2 z_x, inout vec2 z_y) {
+#if FRACTAL_TYPE == 3
+    if (z_x.x < 0.0) z_x = -z_x;
+    if (z_y.x < 0.0) z_y = -z_y;
+#elif FRACTAL_TYPE == 4
+    z_y = -z_y;
+#endif
+#if FORMULA_POWER == 2
+    vec2 z_xy = ds_mul(z_x, z_y);
+    vec2 x = ds_sub(ds_sqr(z_x), ds_sqr(z_y));
+    z_y = ds_add(z_xy, z_xy);
+    z_x = x;
+#else
+    vec2 p_x = z_x;
+    vec2 p_y = z_y;
+    for (int k = 1; k < FORMULA_POWER; k++) {
+        vec2 x = ds_sub(ds_mul(p_x, z_x), ds_mul(p_y, z_y));
+        p_y = ds_add(ds_mul(p_x, z_y), ds_mul(p_y, z_x));
+        p_x = x;
+    }
+    z_x = p_x;
+    z_y = p_y;
+#endif
+}
+
+// |W + w * 2^e| - |W| in units of 2^e. Written out per sign so the result
+// stays exact when the orbit crosses an axis and the fold flips it.
+float diffabs(float W, float w, int e) {
+    float s = W + ldexp(w, e);
+    if (W >= 0.0) {
+        return s >= 0.0 ? w : -(ldexp(2.0 * W, -e) + w);
+    }
+    return s > 0.0 ? ldexp(2.0 * W, -e) + w : -w;
+}
+
+// f(Z + d * 2^e) - f(Z) in units of 2^e, without the dc term
+vec2 formulaDelta(vec2 Z, vec2 d, int e) {
+#if FRACTAL_TYPE == 3
+    // Real part as for Mandelbrot, the imaginary part is 2 |xy|
+    float x = 2.0 * (Z.x * d.x - Z.y * d.y) + ldexp(d.x * d.x - d.y * d.y, e);
+    float w = Z.x * d.y + Z.y * d.x + ldexp(d.x * d.y, e);
+    return vec2(x, 2.0 * diffabs(Z.x * Z.y, w, e));
+#elif FRACTAL_TYPE == 4
+    // conj(Z + delta)^2 - conj(Z)^2 = conj(2 Z delta + delta^2)
+    vec2 q = 2.0 * c_mul(Z, d) + ldexp(c_mul(d, d), ivec2(e));
+    return vec2(q.x, -q.y);
+#else
+    // (Z + delta)^n - Z^n = delta * sum C(n, k) Z^(n-k) delta^(k-1) over
+    // k = 1..n, by Horner from k = n down
+    vec2 powers[FORMULA_POWER];
+    powers[0] = vec2(1.0, 0.0);
+    for (int k = 1; k < FORMULA_POWER; k++) {
+        powers[k] = c_mul(powers[k - 1], Z);
+    }
+    float binomial = 1.0;
+    vec2 sum = vec2(1.0, 0.0);
+    for (int k = FORMULA_POWER - 1; k >= 1; k--) {
+        binomial = binomial * float(k + 1) / float(FORMULA_POWER - k);
+        sum = binomial * powers[FORMULA_POWER - k] + ldexp(c_mul(sum, d), ivec2(e));
+    }
+    return c_mul(sum, d);
+#endif
+}
+#endif
+
+// Z_n as a mantissa within [-1, 1] and its exponent, unpacking the layout
+// of ReferenceOrbit::packedPoints()
+vec2 orbitMantissa(int n, out int exponent) {
+    ivec2 t = texelFetch(u_orbitTexture, ivec2(n % ORBIT_TEXTURE_WIDTH, n / ORBIT_TEXTURE_WIDTH), 0).xy;
+    int halfBits = 32 - ORBIT_MANTISSA_BITS;
+    ivec2 halves = (t >> ORBIT_MANTISSA_BITS) & ((1 << halfBits) - 1);
+    exponent = (halves.x | (halves.y << halfBits)) - ORBIT_EXPONENT_BIAS;
+    return vec2(bitfieldExtract(t, 0, ORBIT_MANTISSA_BITS)) * exp2(float(2 - ORBIT_MANTISSA_BITS));
+}
+
+// Z_n in float, points below float range become 0
+vec2 orbitAt(int n) {
+    int exponent;
+    vec2 mantissa = orbitMantissa(n, exponent);
+    return ldexp(mantissa, ivec2(exponent));
+}
+
+// Pixel center this fragment iterates, the sample passes spread out the grid
+vec2 pixelCenter() {
+    vec2 texel = floor(gl_FragCoord.xy);
+    if (u_boundaryPass == 1) {
+        texel.y *= float(u_boundaryStep);
+    } else if (u_boundaryPass == 2) {
+        texel.x *= float(u_boundaryStep);
+    } else {
+        return gl_FragCoord.xy + u_jitter;
+    }
+    return texel + u_boundaryOrigin + 0.5;
+}
+
+bool boundaryInside(ivec2 rowTexel, ivec2 columnTexel) {
+    return texelFetch(u_boundaryRows, rowTexel, 0).g == 0.0 &&
+           texelFetch(u_boundaryColumns, columnTexel, 0).g == 0.0;
+}
+
+// Main pass: copies sampled pixels and fills enclosed cells. Returns false
+// if the pixel still has to be iterated.
+bool boundaryFill() {
+    ivec2 p = ivec2(gl_FragCoord.xy) - ivec2(u_boundaryOrigin);
+    if (p.x < 0 || p.y < 0) return false;
+
+    ivec2 rowsSize = textureSize(u_boundaryRows, 0);
+    ivec2 columnsSize = textureSize(u_boundaryColumns, 0);
+    ivec2 cell = p / u_boundaryStep;
+    ivec2 corner = cell * u_boundaryStep;
+
+    // A jittered pixel inside a cell stays inside it, one on the sampled
+    // grid may cross into a neighbour and is iterated
+    if (u_jitter != vec2(0.0) && (p.x == corner.x || p.y == corner.y)) {
+        return false;
+    }
+
+    if (p.y == corner.y && p.x < rowsSize.x && cell.y < rowsSize.y) {
+        outIteration = texelFetch(u_boundaryRows, ivec2(p.x, cell.y), 0);
+        return true;
+    }
+    if (p.x == corner.x && cell.x < columnsSize.x && p.y < columnsSize.y) {
+        outIteration = texelFetch(u_boundaryColumns, ivec2(cell.x, p.y), 0);
+        return true;
+    }
+
+    // Cells at the edge of the sampled grid are iterated normally
+    if (corner.x + u_boundaryStep >= rowsSize.x || cell.y + 1 >= rowsSize.y ||
+        cell.x + 1 >= columnsSize.x || corner.y + u_boundaryStep >= columnsSize.y) {
+        return false;
+    }
+
+    // The set has no holes: a boundary without escaped pixels encloses
+    // only pixels that do not escape either
+    for (int t = 0; t <= u_boundaryStep; t++) {
+        if (!boundaryInside(ivec2(corner.x + t, cell.y), ivec2(cell.x, corner.y + t)) ||
+            !boundaryInside(ivec2(corner.x + t, cell.y + 1), ivec2(cell.x + 1, corner.y + t))) {
+            return false;
+        }
+    }
+    outIteration = vec4(0.0, 0.0, 0.0, 1.0);
+    return true;
 }
 
 void main() {
-    vec2 uv = (gl_FragCoord.xy - 0.5 * u_resolution.xy) / u_resolution.y;
+    vec2 uv = (pixelCenter() - 0.5 * u_resolution.xy) / u_resolution.y;
     
     float iterations = 0.0;
     bool escaped = false;
     float log_zn = 0.0;
     
-    // Sierpinski Triangle (Type 2)
-    if (u_fractalType == 2) {
-        vec2 z = vec2(u_zoomCenter_x_hi, u_zoomCenter_y_hi) + uv * u_zoomSize_hi;
-        
-        // Center correction
-        z.y -= 0.25; 
-        
-        float scale = 1.0;
-        float d = 1000.0;
+#if FRACTAL_TYPE == 2
+    // Sierpinski Triangle
+    vec2 z = vec2(u_zoomCenter_x_hi, u_zoomCenter_y_hi) + uv * u_zoomSize_hi;
+    
+    // Center correction
+    z.y -= 0.25; 
+    
+    float scale = 1.0;
+    float d = 1000.0;
+    
+    for (int i = 0; i < 20; i++) { // Fixed iterations for IFS
+        z.x = abs(z.x);
+        z.y = abs(z.y);
         
-        for (int i = 0; i < 20; i++) { // Fixed iterations for IFS
-            z.x = abs(z.x);
-            z.y = abs(z.y);
-            
-            if (z.x + z.y > 1.0) {
-                float temp = z.x;
-                z.x = 1.0 - z.y;
-                z.y = 1.0 - temp;
-            }
-            
-            z *= 2.0;
-            z.y -= 1.0; // Standard Gasket shift
-            scale *= 2.0;
-            
-            // Trap for coloring
-            d = min(d, length(z));
+        if (z.x + z.y > 1.0) {
+            float temp = z.x;
+            z.x = 1.0 - z.y;
+            z.y = 1.0 - temp;
         }
         
-        // Coloring based on trap distance
-        float t = 0.5 + 0.5 * sin(d * 4.0 + float(u_paletteId));
-        vec4 color = texture(u_paletteTexture, vec2(t, 0.0));
+        z *= 2.0;
+        z.y -= 1.0; // Standard Gasket shift
+        scale *= 2.0;
         
-        // Make background black-ish
-        if (length(z) > 2.0) color *= 0.0;
-        
-        // Invert colors completely (Sierpinski only)
-        outColor = vec4(1.0 - color.rgb, 1.0);
+        // Trap for coloring
+        d = min(d, length(z));
+    }
+    
+    // Trap distance drives the coloring, points outside are background
+    outIteration = vec4(d, length(z) > 2.0 ? 0.0 : 1.0, 0.0, 1.0);
+#else
+    if (u_boundaryStep > 0 && u_boundaryPass == 0 && boundaryFill()) {
         return;
     }
 
-    // Mandelbrot (0) and Julia (1) Logic
-    if (u_highPrecision) {
-        vec2 uv_x_ds = vec2(uv.x, 0.0);
-        vec2 uv_y_ds = vec2(uv.y, 0.0);
+    // Escape-time formulas
+    int limit = min(u_maxIterations, ITERATION_LIMIT);
 
-        vec2 c_x, c_y;
-        vec2 z_x, z_y;
-        
-        // Reconstruct DS numbers from uniforms
-        vec2 zoomCenter_x = vec2(u_zoomCenter_x_hi, u_zoomCenter_x_lo);
-        vec2 zoomCenter_y = vec2(u_zoomCenter_y_hi, u_zoomCenter_y_lo);
-        vec2 zoomSize = vec2(u_zoomSize_hi, u_zoomSize_lo);
-
-        if (u_fractalType == 1) {
-            // Julia: c is constant, z is pixel
-            c_x = vec2(u_juliaC.x, 0.0);
-            c_y = vec2(u_juliaC.y, 0.0);
-            z_x = ds_add(zoomCenter_x, ds_mul(uv_x_ds, zoomSize));
-            z_y = ds_add(zoomCenter_y, ds_mul(uv_y_ds, zoomSize));
-        } else {
-            // Mandelbrot: z starts at 0, c is pixel
-            c_x = ds_add(zoomCenter_x, ds_mul(uv_x_ds, zoomSize));
-            c_y = ds_add(zoomCenter_y, ds_mul(uv_y_ds, zoomSize));
-            z_x = vec2(0.0);
-            z_y = vec2(0.0);
+#if PRECISION == PRECISION_PERTURBATION
+    // Pixel offset from the reference point, in units of 2^u_zoomExponent
+    vec2 dc = u_referenceOffset + uv * u_zoomMantissa;
+
+#if FRACTAL_TYPE == 1
+    vec2 d = dc;
+#else
+#if FRACTAL_TYPE == 0
+    // Float c is only good to the margin of the bulb test
+    if (inMainBulbs(vec2(u_zoomCenter_x_hi, u_zoomCenter_y_hi) + uv * u_zoomSize_hi)) {
+        outIteration = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+#endif
+    vec2 d = vec2(0.0);
+#endif
+
+    // delta = d * 2^e. The exponent only grows back towards zero as the
+    // orbit diverges from the reference, so d never overflows float.
+    int e = u_zoomExponent;
+    int m = 0; // Index into the reference orbit
+
+    // Periodicity snapshot. z is only known to float precision, so a
+    // cycle is the reference repeating and the delta repeating with it.
+    vec2 periodZ = vec2(1e30);
+    vec2 periodD = vec2(0.0);
+    int periodE = 0;
+
+    // Skip the early orbit, where every pixel follows the series
+    if (u_seriesSkip > 0) {
+        vec2 dc2 = c_mul(dc, dc);
+        d = c_mul(u_seriesA, dc) + c_mul(u_seriesB, dc2) + c_mul(u_seriesC, c_mul(dc2, dc));
+        e = u_seriesExponent;
+        m = u_seriesSkip;
+    }
+
+    // First snapshot on the first iteration run, after any skip
+    int checkpoint = max(m, 1);
+
+    for (int i = m; i < u_maxIterations; i++) {
+#if GENERIC_FORMULA
+        vec2 d_next = formulaDelta(orbitAt(m), d, e);
+#else
+        vec2 d_next = 2.0 * c_mul(orbitAt(m), d) + ldexp(c_mul(d, d), ivec2(e));
+#endif
+#if FRACTAL_TYPE != 1
+        d_next += ldexp(dc, ivec2(u_zoomExponent - e));
+#endif
+        d = d_next;
+        m++;
+
+        // Renormalize while the scaled delta is still below float range
+        float mag = max(abs(d.x), abs(d.y));
+        if (e < 0 && mag > 65536.0) {
+            int shift = min(-e, 32);
+            d = ldexp(d, ivec2(-shift));
+            e += shift;
         }
-        
-        for (int i = 0; i < 10000; i++) {
-            if (i >= u_maxIterations) break;
-            
-            vec2 z_x2 = ds_sqr(z_x);
-            vec2 z_y2 = ds_sqr(z_y);
-            
-            if (z_x2.x + z_y2.x > 4.0) {
-                escaped = true;
-                iterations = float(i);
-                log_zn = log2(z_x2.x + z_y2.x) / 2.0;
-                break;
+
+        int exponentZ;
+        vec2 mantissaZ = orbitMantissa(m, exponentZ);
+        vec2 Z = ldexp(mantissaZ, ivec2(exponentZ));
+        vec2 z = Z + ldexp(d, ivec2(e));
+        float r2 = dot(z, z);
+        if (r2 > 4.0) {
+            escaped = true;
+            iterations = float(i);
+            log_zn = log2(r2) / 2.0;
+            break;
+        }
+
+        vec2 dZ = Z - periodZ;
+        vec2 dd = ldexp(d, ivec2(e - periodE)) - periodD;
+        if (dot(dZ, dZ) < REFERENCE_CYCLE_EPSILON_SQ &&
+            dot(dd, dd) < DELTA_CYCLE_EPSILON_SQ * dot(periodD, periodD)) {
+            break;
+        }
+        if (i == checkpoint) {
+            periodZ = Z;
+            periodD = d;
+            periodE = e;
+            checkpoint *= 2;
+        }
+
+        // Reference escaped first: continue from Z_0 with the full value
+        if (m >= u_orbitLength - 1) {
+            d = z - orbitAt(0);
+            e = 0;
+            m = 0;
+        }
+        // Not for Julia: its orbit starts at the reference point, so the
+        // rebased delta would be (Z_m - Z_0) + delta. Both points are stored
+        // to 25 bits, their difference is off by far more than any delta at
+        // perturbation depth. Deep Julia views keep their glitches until the
+        // differences are stored at full precision.
+#if FRACTAL_TYPE != 1
+        // Rebasing: once z is closer to Z_0 = 0 than to the reference, the
+        // reference no longer describes the pixel (the glitch condition) and
+        // the pixel continues from the orbit start with delta = z. Compared
+        // in units of 2^e with Z unpacked, so Z below float range counts.
+        else if (exponentZ - e < REBASE_EXPONENT_LIMIT) {
+            vec2 rebased = ldexp(mantissaZ, ivec2(exponentZ - e)) + d;
+            if (dot(rebased, rebased) < dot(d, d)) {
+                d = rebased;
+                m = 0;
             }
+        }
+#endif
+    }
+#elif PRECISION == PRECISION_DOUBLE
+    dvec2 p = u_zoomCenter + dvec2(uv) * u_zoomSize;
+
+#if FRACTAL_TYPE == 1
+    // Julia: c is constant, z is pixel
+    dvec2 c = dvec2(u_juliaC);
+    dvec2 z = p;
+#else
+    // Mandelbrot and the others: z starts at 0, c is pixel
+    dvec2 c = p;
+    dvec2 z = dvec2(0.0);
+
+#if FRACTAL_TYPE == 0
+    if (inMainBulbs(vec2(c))) {
+        outIteration = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+#endif
+#endif
 
-            vec2 z_xy = ds_mul(z_x, z_y);
-            vec2 two_z_xy = ds_add(z_xy, z_xy);
-            vec2 new_y = ds_add(two_z_xy, c_y);
+    dvec2 period = z;
+    int checkpoint = 1;
 
-            vec2 diff_sq = ds_sub(z_x2, z_y2);
-            vec2 new_x = ds_add(diff_sq, c_x);
+    // Same steps as the float path below
+    for (int i = 0; i < limit; i++) {
+#if GENERIC_FORMULA
+        dvec2 w = formulaStep(z) + c;
+        double x = w.x;
+        double y = w.y;
+#else
+        double x = (z.x * z.x - z.y * z.y) + c.x;
+        double y = (2.0 * z.x * z.y) + c.y;
+#endif
 
-            z_x = new_x;
-            z_y = new_y;
+        if (x * x + y * y > 4.0) {
+            escaped = true;
+            iterations = float(i);
+            log_zn = log2(float(x * x + y * y)) / 2.0;
+            break;
         }
-    } else {
-        vec2 c, z;
+        z = dvec2(x, y);
+
+        dvec2 dz = z - period;
+        if (dot(dz, dz) < double(u_periodEpsilonSq)) break;
+        if (i == checkpoint) {
+            period = z;
+            checkpoint *= 2;
+        }
+    }
+#elif PRECISION == PRECISION_DOUBLE_FLOAT
+    vec2 uv_x_ds = vec2(uv.x, 0.0);
+    vec2 uv_y_ds = vec2(uv.y, 0.0);
+
+    // Reconstruct DS numbers from uniforms
+    vec2 zoomCenter_x = vec2(u_zoomCenter_x_hi, u_zoomCenter_x_lo);
+    vec2 zoomCenter_y = vec2(u_zoomCenter_y_hi, u_zoomCenter_y_lo);
+    vec2 zoomSize = vec2(u_zoomSize_hi, u_zoomSize_lo);
+
+#if FRACTAL_TYPE == 1
+    // Julia: c is constant, z is pixel
+    vec2 c_x = vec2(u_juliaC.x, 0.0);
+    vec2 c_y = vec2(u_juliaC.y, 0.0);
+    vec2 z_x = ds_add(zoomCenter_x, ds_mul(uv_x_ds, zoomSize));
+    vec2 z_y = ds_add(zoomCenter_y, ds_mul(uv_y_ds, zoomSize));
+#else
+    // Mandelbrot and the others: z starts at 0, c is pixel
+    vec2 c_x = ds_add(zoomCenter_x, ds_mul(uv_x_ds, zoomSize));
+    vec2 c_y = ds_add(zoomCenter_y, ds_mul(uv_y_ds, zoomSize));
+    vec2 z_x = vec2(0.0);
+    vec2 z_y = vec2(0.0);
+
+#if FRACTAL_TYPE == 0
+    // The high parts are good to the margin of the bulb test
+    if (inMainBulbs(vec2(c_x.x, c_y.x))) {
+        outIteration = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+#endif
+#endif
+
+    vec2 period_x = z_x;
+    vec2 period_y = z_y;
+    int checkpoint = 1;
+
+    // Squares of z, from the escape test for the next step
+    vec2 z_x2 = ds_sqr(z_x);
+    vec2 z_y2 = ds_sqr(z_y);
+
+    for (int i = 0; i < limit; i++) {
+#if GENERIC_FORMULA
+        vec2 new_x = z_x;
+        vec2 new_y = z_y;
+        formulaStepDS(new_x, new_y);
+        new_x = ds_add(new_x, c_x);
+        new_y = ds_add(new_y, c_y);
+#else
+        vec2 z_xy = ds_mul(z_x, z_y);
+        vec2 two_z_xy = ds_add(z_xy, z_xy);
+        vec2 new_y = ds_add(two_z_xy, c_y);
+
+        vec2 diff_sq = ds_sub(z_x2, z_y2);
+        vec2 new_x = ds_add(diff_sq, c_x);
+#endif
+
+        z_x = new_x;
+        z_y = new_y;
+        z_x2 = ds_sqr(z_x);
+        z_y2 = ds_sqr(z_y);
+
+        // Tested after the step as on the other paths, so a change of
+        // precision tier keeps the iteration count and the color
+        if (z_x2.x + z_y2.x > 4.0) {
+            escaped = true;
+            iterations = float(i);
+            log_zn = log2(z_x2.x + z_y2.x) / 2.0;
+            break;
+        }
+
+        float px = ds_sub(z_x, period_x).x;
+        float py = ds_sub(z_y, period_y).x;
+        if (px * px + py * py < u_periodEpsilonSq) break;
+        if (i == checkpoint) {
+            period_x = z_x;
+            period_y = z_y;
+            checkpoint *= 2;
+        }
+    }
+#else
+#if FRACTAL_TYPE == 1
+    // Julia
+    vec2 c = u_juliaC;
+    vec2 z = vec2(u_zoomCenter_x_hi, u_zoomCenter_y_hi) + uv * u_zoomSize_hi;
+#else
+    // Mandelbrot and the others
+    vec2 c = vec2(u_zoomCenter_x_hi, u_zoomCenter_y_hi) + uv * u_zoomSize_hi;
+    vec2 z = vec2(0.0);
+    
+#if FRACTAL_TYPE == 0
+    // Cardioid and bulb check optimization (Mandelbrot only)
+    if (inMainBulbs(c)) {
+        outIteration = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+#endif
+#endif
+
+    vec2 period = z;
+    int checkpoint = 1;
+
+    for (int i = 0; i < limit; i++) {
+#if GENERIC_FORMULA
+        vec2 w = formulaStep(z) + c;
+        float x = w.x;
+        float y = w.y;
+#else
+        float x = (z.x * z.x - z.y * z.y) + c.x;
+        float y = (2.0 * z.x * z.y) + c.y;
+#endif
         
-        if (u_fractalType == 1) {
-            // Julia
-            c = u_juliaC;
-            z = vec2(u_zoomCenter_x_hi, u_zoomCenter_y_hi) + uv * u_zoomSize_hi;
-        } else {
-            // Mandelbrot
-            c = vec2(u_zoomCenter_x_hi, u_zoomCenter_y_hi) + uv * u_zoomSize_hi;
-            z = vec2(0.0);
-            
-            // Cardioid check optimization (Mandelbrot only)
-            if (u_fractalType == 0) {
-                float p = sqrt((c.x - 0.25) * (c.x - 0.25) + c.y * c.y);
-                if (c.x < p - 2.0 * p * p + 0.25) {
-                    iterations = float(u_maxIterations);
-                    // Skip loop
-                    outColor = vec4(0.0, 0.0, 0.0, 1.0);
-                    return;
-                } 
-            }
+        if (x * x + y * y > 4.0) {
+            escaped = true;
+            iterations = float(i);
+            log_zn = log2(x * x + y * y) / 2.0;
+            break;
         }
+        z.x = x;
+        z.y = y;
 
-        for (int i = 0; i < 10000; i++) {
-            if (i >= u_maxIterations) break;
-            
-            float x = (z.x * z.x - z.y * z.y) + c.x;
-            float y = (2.0 * z.x * z.y) + c.y;
-            
-            if (x * x + y * y > 4.0) {
-                escaped = true;
-                iterations = float(i);
-                log_zn = log2(x * x + y * y) / 2.0;
-                break;
-            }
-            z.x = x;
-            z.y = y;
+        vec2 dz = z - period;
+        if (dot(dz, dz) < u_periodEpsilonSq) break;
+        if (i == checkpoint) {
+            period = z;
+            checkpoint *= 2;
         }
     }
+#endif
 
     if (escaped) {
         float nu = log2(log_zn);
+#if FORMULA_POWER != 2
+        // log |z| grows by a factor of FORMULA_POWER per iteration
+        nu /= log2(float(FORMULA_POWER));
+#endif
         float smooth_i = iterations + 1.0 - nu;
-        float t = smooth_i / float(u_maxIterations);
-        
-        vec3 color = vec3(0.0);
-
-        if (u_paletteId == 0) {
-            // Ocean
-            color = palette(t * 10.0, vec3(0.5), vec3(0.5), vec3(1.0), vec3(0.00, 0.10, 0.20));
-        } else if (u_paletteId == 1) {
-            // Magma
-            color = palette(t * 10.0, vec3(0.5), vec3(0.5), vec3(1.0, 1.0, 0.5), vec3(0.8, 0.9, 0.3));
-            color = mix(vec3(0.1, 0.0, 0.0), color, sin(t * 20.0) * 0.5 + 0.5);
-        } else if (u_paletteId == 2) {
-            // Aurora
-            color = palette(t * 15.0, vec3(0.5), vec3(0.5), vec3(2.0, 1.0, 0.0), vec3(0.5, 0.20, 0.25));
-        } else if (u_paletteId == 3) {
-            // Amber
-            color = palette(t * 8.0, vec3(0.8, 0.5, 0.4), vec3(0.2, 0.4, 0.2), vec3(2.0, 1.0, 1.0), vec3(0.00, 0.25, 0.25));
-        } else if (u_paletteId == 4) {
-            // Extreme (Texture)
-            float cycle = mod(smooth_i, 512.0) / 512.0;
-            color = texture(u_paletteTexture, vec2(cycle, 0.5)).rgb;
-        } else if (u_paletteId == 5) {
-            // Neon
-            color = palette(t * 4.0, vec3(0.5), vec3(0.5), vec3(1.0), vec3(0.3, 0.2, 0.2));
-            color = mix(color, vec3(0.0, 1.0, 1.0), sin(t * 10.0) * 0.5 + 0.5);
-        } else if (u_paletteId == 6) {
-            // Golden
-            color = palette(t * 5.0, vec3(0.8, 0.5, 0.4), vec3(0.2, 0.4, 0.2), vec3(2.0, 1.0, 1.0), vec3(0.00, 0.25, 0.25));
-            color += vec3(0.2, 0.1, 0.0); 
-        } else if (u_paletteId == 7) {
-            // Cyber
-            color = palette(t * 6.0, vec3(0.5), vec3(0.5), vec3(2.0, 1.0, 0.0), vec3(0.5, 0.20, 0.25));
-            color = vec3(1.0) - color; // Invert
-        } else if (u_paletteId == 8) {
-            // Ice
-            color = palette(t * 12.0, vec3(0.5), vec3(0.5), vec3(1.0, 1.0, 1.0), vec3(0.0, 0.33, 0.67));
-        } else if (u_paletteId == 9) {
-            // Forest
-            color = palette(t * 8.0, vec3(0.2, 0.7, 0.4), vec3(0.5, 0.2, 0.3), vec3(1.0), vec3(0.0, 0.1, 0.0));
-        }
-        
-        outColor = vec4(color, 1.0);
+        outIteration = vec4(smooth_i, 1.0, 0.0, 1.0);
     } else {
-        outColor = vec4(0.0, 0.0, 0.0, 1.0);
+        outIteration = vec4(0.0, 0.0, 0.0, 1.0);
     }
+#endif
 }
@@ -0,0 +1,45 @@
+#version 410 core
+
+// Tile cache pass: resamples one cached tile of iteration data into the
+// iteration buffer. Drawn once per tile, scissored to the pixels whose
+// centers fall into it.
+//
+// Tiles have at least one texel per buffer pixel, so each pixel takes four
+// samples spread over its footprint. The escaped flag is a majority vote
+// (ties count as escaped) and the smooth count the mean of the samples
+// that agree with it, so counts are never averaged with interior zeros.
+
+uniform sampler2D u_tile;
+uniform vec2 u_tileOrigin;     // Buffer position of the tile's corner
+uniform float u_texelsPerPixel;
+
+// Output as written by fractal.frag
+out vec4 outColor;
+
+void main() {
+    vec2 position = (gl_FragCoord.xy - u_tileOrigin) * u_texelsPerPixel;
+    ivec2 last = textureSize(u_tile, 0) - 1;
+    float spread = 0.25 * u_texelsPerPixel;
+
+    vec4 samples[4];
+    samples[0] = texelFetch(u_tile, clamp(ivec2(position + vec2(-spread, -spread)), ivec2(0), last), 0);
+    samples[1] = texelFetch(u_tile, clamp(ivec2(position + vec2( spread, -spread)), ivec2(0), last), 0);
+    samples[2] = texelFetch(u_tile, clamp(ivec2(position + vec2(-spread,  spread)), ivec2(0), last), 0);
+    samples[3] = texelFetch(u_tile, clamp(ivec2(position + vec2( spread,  spread)), ivec2(0), last), 0);
+
+    float flagged = 0.0;
+    for (int i = 0; i < 4; i++) {
+        flagged += step(0.5, samples[i].g);
+    }
+    float flag = flagged >= 2.0 ? 1.0 : 0.0;
+
+    float sum = 0.0;
+    float count = 0.0;
+    for (int i = 0; i < 4; i++) {
+        if (step(0.5, samples[i].g) == flag) {
+            sum += samples[i].r;
+            count += 1.0;
+        }
+    }
+    outColor = vec4(sum / count, flag, 0.0, 1.0);
+}
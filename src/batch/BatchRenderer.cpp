@@ -0,0 +1,267 @@
+#include "BatchRenderer.h"
+#include "cpu/CpuRenderer.h"
+#include "export/PosterExporter.h"
+#include "export/StreamingImageWriter.h"
+#include "export/VideoEncoderPipe.h"
+#include "export/VideoJourneyExporter.h"
+#include "rendering/FractalRenderer.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <algorithm>
+
+BatchRenderer::BatchRenderer(int cpuThreads)
+    : m_cpuThreads(cpuThreads), m_lastEngine(RenderJob::Engine::Cpu) {}
+
+// The GL objects need the context that created them, see release()
+BatchRenderer::~BatchRenderer() = default;
+
+bool BatchRenderer::render(const RenderJob &job) {
+  m_error.clear();
+
+  RenderJob::Engine engine;
+  if (!chooseEngine(job.engine, engine))
+    return false;
+  const QString directory = QFileInfo(job.output).absolutePath();
+  if (!QDir().mkpath(directory)) {
+    m_error = QString("Cannot create %1").arg(directory);
+    return false;
+  }
+
+  const bool gpu = engine == RenderJob::Engine::Gpu;
+  if (job.kind == RenderJob::Kind::Journey)
+    return gpu ? renderJourneyGpu(job) : renderJourneyCpu(job);
+  return gpu ? renderImageGpu(job) : renderImageCpu(job);
+}
+
+bool BatchRenderer::renderView(const FractalState &state, const QSize &size,
+                               bool supersample, RenderJob::Engine engine,
+                               std::vector<unsigned char> &rgb) {
+  m_error.clear();
+  if (!chooseEngine(engine, engine))
+    return false;
+
+  const int width = size.width();
+  const int height = size.height();
+  const int factor = supersample ? 2 : 1;
+  rgb.resize(static_cast<size_t>(width) * height * 3);
+
+  if (engine == RenderJob::Engine::Cpu) {
+    packImage(cpu().render(state, QSize(width * factor, height * factor)),
+              factor, rgb.data());
+    return true;
+  }
+
+  if (!m_gpu) {
+    initializeOpenGLFunctions();
+    m_gpu = std::make_unique<FractalRenderer>();
+    if (!m_gpu->initialize()) {
+      m_gpu.reset();
+      m_error = "Failed to initialize the renderer";
+      return false;
+    }
+    if (!m_pendingOrbit.isEmpty()) {
+      m_gpu->setReferenceOrbit(m_pendingOrbit);
+      m_pendingOrbit = ReferenceOrbit();
+    }
+  }
+  if (!m_viewTarget || m_viewTarget->size() != size) {
+    m_viewTarget = std::make_unique<QOpenGLFramebufferObject>(size);
+    if (!m_viewTarget->isValid()) {
+      m_viewTarget.reset();
+      m_error = "Failed to create the view framebuffer";
+      return false;
+    }
+  }
+  m_gpu->setResolutionScale(static_cast<float>(factor));
+
+  // Time-sliced like on screen, so no single draw trips the watchdog
+  do {
+    m_gpu->render(state, size, m_viewTarget->handle());
+  } while (m_gpu->hasPendingWork());
+
+  // A single synchronous read, a worker has nothing to overlap it with
+  m_readback.resize(static_cast<size_t>(width) * height * 4);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_viewTarget->handle());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+               m_readback.data());
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // Drop alpha and flip to top-down order
+  for (int row = 0; row < height; ++row) {
+    const unsigned char *src =
+        m_readback.data() + static_cast<size_t>(height - 1 - row) * width * 4;
+    unsigned char *dst = rgb.data() + static_cast<size_t>(row) * width * 3;
+    for (int x = 0; x < width; ++x) {
+      dst[3 * x] = src[4 * x];
+      dst[3 * x + 1] = src[4 * x + 1];
+      dst[3 * x + 2] = src[4 * x + 2];
+    }
+  }
+  return true;
+}
+
+void BatchRenderer::setReferenceOrbit(const ReferenceOrbit &orbit) {
+  if (m_gpu) {
+    m_gpu->setReferenceOrbit(orbit);
+    return;
+  }
+  // CPU units set the same orbit over and over, copy it once
+  if (m_pendingOrbit.generation() != orbit.generation() ||
+      m_pendingOrbit.length() != orbit.length())
+    m_pendingOrbit = orbit;
+}
+
+void BatchRenderer::release() {
+  m_viewTarget.reset();
+  m_gpu.reset();
+}
+
+void BatchRenderer::packImage(const QImage &image, int factor,
+                              unsigned char *rgb) {
+  const int width = image.width() / factor;
+  const int height = image.height() / factor;
+
+  for (int y = 0; y < height; ++y) {
+    unsigned char *dst = rgb + static_cast<size_t>(y) * width * 3;
+    if (factor == 1) {
+      std::copy_n(image.constScanLine(y), width * 3, dst);
+      continue;
+    }
+    const unsigned char *upper = image.constScanLine(2 * y);
+    const unsigned char *lower = image.constScanLine(2 * y + 1);
+    for (int x = 0; x < width * 3; ++x) {
+      const int channel = x % 3;
+      const int left = (x - channel) * 2 + channel;
+      const int sum =
+          upper[left] + upper[left + 3] + lower[left] + lower[left + 3];
+      dst[x] = static_cast<unsigned char>((sum + 2) / 4);
+    }
+  }
+}
+
+bool BatchRenderer::chooseEngine(RenderJob::Engine wanted,
+                                 RenderJob::Engine &engine) {
+  const bool gpuAvailable = QOpenGLContext::currentContext() != nullptr;
+  engine = wanted;
+  if (engine == RenderJob::Engine::Auto)
+    engine = gpuAvailable ? RenderJob::Engine::Gpu : RenderJob::Engine::Cpu;
+  m_lastEngine = engine;
+
+  if (engine == RenderJob::Engine::Gpu && !gpuAvailable) {
+    m_error = "No GL context for a GPU job";
+    return false;
+  }
+  return true;
+}
+
+bool BatchRenderer::renderImageGpu(const RenderJob &job) {
+  PosterExporter::Settings settings;
+  settings.width = job.size.width();
+  settings.height = job.size.height();
+  settings.supersample = job.supersample;
+
+  PosterExporter exporter;
+  if (!exporter.exportImage(job.state, settings, job.output)) {
+    m_error = exporter.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool BatchRenderer::renderImageCpu(const RenderJob &job) {
+  const int width = job.size.width();
+  const int height = job.size.height();
+  const int factor = job.supersample ? 2 : 1;
+
+  StreamingImageWriter writer;
+  if (!writer.open(job.output, width, height,
+                   StreamingImageWriter::formatForPath(job.output))) {
+    m_error = writer.errorString();
+    return false;
+  }
+
+  // Bands keep the image's pixel size, as the tiles of PosterExporter
+  const double pixelSize = job.state.zoomSize / height;
+  std::vector<unsigned char> rows(static_cast<size_t>(width) * kBandRows * 3);
+
+  for (int top = 0; top < height; top += kBandRows) {
+    const int bandRows = std::min(kBandRows, height - top);
+    FractalState band = job.state;
+    band.zoomSize = pixelSize * bandRows;
+    band.translate(0.0, (0.5 * height - (top + 0.5 * bandRows)) * pixelSize);
+
+    packImage(cpu().render(band, QSize(width * factor, bandRows * factor)),
+              factor, rows.data());
+    if (!writer.writeRows(rows.data(), bandRows)) {
+      m_error = writer.errorString();
+      writer.abort();
+      return false;
+    }
+  }
+
+  if (!writer.finish()) {
+    m_error = writer.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool BatchRenderer::renderJourneyGpu(const RenderJob &job) {
+  VideoJourneyExporter::Settings settings;
+  settings.width = job.size.width();
+  settings.height = job.size.height();
+  settings.fps = job.fps;
+  settings.durationSeconds = job.durationSeconds;
+  settings.startZoomSize = job.startZoomSize;
+  settings.supersample = job.supersample;
+
+  VideoJourneyExporter exporter;
+  if (!exporter.exportVideo(job.state, settings, job.output)) {
+    m_error = exporter.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool BatchRenderer::renderJourneyCpu(const RenderJob &job) {
+  const int width = job.size.width();
+  const int height = job.size.height();
+  const int factor = job.supersample ? 2 : 1;
+  const int frameCount = job.frameCount();
+
+  VideoEncoderPipe encoder;
+  if (!encoder.open(job.output, width, height, job.fps)) {
+    m_error = encoder.errorString();
+    return false;
+  }
+
+  std::vector<unsigned char> rgb(static_cast<size_t>(width) * height * 3);
+  for (int frame = 0; frame < frameCount; ++frame) {
+    const double t =
+        frameCount > 1 ? static_cast<double>(frame) / (frameCount - 1) : 1.0;
+    const FractalState view =
+        VideoJourneyExporter::frameState(job.state, job.startZoomSize, t);
+
+    packImage(cpu().render(view, QSize(width * factor, height * factor)),
+              factor, rgb.data());
+    if (!encoder.writeFrame(rgb.data())) {
+      m_error = encoder.errorString();
+      encoder.abort();
+      return false;
+    }
+  }
+
+  if (!encoder.finish()) {
+    m_error = encoder.errorString();
+    return false;
+  }
+  return true;
+}
+
+CpuRenderer &BatchRenderer::cpu() {
+  if (!m_cpu)
+    m_cpu = std::make_unique<CpuRenderer>(m_cpuThreads);
+  return *m_cpu;
+}
@@ -0,0 +1,110 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include "JobFile.h"
+#include "core/ReferenceOrbit.h"
+#include <QImage>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QString>
+#include <memory>
+#include <vector>
+
+class CpuRenderer;
+class FractalRenderer;
+
+/**
+ * @brief Renders RenderJobs to image and video files without a window
+ *
+ * GPU jobs go through PosterExporter and VideoJourneyExporter and need a GL
+ * context current on the calling thread. CPU images render one band of
+ * rows at a time on the CPU engine, CPU journeys one frame at a time.
+ * Output streams to a StreamingImageWriter or VideoEncoderPipe either way,
+ * so memory use is one band or frame regardless of the job.
+ *
+ * renderView() renders a single view into memory with renderers that live
+ * as long as this object, the unit of work of farm workers.
+ */
+class BatchRenderer : protected QOpenGLExtraFunctions {
+public:
+  // 0 threads means one per allowed core
+  explicit BatchRenderer(int cpuThreads = 0);
+  ~BatchRenderer();
+
+  /**
+   * @brief Renders @p job to its output file
+   *
+   * Auto jobs use the GPU if a context is current and the CPU otherwise.
+   * @return false on failure, see errorString(). A failed job leaves no
+   * file behind.
+   */
+  bool render(const RenderJob &job);
+
+  /**
+   * @brief Renders @p state at @p size into @p rgb
+   *
+   * Packed RGB8, top row first. @p engine as for a job.
+   * @return false on failure, see errorString()
+   */
+  bool renderView(const FractalState &state, const QSize &size,
+                  bool supersample, RenderJob::Engine engine,
+                  std::vector<unsigned char> &rgb);
+
+  /**
+   * @brief Perturbation reference for the next renderView() calls on the
+   * GPU
+   *
+   * Kept until the GPU renderer exists if it has not been created yet. The
+   * CPU engine computes its own orbits.
+   */
+  void setReferenceOrbit(const ReferenceOrbit &orbit);
+
+  /**
+   * @brief Frees the GL objects of renderView()
+   *
+   * Call with the context current before it is released, the destructor
+   * may run without one. The next GPU renderView() creates them again.
+   */
+  void release();
+
+  /**
+   * @brief Packs a CpuRenderer image into @p rgb, averaging @p factor x
+   * @p factor blocks
+   *
+   * QImage pads lines to 4 bytes, the writers want them packed. @p rgb
+   * holds (width / factor) * (height / factor) * 3 bytes.
+   */
+  static void packImage(const QImage &image, int factor, unsigned char *rgb);
+
+  // Engine the last render() or renderView() used, Gpu or Cpu
+  RenderJob::Engine lastEngine() const { return m_lastEngine; }
+  QString errorString() const { return m_error; }
+
+private:
+  // Rows per CPU band
+  static constexpr int kBandRows = 256;
+
+  // Resolves Auto, false if the GPU is wanted but there is no context
+  bool chooseEngine(RenderJob::Engine wanted, RenderJob::Engine &engine);
+
+  bool renderImageGpu(const RenderJob &job);
+  bool renderImageCpu(const RenderJob &job);
+  bool renderJourneyGpu(const RenderJob &job);
+  bool renderJourneyCpu(const RenderJob &job);
+
+  CpuRenderer &cpu();
+
+  int m_cpuThreads;
+  std::unique_ptr<CpuRenderer> m_cpu; // Created by the first CPU job
+
+  // renderView() on the GPU, created by its first call
+  std::unique_ptr<FractalRenderer> m_gpu;
+  std::unique_ptr<QOpenGLFramebufferObject> m_viewTarget;
+  ReferenceOrbit m_pendingOrbit; // Set before m_gpu, handed over with it
+  std::vector<unsigned char> m_readback;
+
+  RenderJob::Engine m_lastEngine;
+  QString m_error;
+};
+
+#endif // BATCHRENDERER_H
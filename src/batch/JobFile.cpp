@@ -0,0 +1,163 @@
+#include "JobFile.h"
+#include "core/Formula.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <cmath>
+
+namespace {
+// Numbers are exact up to double precision, strings to any depth
+bool parseCoordinate(const QJsonValue &value, int limbs, BigReal &result) {
+  if (value.isString()) {
+    const QString text = value.toString().trimmed();
+    bool ok = false;
+    const BigReal parsed = BigReal::fromString(text.toStdString(), limbs, &ok);
+    if (ok)
+      result = parsed;
+    return ok;
+  }
+  if (value.isDouble()) {
+    result = BigReal(value.toDouble(), limbs);
+    return true;
+  }
+  return false;
+}
+} // namespace
+
+bool JobFile::load(const QString &path, const QString &outputDir) {
+  m_jobs.clear();
+  m_error.clear();
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    m_error = QString("Cannot read %1: %2").arg(path, file.errorString());
+    return false;
+  }
+  QJsonParseError parseError;
+  const QJsonDocument document =
+      QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (!document.isObject()) {
+    m_error = QString("%1: %2").arg(path, parseError.errorString());
+    return false;
+  }
+
+  const QJsonObject root = document.object();
+  const QJsonObject defaults = root["defaults"].toObject();
+  const QJsonArray jobs = root["jobs"].toArray();
+  if (jobs.isEmpty()) {
+    m_error = QString("%1 has no jobs").arg(path);
+    return false;
+  }
+  const QDir base(outputDir.isEmpty() ? QFileInfo(path).absolutePath()
+                                      : outputDir);
+
+  for (int index = 0; index < jobs.size(); ++index) {
+    QJsonObject fields = defaults;
+    const QJsonObject own = jobs[index].toObject();
+    for (auto it = own.begin(); it != own.end(); ++it)
+      fields[it.key()] = it.value();
+
+    auto fail = [&](const QString &message) {
+      m_error = QString("%1, job %2: %3").arg(path).arg(index + 1).arg(message);
+      m_jobs.clear();
+      return false;
+    };
+
+    RenderJob job;
+    const QString type = fields["type"].toString("image");
+    if (type == "image")
+      job.kind = RenderJob::Kind::Image;
+    else if (type == "journey")
+      job.kind = RenderJob::Kind::Journey;
+    else
+      return fail(QString("unknown type \"%1\"").arg(type));
+
+    const QString output = fields["output"].toString();
+    if (output.isEmpty())
+      return fail("no output path");
+    job.output = QDir::cleanPath(base.absoluteFilePath(output));
+    job.name = fields["name"].toString(QFileInfo(output).fileName());
+
+    FractalState &state = job.state;
+    const QString fractal = fields["fractal"].toString("mandelbrot");
+    state.fractalType = Formula::fromName(fractal.toUtf8().constData());
+    if (state.fractalType < 0)
+      return fail(QString("unknown fractal \"%1\"").arg(fractal));
+
+    state.zoomSize = fields["zoomSize"].toDouble(state.zoomSize);
+    state.maxIterations = fields["maxIterations"].toInt(state.maxIterations);
+    state.paletteId = fields["palette"].toInt(state.paletteId);
+    state.juliaCx = fields["juliaCx"].toDouble(state.juliaCx);
+    state.juliaCy = fields["juliaCy"].toDouble(state.juliaCy);
+    if (!(state.zoomSize > 0.0))
+      return fail("zoomSize must be positive");
+    if (state.maxIterations <= 0)
+      return fail("maxIterations must be positive");
+
+    const int limbs = BigReal::limbsForScale(state.zoomSize);
+    state.deepCenterX.setLimbCount(limbs);
+    state.deepCenterY.setLimbCount(limbs);
+    if (fields.contains("centerX") &&
+        !parseCoordinate(fields["centerX"], limbs, state.deepCenterX))
+      return fail("centerX must be a number or a decimal string");
+    if (fields.contains("centerY") &&
+        !parseCoordinate(fields["centerY"], limbs, state.deepCenterY))
+      return fail("centerY must be a number or a decimal string");
+    state.zoomCenterX = state.deepCenterX.toDouble();
+    state.zoomCenterY = state.deepCenterY.toDouble();
+
+    job.size = QSize(fields["width"].toInt(job.size.width()),
+                     fields["height"].toInt(job.size.height()));
+    if (job.size.isEmpty())
+      return fail("width and height must be positive");
+    job.supersample = fields["supersample"].toBool(false);
+
+    if (job.kind == RenderJob::Kind::Journey) {
+      job.fps = fields["fps"].toInt(job.fps);
+      job.durationSeconds = fields["duration"].toDouble(job.durationSeconds);
+      job.startZoomSize =
+          fields["startZoomSize"].toDouble(job.startZoomSize);
+      if (job.fps <= 0 || job.frameCount() <= 0)
+        return fail("fps and duration must be positive");
+      if (!(job.startZoomSize > 0.0))
+        return fail("startZoomSize must be positive");
+      if (job.size.width() % 2 != 0 || job.size.height() % 2 != 0)
+        return fail("journey width and height must be even");
+    }
+
+    const QString engine = fields["engine"].toString("auto");
+    if (engine == "auto")
+      job.engine = RenderJob::Engine::Auto;
+    else if (engine == "gpu")
+      job.engine = RenderJob::Engine::Gpu;
+    else if (engine == "cpu")
+      job.engine = RenderJob::Engine::Cpu;
+    else
+      return fail(QString("unknown engine \"%1\"").arg(engine));
+
+    m_jobs.push_back(job);
+  }
+  return true;
+}
+
+int RenderJob::frameCount() const {
+  if (kind == Kind::Image)
+    return 1;
+  return static_cast<int>(std::lround(durationSeconds * fps));
+}
+
+const char *JobFile::engineName(RenderJob::Engine engine) {
+  switch (engine) {
+  case RenderJob::Engine::Auto:
+    return "auto";
+  case RenderJob::Engine::Gpu:
+    return "gpu";
+  case RenderJob::Engine::Cpu:
+    return "cpu";
+  }
+  return "unknown";
+}
@@ -0,0 +1,74 @@
+#ifndef JOBFILE_H
+#define JOBFILE_H
+
+#include "core/FractalState.h"
+#include <QSize>
+#include <QString>
+#include <vector>
+
+// One image or video of a batch run
+struct RenderJob {
+  enum class Kind { Image, Journey };
+  enum class Engine { Auto, Gpu, Cpu };
+
+  Kind kind = Kind::Image;
+  QString name;
+  FractalState state;
+  QSize size = QSize(1920, 1080);
+  bool supersample = false; // 2x2 samples per pixel
+  Engine engine = Engine::Auto;
+  QString output; // Absolute path, PNG or TIFF by suffix for images
+
+  // Journeys zoom from startZoomSize into the view like VideoJourneyExporter
+  int fps = 30;
+  double durationSeconds = 30.0;
+  double startZoomSize = 3.0;
+
+  // Frames of a journey, 1 for an image
+  int frameCount() const;
+};
+
+/**
+ * @brief Reads the job file of fractonaut-render
+ *
+ * A JSON object with a "jobs" array and an optional "defaults" object.
+ * Every job takes the fields of the defaults it does not set itself:
+ *
+ *   output         file path, relative to the output directory (required)
+ *   type           "image" or "journey", a video encoded by ffmpeg
+ *   name           label for progress output, the output file by default
+ *   fractal        "mandelbrot", "julia", "sierpinski", "burningship",
+ *                  "tricorn" or "multibrot3" to "multibrot5"
+ *   centerX/Y      decimal strings for full precision, numbers are doubles
+ *   zoomSize       vertical extent in fractal units
+ *   maxIterations
+ *   palette        palette ID, as the number keys in the application
+ *   juliaCx/Cy     the Julia constant
+ *   width, height  pixels
+ *   supersample    true for 2x2 samples per pixel
+ *   engine         "gpu", "cpu" or "auto" (GPU if available)
+ *   fps, duration, startZoomSize
+ *                  journey frame rate, seconds and the zoom it starts at
+ *
+ * Unset fields keep the application's default view.
+ */
+class JobFile {
+public:
+  /**
+   * @brief Parses @p path, relative outputs resolve against @p outputDir or
+   * the job file's directory if empty
+   * @return false on failure, see errorString()
+   */
+  bool load(const QString &path, const QString &outputDir = QString());
+
+  const std::vector<RenderJob> &jobs() const { return m_jobs; }
+  QString errorString() const { return m_error; }
+
+  static const char *engineName(RenderJob::Engine engine);
+
+private:
+  std::vector<RenderJob> m_jobs;
+  QString m_error;
+};
+
+#endif // JOBFILE_H
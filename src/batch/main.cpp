@@ -0,0 +1,219 @@
+#include "BatchRenderer.h"
+#include "JobFile.h"
+#include "farm/FarmCoordinator.h"
+#include "farm/FarmProtocol.h"
+#include "farm/FarmWorker.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+// Exit codes
+constexpr int kRendered = 0;
+constexpr int kJobsFailed = 1;
+constexpr int kFailed = 2;
+
+bool parseEngine(const QString &name, RenderJob::Engine &engine) {
+  if (name == "gpu")
+    engine = RenderJob::Engine::Gpu;
+  else if (name == "cpu")
+    engine = RenderJob::Engine::Cpu;
+  else if (name == "auto")
+    engine = RenderJob::Engine::Auto;
+  else
+    return false;
+  return true;
+}
+
+// Same profile as the application, on an offscreen surface
+bool makeContextCurrent(QOpenGLContext &context, QOffscreenSurface &surface) {
+  QSurfaceFormat format;
+  format.setVersion(4, 1);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+  context.setFormat(format);
+  if (!context.create())
+    return false;
+  surface.setFormat(context.format());
+  surface.create();
+  return context.makeCurrent(&surface);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MACOS)
+  // Without a display the default platform plugin aborts at startup. The
+  // offscreen one still offers GL where the driver allows it, and CPU jobs
+  // need no GL at all.
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") &&
+      qEnvironmentVariableIsEmpty("DISPLAY") &&
+      qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+  QGuiApplication app(argc, argv);
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Renders the views of job files to images or videos without a "
+      "window.\n"
+      "With --farm the jobs are split into tiles or frames and rendered by "
+      "the workers that connect, started with --worker on any number of "
+      "machines.\n"
+      "On machines without a display this runs on the offscreen platform, "
+      "set QT_QPA_PLATFORM (for example to eglfs) to choose another.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("jobs", "Job files to render.", "jobs...");
+  const QCommandLineOption engineOption(
+      "engine", "Engine for every job: gpu, cpu or auto. Overrides the job "
+      "files.", "engine");
+  const QCommandLineOption threadsOption(
+      "threads", "CPU engine threads, 0 for one per core.", "count", "0");
+  const QCommandLineOption outputDirOption(
+      "output-dir",
+      "Directory relative output paths resolve against, by default the "
+      "job file's.",
+      "dir");
+  const QCommandLineOption farmOption(
+      "farm", "Render the jobs on farm workers instead of locally.");
+  const QCommandLineOption portOption(
+      "port", "Port the farm listens on.", "port",
+      QString::number(FarmProtocol::kDefaultPort));
+  const QCommandLineOption workerOption(
+      "worker", "Serve the farm at host[:port] instead of rendering jobs.",
+      "host");
+  parser.addOptions({engineOption, threadsOption, outputDirOption,
+                     farmOption, portOption, workerOption});
+  parser.process(app);
+
+  RenderJob::Engine engine = RenderJob::Engine::Auto;
+  if (parser.isSet(engineOption) &&
+      !parseEngine(parser.value(engineOption), engine)) {
+    err << "Unknown engine " << parser.value(engineOption) << '\n';
+    return kFailed;
+  }
+
+  QOpenGLContext context;
+  QOffscreenSurface surface;
+  BatchRenderer renderer(parser.value(threadsOption).toInt());
+
+  if (parser.isSet(workerOption)) {
+    const QString address = parser.value(workerOption);
+    const QString host = address.section(':', 0, 0);
+    const quint16 port =
+        address.contains(":")
+            ? static_cast<quint16>(address.section(':', 1, 1).toUInt())
+            : FarmProtocol::kDefaultPort;
+
+    if (engine != RenderJob::Engine::Cpu &&
+        !makeContextCurrent(context, surface)) {
+      if (engine == RenderJob::Engine::Gpu) {
+        err << "Failed to create a GL 4.1 context\n";
+        return kFailed;
+      }
+      err << "No GL 4.1 context, rendering on the CPU\n";
+      engine = RenderJob::Engine::Cpu;
+    }
+
+    FarmWorker worker(renderer, engine);
+    out << "Serving " << host << ':' << port << '\n';
+    out.flush();
+    const bool served = worker.run(host, port);
+    out << worker.unitsRendered() << " units rendered\n";
+    if (!served) {
+      err << worker.errorString() << '\n';
+      return kFailed;
+    }
+    return kRendered;
+  }
+
+  const QStringList jobFiles = parser.positionalArguments();
+  if (jobFiles.isEmpty()) {
+    err << "No job files given\n";
+    return kFailed;
+  }
+
+  std::vector<RenderJob> jobs;
+  for (const QString &path : jobFiles) {
+    JobFile file;
+    if (!file.load(path, parser.value(outputDirOption))) {
+      err << file.errorString() << '\n';
+      return kFailed;
+    }
+    jobs.insert(jobs.end(), file.jobs().begin(), file.jobs().end());
+  }
+  if (parser.isSet(engineOption)) {
+    for (RenderJob &job : jobs)
+      job.engine = engine;
+  }
+
+  // The farm renders nothing itself. Locally a context is only created
+  // when some job may use it.
+  const bool farm = parser.isSet(farmOption);
+  FarmCoordinator coordinator;
+  bool gpu = false;
+  if (farm) {
+    const quint16 port =
+        static_cast<quint16>(parser.value(portOption).toUInt());
+    if (!coordinator.listen(port)) {
+      err << coordinator.errorString() << '\n';
+      return kFailed;
+    }
+  } else if (std::any_of(jobs.begin(), jobs.end(), [](const RenderJob &job) {
+               return job.engine != RenderJob::Engine::Cpu;
+             })) {
+    gpu = makeContextCurrent(context, surface);
+    if (!gpu)
+      err << "No GL 4.1 context, GPU jobs fail and auto jobs use the CPU\n";
+  }
+
+  int failed = 0;
+  const int jobCount = static_cast<int>(jobs.size());
+  for (int i = 0; i < jobCount; ++i) {
+    const RenderJob &job = jobs[i];
+    out << QString("[%1/%2] %3 %4x%5 ")
+               .arg(i + 1)
+               .arg(jobCount)
+               .arg(job.name)
+               .arg(job.size.width())
+               .arg(job.size.height());
+    if (farm)
+      out << '\n';
+    out.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool rendered = farm ? coordinator.render(job) : renderer.render(job);
+    const QString how =
+        farm ? QString("farm") : JobFile::engineName(renderer.lastEngine());
+    if (rendered) {
+      out << QString("%1 %2 s -> %3\n")
+                 .arg(how)
+                 .arg(timer.elapsed() / 1000.0, 0, 'f', 2)
+                 .arg(job.output);
+    } else {
+      out << how << " failed\n";
+      err << job.name << ": "
+          << (farm ? coordinator.errorString() : renderer.errorString())
+          << '\n';
+      ++failed;
+    }
+    out.flush();
+  }
+
+  if (gpu) {
+    renderer.release();
+    context.doneCurrent();
+  }
+
+  if (failed > 0) {
+    err << failed << " of " << jobCount << " jobs failed\n";
+    return kJobsFailed;
+  }
+  return kRendered;
+}
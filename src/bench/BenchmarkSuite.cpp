@@ -0,0 +1,297 @@
+#include "BenchmarkSuite.h"
+#include "core/Formula.h"
+#include "cpu/CpuFractalEngine.h"
+#include "cpu/CpuRenderer.h"
+#include "cpu/TileScheduler.h"
+#include "rendering/FractalRenderer.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace {
+// Seahorse valley, the start view of the web version
+constexpr double kSeahorseX = -0.74364388703;
+constexpr double kSeahorseY = 0.1318259042;
+
+// A point that stays on the boundary far below double resolution
+const char *const kDeepX = "-0.743643887037158704752191506114774";
+const char *const kDeepY = "0.131825904205311970493132056385139";
+
+FractalState location(const BigReal &x, const BigReal &y, double zoomSize,
+                      int maxIterations) {
+  FractalState state;
+  state.deepCenterX = x;
+  state.deepCenterY = y;
+  state.zoomCenterX = x.toDouble();
+  state.zoomCenterY = y.toDouble();
+  state.zoomSize = zoomSize;
+  state.maxIterations = maxIterations;
+  return state;
+}
+
+QString precisionName(CpuFractalEngine::Precision precision) {
+  switch (precision) {
+  case CpuFractalEngine::Precision::Float:
+    return "float";
+  case CpuFractalEngine::Precision::Double:
+    return "double";
+  case CpuFractalEngine::Precision::Perturbation:
+    return "perturbation";
+  }
+  return "unknown";
+}
+} // namespace
+
+BenchmarkSuite::BenchmarkSuite() {}
+
+std::vector<BenchmarkSuite::Location> BenchmarkSuite::defaultLocations() {
+  const int limbs = BigReal::limbsForScale(1e-30);
+  const BigReal deepX = BigReal::fromString(kDeepX, limbs);
+  const BigReal deepY = BigReal::fromString(kDeepY, limbs);
+  const BigReal seahorseX(kSeahorseX);
+  const BigReal seahorseY(kSeahorseY);
+
+  // The home view of the formulas with their own loops
+  FractalState burningShip;
+  burningShip.fractalType = Formula::BurningShip;
+  FractalState multibrot;
+  multibrot.fractalType = Formula::Multibrot3;
+
+  return {
+      {"default", FractalState()},
+      {"seahorse", location(seahorseX, seahorseY, 1e-2, 1000)},
+      {"seahorse-double", location(seahorseX, seahorseY, 1e-9, 2000)},
+      {"deep-1e-14", location(deepX, deepY, 1e-14, 5000)},
+      {"deep-1e-30", location(deepX, deepY, 1e-30, 10000)},
+      {"burningship", burningShip},
+      {"multibrot3", multibrot},
+  };
+}
+
+bool BenchmarkSuite::run(const std::vector<Location> &locations,
+                         const Settings &settings,
+                         std::vector<Result> &results) {
+  m_error.clear();
+  results.clear();
+  if (settings.size.isEmpty() || settings.frames <= 0) {
+    m_error = "Invalid benchmark settings";
+    return false;
+  }
+
+  std::unique_ptr<FractalRenderer> renderer;
+  std::unique_ptr<QOpenGLFramebufferObject> target;
+  if (settings.gpu) {
+    if (!QOpenGLContext::currentContext()) {
+      m_error = "The GPU benchmark needs a current GL context";
+      return false;
+    }
+    initializeOpenGLFunctions();
+
+    renderer = std::make_unique<FractalRenderer>();
+    if (!renderer->initialize()) {
+      m_error = "Failed to initialize the renderer";
+      return false;
+    }
+    target = std::make_unique<QOpenGLFramebufferObject>(settings.size);
+    if (!target->isValid()) {
+      m_error = "Failed to create the target framebuffer";
+      return false;
+    }
+  }
+
+  for (const Location &location : locations) {
+    QString cpuPrecision;
+    const double iterations = effectiveIterations(
+        location.state, settings.size, settings.cpuThreads, cpuPrecision);
+
+    if (settings.gpu) {
+      std::vector<double> frameMs =
+          runGpu(*renderer, *target, location.state, settings);
+      results.push_back(
+          summarize(location.name, "gpu",
+                    PrecisionPolicy::name(renderer->precisionMode()),
+                    std::move(frameMs), iterations));
+    }
+    if (settings.cpu) {
+      results.push_back(summarize(location.name, "cpu", cpuPrecision,
+                                  runCpu(location.state, settings),
+                                  iterations));
+    }
+  }
+  return true;
+}
+
+double BenchmarkSuite::effectiveIterations(const FractalState &state,
+                                           const QSize &size, int threadCount,
+                                           QString &precision) {
+  CpuFractalEngine engine;
+  engine.prepare(state, size);
+  precision = precisionName(engine.precision());
+
+  std::vector<float> data(static_cast<size_t>(size.width()) * size.height() *
+                          2);
+  TileScheduler scheduler(threadCount);
+  scheduler.run(size, TileScheduler::kDefaultTileSize,
+                [&engine, &data](const QRect &tile) {
+                  engine.iterate(tile, data.data());
+                });
+
+  // Sierpinski runs a fixed number of folds per pixel
+  if (!Formula::isEscapeTime(state.fractalType))
+    return 20.0 * size.width() * size.height();
+
+  double iterations = 0.0;
+  for (size_t i = 0; i < data.size(); i += 2)
+    iterations += data[i + 1] > 0.5f
+                      ? std::max(1.0, static_cast<double>(data[i]))
+                      : static_cast<double>(state.maxIterations);
+  return iterations;
+}
+
+std::vector<double> BenchmarkSuite::runGpu(FractalRenderer &renderer,
+                                           QOpenGLFramebufferObject &target,
+                                           const FractalState &state,
+                                           const Settings &settings) {
+  std::vector<double> frameMs;
+  for (int frame = 0; frame < settings.warmupFrames + settings.frames;
+       ++frame) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Time-sliced like on screen, until the whole view is iterated
+    renderer.invalidate();
+    do {
+      renderer.render(state, settings.size, target.handle());
+    } while (renderer.hasPendingWork());
+    glFinish();
+
+    if (frame >= settings.warmupFrames)
+      frameMs.push_back(timer.nsecsElapsed() * 1e-6);
+  }
+  return frameMs;
+}
+
+std::vector<double> BenchmarkSuite::runCpu(const FractalState &state,
+                                           const Settings &settings) {
+  CpuRenderer renderer(settings.cpuThreads);
+
+  std::vector<double> frameMs;
+  for (int frame = 0; frame < settings.warmupFrames + settings.frames;
+       ++frame) {
+    QElapsedTimer timer;
+    timer.start();
+    renderer.render(state, settings.size);
+
+    if (frame >= settings.warmupFrames)
+      frameMs.push_back(timer.nsecsElapsed() * 1e-6);
+  }
+  return frameMs;
+}
+
+BenchmarkSuite::Result
+BenchmarkSuite::summarize(const QString &location, const QString &engine,
+                          const QString &precision,
+                          std::vector<double> frameMs, double iterations) {
+  std::sort(frameMs.begin(), frameMs.end());
+
+  Result result;
+  result.location = location;
+  result.engine = engine;
+  result.precision = precision;
+  result.frames = static_cast<int>(frameMs.size());
+  double total = 0.0;
+  for (double ms : frameMs)
+    total += ms;
+  result.meanMs = total / std::max<size_t>(1, frameMs.size());
+  result.p50Ms = percentile(frameMs, 0.5);
+  result.p99Ms = percentile(frameMs, 0.99);
+  if (result.p50Ms > 0.0)
+    result.gigaIterationsPerSecond = iterations / (result.p50Ms * 1e-3) * 1e-9;
+  return result;
+}
+
+double BenchmarkSuite::percentile(const std::vector<double> &values,
+                                  double q) {
+  if (values.empty())
+    return 0.0;
+  const size_t rank = static_cast<size_t>(std::ceil(q * values.size()));
+  return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+bool BenchmarkSuite::saveBaseline(const QString &path, const QSize &size,
+                                  const std::vector<Result> &results) {
+  m_error.clear();
+  QJsonObject p50;
+  for (const Result &result : results)
+    p50[result.key()] = result.p50Ms;
+
+  QJsonObject root;
+  root["width"] = size.width();
+  root["height"] = size.height();
+  root["p50Ms"] = p50;
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      file.write(QJsonDocument(root).toJson()) < 0) {
+    m_error = QString("Cannot write %1: %2").arg(path, file.errorString());
+    return false;
+  }
+  return true;
+}
+
+bool BenchmarkSuite::loadBaseline(const QString &path, const QSize &size,
+                                  Baseline &baseline) {
+  m_error.clear();
+  baseline.clear();
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    m_error = QString("Cannot read %1: %2").arg(path, file.errorString());
+    return false;
+  }
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+  if (!document.isObject()) {
+    m_error = QString("%1 is not a benchmark baseline").arg(path);
+    return false;
+  }
+
+  const QJsonObject root = document.object();
+  if (root["width"].toInt() != size.width() ||
+      root["height"].toInt() != size.height()) {
+    m_error = QString("%1 was measured at %2x%3")
+                  .arg(path)
+                  .arg(root["width"].toInt())
+                  .arg(root["height"].toInt());
+    return false;
+  }
+
+  const QJsonObject p50 = root["p50Ms"].toObject();
+  for (auto it = p50.begin(); it != p50.end(); ++it)
+    baseline[it.key()] = it.value().toDouble();
+  return true;
+}
+
+QStringList BenchmarkSuite::regressions(const std::vector<Result> &results,
+                                        const Baseline &baseline,
+                                        double tolerance) {
+  QStringList regressed;
+  for (const Result &result : results) {
+    auto it = baseline.find(result.key());
+    if (it == baseline.end())
+      continue;
+    if (result.p50Ms > it->second * (1.0 + tolerance))
+      regressed << QString("%1: p50 %2 ms, baseline %3 ms (+%4 %)")
+                       .arg(result.key())
+                       .arg(result.p50Ms, 0, 'f', 2)
+                       .arg(it->second, 0, 'f', 2)
+                       .arg((result.p50Ms / it->second - 1.0) * 100.0, 0, 'f',
+                            1);
+  }
+  return regressed;
+}
@@ -0,0 +1,126 @@
+#ifndef BENCHMARKSUITE_H
+#define BENCHMARKSUITE_H
+
+#include "core/FractalState.h"
+#include <QOpenGLExtraFunctions>
+#include <QSize>
+#include <QString>
+#include <map>
+#include <vector>
+
+class FractalRenderer;
+class QOpenGLFramebufferObject;
+
+/**
+ * @brief Replays fixed views on the GPU and CPU engines and times them
+ *
+ * Every location is rendered from scratch frames times per engine at a fixed
+ * size and iteration count, after warmup frames that also pay for shader
+ * compiles and the first reference orbit. A GPU frame runs until the
+ * renderer has no pending tiles and the GPU has finished. A CPU frame is a
+ * whole CpuRenderer::render(), reference orbit included.
+ *
+ * Throughput is reported in effective iterations: what a plain escape-time
+ * loop would run for the view, escaped pixels at their escape count and the
+ * rest at maxIterations. Bulb tests, periodicity checks and the boundary
+ * fill skip part of that work, so they show up as higher throughput.
+ *
+ * Results compare against a baseline of p50 frame times. A location
+ * regresses when its p50 exceeds the baseline by more than the tolerance.
+ */
+class BenchmarkSuite : protected QOpenGLExtraFunctions {
+public:
+  struct Location {
+    QString name;
+    FractalState state;
+  };
+
+  struct Settings {
+    QSize size = QSize(1280, 720);
+    int frames = 10;
+    int warmupFrames = 1;
+    bool gpu = true;
+    bool cpu = true;
+    int cpuThreads = 0; // 0 means one per allowed core
+  };
+
+  struct Result {
+    QString location;
+    QString engine;    // "gpu" or "cpu"
+    QString precision; // Mode the view iterated in
+    int frames = 0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double gigaIterationsPerSecond = 0.0; // At the p50 frame time
+
+    // Baseline key, "location/engine"
+    QString key() const { return location + '/' + engine; }
+  };
+
+  // p50 milliseconds by Result::key()
+  using Baseline = std::map<QString, double>;
+
+  BenchmarkSuite();
+
+  /**
+   * @brief Default view, seahorse valley in float and double range, and
+   * perturbation points at 1e-14 and 1e-30
+   */
+  static std::vector<Location> defaultLocations();
+
+  /**
+   * @brief Runs @p locations with @p settings
+   * @return false on failure, see errorString()
+   *
+   * The GPU engine needs a GL context current.
+   */
+  bool run(const std::vector<Location> &locations, const Settings &settings,
+           std::vector<Result> &results);
+
+  // Writes the p50 times of @p results, measured at @p size, as a baseline
+  bool saveBaseline(const QString &path, const QSize &size,
+                    const std::vector<Result> &results);
+
+  // Fails if the baseline was measured at a size other than @p size
+  bool loadBaseline(const QString &path, const QSize &size,
+                    Baseline &baseline);
+
+  /**
+   * @brief Descriptions of every result slower than @p baseline allows
+   * @param tolerance Allowed slowdown, 0.1 for 10 %
+   *
+   * Results without a baseline entry are never regressions.
+   */
+  static QStringList regressions(const std::vector<Result> &results,
+                                 const Baseline &baseline, double tolerance);
+
+  QString errorString() const { return m_error; }
+
+private:
+  /**
+   * @brief Effective iterations of @p state at @p size, see the class comment
+   * @param precision Set to the mode the CPU engine iterates the view in
+   */
+  static double effectiveIterations(const FractalState &state,
+                                    const QSize &size, int threadCount,
+                                    QString &precision);
+
+  std::vector<double> runGpu(FractalRenderer &renderer,
+                             QOpenGLFramebufferObject &target,
+                             const FractalState &state,
+                             const Settings &settings);
+  static std::vector<double> runCpu(const FractalState &state,
+                                    const Settings &settings);
+
+  static Result summarize(const QString &location, const QString &engine,
+                          const QString &precision,
+                          std::vector<double> frameMs, double iterations);
+
+  // Nearest-rank percentile of sorted @p values, @p q in (0, 1]
+  static double percentile(const std::vector<double> &values, double q);
+
+  QString m_error;
+};
+
+#endif // BENCHMARKSUITE_H
@@ -0,0 +1,139 @@
+#include "BenchmarkSuite.h"
+#include <QCommandLineParser>
+#include <QFile>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <QTextStream>
+
+namespace {
+// Exit codes
+constexpr int kPassed = 0;
+constexpr int kRegressed = 1;
+constexpr int kFailed = 2;
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QGuiApplication app(argc, argv);
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Times fixed fractal views on the GPU and CPU engines.");
+  parser.addHelpOption();
+  const QCommandLineOption sizeOption("size", "Frame size.", "WxH",
+                                      "1280x720");
+  const QCommandLineOption framesOption("frames", "Timed frames per view.",
+                                        "count", "10");
+  const QCommandLineOption warmupOption(
+      "warmup", "Untimed frames per view before timing.", "count", "1");
+  const QCommandLineOption threadsOption(
+      "threads", "CPU engine threads, 0 for one per core.", "count", "0");
+  const QCommandLineOption gpuOnlyOption("gpu-only", "Skip the CPU engine.");
+  const QCommandLineOption cpuOnlyOption("cpu-only", "Skip the GPU engine.");
+  const QCommandLineOption baselineOption(
+      "baseline", "Compare with the p50 times in file, record it if missing.",
+      "file");
+  const QCommandLineOption updateOption(
+      "update-baseline", "Overwrite the baseline with this run.");
+  const QCommandLineOption toleranceOption(
+      "tolerance", "Allowed p50 slowdown against the baseline.", "percent",
+      "10");
+  parser.addOptions({sizeOption, framesOption, warmupOption, threadsOption,
+                     gpuOnlyOption, cpuOnlyOption, baselineOption,
+                     updateOption, toleranceOption});
+  parser.process(app);
+
+  BenchmarkSuite::Settings settings;
+  const QString size = parser.value(sizeOption);
+  settings.size = QSize(size.section('x', 0, 0).toInt(),
+                        size.section('x', 1, 1).toInt());
+  settings.frames = parser.value(framesOption).toInt();
+  settings.warmupFrames = parser.value(warmupOption).toInt();
+  settings.cpuThreads = parser.value(threadsOption).toInt();
+  settings.gpu = !parser.isSet(cpuOnlyOption);
+  settings.cpu = !parser.isSet(gpuOnlyOption);
+  const double tolerance = parser.value(toleranceOption).toDouble() / 100.0;
+
+  // Same profile as the application, on an offscreen surface
+  QSurfaceFormat format;
+  format.setVersion(4, 1);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+  QOpenGLContext context;
+  QOffscreenSurface surface;
+  if (settings.gpu) {
+    context.setFormat(format);
+    if (!context.create()) {
+      err << "Failed to create a GL context\n";
+      return kFailed;
+    }
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface)) {
+      err << "Failed to make the GL context current\n";
+      return kFailed;
+    }
+  }
+
+  BenchmarkSuite suite;
+  std::vector<BenchmarkSuite::Result> results;
+  if (!suite.run(BenchmarkSuite::defaultLocations(), settings, results)) {
+    err << suite.errorString() << '\n';
+    return kFailed;
+  }
+
+  out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+             .arg("view", -16)
+             .arg("engine", -6)
+             .arg("precision", -13)
+             .arg("ms/frame", 10)
+             .arg("p50 ms", 10)
+             .arg("p99 ms", 10)
+             .arg("Giter/s", 9);
+  for (const BenchmarkSuite::Result &result : results) {
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg(result.location, -16)
+               .arg(result.engine, -6)
+               .arg(result.precision, -13)
+               .arg(result.meanMs, 10, 'f', 2)
+               .arg(result.p50Ms, 10, 'f', 2)
+               .arg(result.p99Ms, 10, 'f', 2)
+               .arg(result.gigaIterationsPerSecond, 9, 'f', 3);
+  }
+  out.flush();
+
+  if (settings.gpu)
+    context.doneCurrent();
+
+  if (!parser.isSet(baselineOption))
+    return kPassed;
+
+  const QString baselinePath = parser.value(baselineOption);
+  if (parser.isSet(updateOption) || !QFile::exists(baselinePath)) {
+    if (!suite.saveBaseline(baselinePath, settings.size, results)) {
+      err << suite.errorString() << '\n';
+      return kFailed;
+    }
+    out << "Baseline written to " << baselinePath << '\n';
+    return kPassed;
+  }
+
+  BenchmarkSuite::Baseline baseline;
+  if (!suite.loadBaseline(baselinePath, settings.size, baseline)) {
+    err << suite.errorString() << '\n';
+    return kFailed;
+  }
+  const QStringList regressed =
+      BenchmarkSuite::regressions(results, baseline, tolerance);
+  if (regressed.isEmpty()) {
+    out << "No regressions against " << baselinePath << '\n';
+    return kPassed;
+  }
+
+  err << "Regressions against " << baselinePath << ":\n";
+  for (const QString &line : regressed)
+    err << "  " << line << '\n';
+  return kRegressed;
+}
@@ -0,0 +1,322 @@
+#include "BigReal.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+BigReal::BigReal() : m_limbs(kDefaultLimbs, 0u), m_negative(false) {}
+
+BigReal::BigReal(double value, int limbCount)
+    : m_limbs(std::max(limbCount, 2), 0u), m_negative(value < 0.0) {
+  double magnitude = std::fabs(value);
+  if (!std::isfinite(magnitude))
+    magnitude = 0.0;
+
+  // Peel off 32 bits at a time. Scaling by a power of two and subtracting
+  // the floor are both exact in double precision, so no bits are lost.
+  double integerPart = std::floor(magnitude);
+  m_limbs.back() =
+      static_cast<uint32_t>(std::min(integerPart, 4294967295.0));
+  double remainder = magnitude - integerPart;
+
+  for (int i = this->limbCount() - 2; i >= 0 && remainder > 0.0; --i) {
+    remainder = std::ldexp(remainder, 32);
+    double limb = std::floor(remainder);
+    m_limbs[i] = static_cast<uint32_t>(limb);
+    remainder -= limb;
+  }
+
+  normalizeZero();
+}
+
+BigReal BigReal::fromString(const std::string &text, int limbCount,
+                            bool *ok) {
+  BigReal result(0.0, limbCount);
+  if (ok)
+    *ok = false;
+
+  size_t pos = 0;
+  while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+    ++pos;
+
+  bool negative = false;
+  if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+    negative = text[pos] == '-';
+    ++pos;
+  }
+
+  uint64_t integerPart = 0;
+  int digits = 0;
+  while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos]))) {
+    integerPart = integerPart * 10u + static_cast<uint64_t>(text[pos] - '0');
+    if (integerPart > UINT32_MAX)
+      return result;
+    ++digits;
+    ++pos;
+  }
+
+  std::string fraction;
+  if (pos < text.size() && text[pos] == '.') {
+    ++pos;
+    while (pos < text.size() &&
+           std::isdigit(static_cast<unsigned char>(text[pos]))) {
+      fraction.push_back(text[pos]);
+      ++pos;
+    }
+  }
+  digits += static_cast<int>(fraction.size());
+  if (digits == 0)
+    return result;
+
+  int exponent = 0;
+  if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+    ++pos;
+    bool negativeExponent = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+      negativeExponent = text[pos] == '-';
+      ++pos;
+    }
+    // The integer limb holds under 10 decimal digits, leading zeros of the
+    // fraction can take a few more. Downwards every digit is shifted below
+    // the last fraction bit after 10 per limb.
+    const int maxExponent =
+        negativeExponent ? 10 * result.limbCount() + digits
+                         : 10 + static_cast<int>(fraction.size());
+    const size_t exponentStart = pos;
+    while (pos < text.size() &&
+           std::isdigit(static_cast<unsigned char>(text[pos]))) {
+      exponent = exponent * 10 + (text[pos] - '0');
+      if (exponent > maxExponent)
+        return result;
+      ++pos;
+    }
+    if (pos == exponentStart)
+      return result;
+    if (negativeExponent)
+      exponent = -exponent;
+  }
+
+  while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+    ++pos;
+  if (pos != text.size())
+    return result;
+
+  // Horner's scheme from the last digit: f = (digit + f) / 10
+  for (auto it = fraction.rbegin(); it != fraction.rend(); ++it) {
+    result.m_limbs.back() += static_cast<uint32_t>(*it - '0');
+    result.divideSmall(10u);
+  }
+  result.m_limbs.back() = static_cast<uint32_t>(integerPart);
+
+  for (int i = 0; i < exponent; ++i) {
+    if (result.multiplySmall(10u) != 0u)
+      return BigReal(0.0, limbCount);
+  }
+  for (int i = 0; i > exponent; --i)
+    result.divideSmall(10u);
+
+  result.m_negative = negative;
+  result.normalizeZero();
+  if (ok)
+    *ok = true;
+  return result;
+}
+
+int BigReal::limbsForScale(double scale) {
+  double bits = 64.0;
+  if (scale > 0.0 && scale < 1.0)
+    bits += -std::log2(scale);
+  return 1 + std::max(2, static_cast<int>(std::ceil(bits / 32.0)));
+}
+
+std::string BigReal::toString(int digits) const {
+  std::string text = m_negative ? "-" : "";
+  text += std::to_string(m_limbs.back());
+  if (digits <= 0)
+    return text;
+
+  text.push_back('.');
+  BigReal fraction = *this;
+  for (int i = 0; i < digits; ++i) {
+    fraction.m_limbs.back() = 0u;
+    fraction.multiplySmall(10u);
+    text.push_back(static_cast<char>('0' + fraction.m_limbs.back()));
+  }
+  return text;
+}
+
+double BigReal::toDouble() const {
+  const int integerLimb = limbCount() - 1;
+
+  int top = integerLimb;
+  while (top > 0 && m_limbs[top] == 0u)
+    --top;
+
+  // Three limbs carry 96 bits, comfortably more than a double's mantissa
+  double value = 0.0;
+  for (int i = top; i >= 0 && i > top - 3; --i)
+    value += std::ldexp(static_cast<double>(m_limbs[i]),
+                        32 * (i - integerLimb));
+
+  return m_negative ? -value : value;
+}
+
+void BigReal::setLimbCount(int limbCount) {
+  limbCount = std::max(limbCount, 2);
+  int current = this->limbCount();
+  if (limbCount > current) {
+    m_limbs.insert(m_limbs.begin(), limbCount - current, 0u);
+  } else if (limbCount < current) {
+    m_limbs.erase(m_limbs.begin(), m_limbs.begin() + (current - limbCount));
+    normalizeZero();
+  }
+}
+
+bool BigReal::isZero() const {
+  return std::all_of(m_limbs.begin(), m_limbs.end(),
+                     [](uint32_t limb) { return limb == 0u; });
+}
+
+BigReal BigReal::operator-() const {
+  BigReal result = *this;
+  result.m_negative = !m_negative;
+  result.normalizeZero();
+  return result;
+}
+
+BigReal BigReal::operator+(const BigReal &other) const {
+  return addSigned(*this, other, false);
+}
+
+BigReal BigReal::operator-(const BigReal &other) const {
+  return addSigned(*this, other, true);
+}
+
+BigReal BigReal::operator*(const BigReal &other) const {
+  // Multiply at the higher of the two precisions
+  const int n = std::max(limbCount(), other.limbCount());
+  BigReal a = *this;
+  BigReal b = other;
+  a.setLimbCount(n);
+  b.setLimbCount(n);
+
+  // Schoolbook product, 2n limbs. Each operand has n - 1 fraction limbs, so
+  // the product has 2n - 2 and we keep limbs [n - 1, 2n - 2].
+  std::vector<uint32_t> product(2 * n, 0u);
+  for (int i = 0; i < n; ++i) {
+    uint64_t ai = a.m_limbs[i];
+    if (ai == 0u)
+      continue;
+    uint64_t carry = 0;
+    for (int j = 0; j < n; ++j) {
+      uint64_t t = ai * b.m_limbs[j] + product[i + j] + carry;
+      product[i + j] = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+    product[i + n] = static_cast<uint32_t>(carry);
+  }
+
+  BigReal result;
+  result.m_limbs.assign(product.begin() + (n - 1),
+                        product.begin() + (2 * n - 1));
+  result.m_negative = a.m_negative != b.m_negative;
+  result.normalizeZero();
+  return result;
+}
+
+BigReal &BigReal::operator+=(const BigReal &other) {
+  *this = addSigned(*this, other, false);
+  return *this;
+}
+
+BigReal &BigReal::operator-=(const BigReal &other) {
+  *this = addSigned(*this, other, true);
+  return *this;
+}
+
+bool BigReal::operator==(const BigReal &other) const {
+  const int n = std::max(limbCount(), other.limbCount());
+  BigReal a = *this;
+  BigReal b = other;
+  a.setLimbCount(n);
+  b.setLimbCount(n);
+  return a.m_negative == b.m_negative && a.m_limbs == b.m_limbs;
+}
+
+BigReal BigReal::addSigned(const BigReal &lhs, const BigReal &rhs,
+                           bool negateB) {
+  const int n = std::max(lhs.limbCount(), rhs.limbCount());
+  BigReal a = lhs;
+  BigReal b = rhs;
+  a.setLimbCount(n);
+  b.setLimbCount(n);
+
+  bool bNegative = negateB ? !b.m_negative : b.m_negative;
+
+  BigReal result;
+  result.m_limbs.assign(n, 0u);
+
+  if (a.m_negative == bNegative) {
+    uint64_t carry = 0;
+    for (int i = 0; i < n; ++i) {
+      uint64_t t = static_cast<uint64_t>(a.m_limbs[i]) + b.m_limbs[i] + carry;
+      result.m_limbs[i] = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+    result.m_negative = a.m_negative;
+  } else {
+    // Subtract the smaller magnitude from the larger one
+    const BigReal *big = &a;
+    const BigReal *small = &b;
+    bool resultNegative = a.m_negative;
+    if (compareMagnitude(a.m_limbs, b.m_limbs) < 0) {
+      std::swap(big, small);
+      resultNegative = bNegative;
+    }
+
+    int64_t borrow = 0;
+    for (int i = 0; i < n; ++i) {
+      int64_t t = static_cast<int64_t>(big->m_limbs[i]) - small->m_limbs[i] -
+                  borrow;
+      borrow = t < 0 ? 1 : 0;
+      result.m_limbs[i] = static_cast<uint32_t>(t + (borrow << 32));
+    }
+    result.m_negative = resultNegative;
+  }
+
+  result.normalizeZero();
+  return result;
+}
+
+int BigReal::compareMagnitude(const std::vector<uint32_t> &a,
+                              const std::vector<uint32_t> &b) {
+  for (size_t i = a.size(); i-- > 0;) {
+    if (a[i] != b[i])
+      return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+uint32_t BigReal::multiplySmall(uint32_t factor) {
+  uint64_t carry = 0;
+  for (uint32_t &limb : m_limbs) {
+    uint64_t t = static_cast<uint64_t>(limb) * factor + carry;
+    limb = static_cast<uint32_t>(t);
+    carry = t >> 32;
+  }
+  return static_cast<uint32_t>(carry);
+}
+
+void BigReal::divideSmall(uint32_t divisor) {
+  uint64_t remainder = 0;
+  for (size_t i = m_limbs.size(); i-- > 0;) {
+    uint64_t t = (remainder << 32) | m_limbs[i];
+    m_limbs[i] = static_cast<uint32_t>(t / divisor);
+    remainder = t % divisor;
+  }
+}
+
+void BigReal::normalizeZero() {
+  if (m_negative && isZero())
+    m_negative = false;
+}
@@ -0,0 +1,86 @@
+#ifndef BIGREAL_H
+#define BIGREAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Arbitrary-precision signed fixed-point real number
+ *
+ * Stores a sign and a magnitude as 32-bit limbs, least significant first.
+ * The most significant limb is the integer part, every other limb is
+ * fraction, so precision is 32 * (limbCount() - 1) fractional bits.
+ *
+ * Fixed point is sufficient for escape-time fractals because every value
+ * of interest stays inside the bailout radius. It is used for the deep-zoom
+ * view center and the perturbation reference orbit.
+ */
+class BigReal {
+public:
+  static constexpr int kDefaultLimbs = 4;
+
+  BigReal();
+  explicit BigReal(double value, int limbCount = kDefaultLimbs);
+
+  /**
+   * @brief Parses a decimal string such as "-0.743643887037158704752191506"
+   *
+   * Accepts an optional sign, a fractional part and an "e" exponent.
+   * Returns zero and sets @p ok to false if @p text is not such a number
+   * as a whole, or its value, exponent applied, does not fit the integer
+   * limb. Scaling by the exponent costs a pass over the limbs per decimal
+   * digit, so exponents are also bounded to keep untrusted input cheap.
+   */
+  static BigReal fromString(const std::string &text,
+                            int limbCount = kDefaultLimbs, bool *ok = nullptr);
+
+  /**
+   * @brief Returns the number of limbs needed to resolve features at @p scale
+   *
+   * Adds 64 guard bits so rounding in long orbits stays below pixel size.
+   */
+  static int limbsForScale(double scale);
+
+  /**
+   * @brief Formats the value as decimal with @p digits fractional digits
+   */
+  std::string toString(int digits) const;
+
+  double toDouble() const;
+
+  int limbCount() const { return static_cast<int>(m_limbs.size()); }
+
+  /**
+   * @brief Changes precision, padding or truncating the fraction limbs
+   */
+  void setLimbCount(int limbCount);
+
+  bool isZero() const;
+  bool isNegative() const { return m_negative; }
+
+  BigReal operator-() const;
+  BigReal operator+(const BigReal &other) const;
+  BigReal operator-(const BigReal &other) const;
+  BigReal operator*(const BigReal &other) const;
+  BigReal &operator+=(const BigReal &other);
+  BigReal &operator-=(const BigReal &other);
+
+  bool operator==(const BigReal &other) const;
+  bool operator!=(const BigReal &other) const { return !(*this == other); }
+
+private:
+  static BigReal addSigned(const BigReal &a, const BigReal &b, bool negateB);
+  static int compareMagnitude(const std::vector<uint32_t> &a,
+                              const std::vector<uint32_t> &b);
+
+  // Returns the carry out of the integer limb, nonzero on overflow
+  uint32_t multiplySmall(uint32_t factor);
+  void divideSmall(uint32_t divisor);
+  void normalizeZero();
+
+  std::vector<uint32_t> m_limbs; // Least significant first, back() = integer
+  bool m_negative;
+};
+
+#endif // BIGREAL_H
@@ -0,0 +1,24 @@
+#include "Formula.h"
+#include <cstring>
+
+namespace Formula {
+
+namespace {
+// Indexed by Type
+const char *const kNames[kCount] = {
+    "mandelbrot", "julia",      "sierpinski", "burningship",
+    "tricorn",    "multibrot3", "multibrot4", "multibrot5",
+};
+} // namespace
+
+const char *name(int type) { return isValid(type) ? kNames[type] : nullptr; }
+
+int fromName(const char *name) {
+  for (int type = 0; type < kCount; ++type) {
+    if (std::strcmp(kNames[type], name) == 0)
+      return type;
+  }
+  return -1;
+}
+
+} // namespace Formula
@@ -0,0 +1,78 @@
+#ifndef FORMULA_H
+#define FORMULA_H
+
+/**
+ * @brief The fractal formulas FractalState::fractalType selects
+ *
+ * Escape-time formulas iterate z = f(z) + c, where f folds z and raises it
+ * to power():
+ *
+ *   Mandelbrot    z^2, z starting at 0
+ *   Julia         z^2, z starting at the pixel, c fixed
+ *   BurningShip   (|Re z| + i |Im z|)^2
+ *   Tricorn       conj(z)^2
+ *   Multibrot3-5  z^3, z^4, z^5
+ *
+ * Sierpinski is an IFS fold and has none of the escape-time properties.
+ *
+ * The shader and the CPU kernels specialize on the type at compile time:
+ * ShaderManager builds one program per type and the kernels instantiate one
+ * loop per type, so no formula pays for the branches of another and the
+ * quadratic loops stay exactly as they were.
+ */
+namespace Formula {
+
+enum Type {
+  Mandelbrot = 0,
+  Julia = 1,
+  Sierpinski = 2,
+  BurningShip = 3,
+  Tricorn = 4,
+  Multibrot3 = 5,
+  Multibrot4 = 6,
+  Multibrot5 = 7
+};
+
+constexpr int kCount = 8;
+
+constexpr bool isValid(int type) { return type >= 0 && type < kCount; }
+
+constexpr bool isEscapeTime(int type) { return type != Sierpinski; }
+
+// Exponent of z per iteration, 2 for the quadratic formulas
+constexpr int power(int type) {
+  return type >= Multibrot3 && type <= Multibrot5 ? type - Multibrot3 + 3 : 2;
+}
+
+// Plain z^2 + c, the loops every other formula is derived from
+constexpr bool isQuadratic(int type) {
+  return type == Mandelbrot || type == Julia;
+}
+
+/**
+ * @brief True if the set has no holes, so boundary fill may skip the
+ * interior of rectangles with a bounded border
+ *
+ * Holds for the holomorphic formulas. The folds of Burning Ship and the
+ * conjugate of Tricorn break it.
+ */
+constexpr bool hasNoHoles(int type) {
+  return type == Mandelbrot || type == Julia ||
+         (type >= Multibrot3 && type <= Multibrot5);
+}
+
+// Closed-form main cardioid and period-2 bulb, only known for Mandelbrot
+constexpr bool hasBulbTest(int type) { return type == Mandelbrot; }
+
+// SeriesApproximation only models the z^2 + c delta
+constexpr bool hasSeries(int type) { return isQuadratic(type); }
+
+// Name in job files and logs, nullptr if @p type is not valid
+const char *name(int type);
+
+// Type for a name(), -1 if unknown
+int fromName(const char *name);
+
+} // namespace Formula
+
+#endif // FORMULA_H
@@ -0,0 +1,20 @@
+#include "FractalState.h"
+
+void FractalState::translate(double dx, double dy) {
+  const int limbs = BigReal::limbsForScale(zoomSize);
+  deepCenterX += BigReal(dx, limbs);
+  deepCenterY += BigReal(dy, limbs);
+  zoomCenterX = deepCenterX.toDouble();
+  zoomCenterY = deepCenterY.toDouble();
+}
+
+bool FractalState::sameIterationInputs(const FractalState &other) const {
+  return sameIterationParameters(other) && deepCenterX == other.deepCenterX &&
+         deepCenterY == other.deepCenterY;
+}
+
+bool FractalState::sameIterationParameters(const FractalState &other) const {
+  return zoomSize == other.zoomSize && maxIterations == other.maxIterations &&
+         fractalType == other.fractalType && juliaCx == other.juliaCx &&
+         juliaCy == other.juliaCy;
+}
@@ -0,0 +1,49 @@
+#ifndef FRACTALSTATE_H
+#define FRACTALSTATE_H
+
+#include "core/BigReal.h"
+
+/**
+ * @brief Everything that defines one rendered view of a fractal
+ *
+ * Shared by the interactive widget (current and target state for smooth
+ * interpolation) and the renderer.
+ */
+struct FractalState {
+  double zoomCenterX = -0.5;
+  double zoomCenterY = 0.0;
+  double zoomSize = 3.0;
+  int maxIterations = 500;
+  int paletteId = 0;
+  int fractalType = 0; // Formula::Type, 0: Mandelbrot
+  double juliaCx = -0.7269;
+  double juliaCy = 0.1889;
+
+  // Arbitrary-precision center. zoomCenterX/Y mirror it as doubles and
+  // are only exact down to ~1e-16, so deep zooms read these instead.
+  BigReal deepCenterX = BigReal(-0.5);
+  BigReal deepCenterY = BigReal(0.0);
+
+  /**
+   * @brief Moves the center by a fractal-space offset, keeping the double
+   * and arbitrary-precision copies in sync
+   */
+  void translate(double dx, double dy);
+
+  /**
+   * @brief True if both states produce the same iteration buffer
+   *
+   * Coloring-only fields such as paletteId are ignored.
+   */
+  bool sameIterationInputs(const FractalState &other) const;
+
+  /**
+   * @brief Like sameIterationInputs() but ignoring the center
+   *
+   * True if the two states show the same fractal at the same scale, so one
+   * view is a translation of the other.
+   */
+  bool sameIterationParameters(const FractalState &other) const;
+};
+
+#endif // FRACTALSTATE_H
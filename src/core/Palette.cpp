@@ -0,0 +1,140 @@
+#include "Palette.h"
+#include <cmath>
+#include <functional>
+
+namespace Palette {
+
+namespace {
+
+using Function = std::function<void(float t, float *color)>;
+
+// Samples @p function at the texel centers of one row
+Definition sampled(const std::string &name, const Function &function) {
+  Definition palette;
+  palette.name = name;
+  palette.texels.resize(kTextureSize * 4);
+  for (int i = 0; i < kTextureSize; ++i) {
+    float *texel = &palette.texels[4 * i];
+    function((i + 0.5f) / kTextureSize, texel);
+    texel[3] = 1.0f;
+  }
+  return palette;
+}
+
+// Cosine gradient a + b * cos(2 pi (c * t * scale + d)), per component
+Function cosine(float scale, const float (&a)[3], const float (&b)[3],
+                const float (&c)[3], const float (&d)[3]) {
+  return [=](float t, float *color) {
+    for (int i = 0; i < 3; ++i)
+      color[i] = a[i] + b[i] * std::cos(6.28318f * (c[i] * t * scale + d[i]));
+  };
+}
+
+// GLSL mix()
+float mix(float x, float y, float a) { return x * (1.0f - a) + y * a; }
+
+} // namespace
+
+std::vector<Definition> builtIn() {
+  const float half[3] = {0.5f, 0.5f, 0.5f};
+  const float one[3] = {1.0f, 1.0f, 1.0f};
+  const float warmA[3] = {0.8f, 0.5f, 0.4f};
+  const float warmB[3] = {0.2f, 0.4f, 0.2f};
+  const float warmC[3] = {2.0f, 1.0f, 1.0f};
+  const float warmD[3] = {0.00f, 0.25f, 0.25f};
+  const float auroraC[3] = {2.0f, 1.0f, 0.0f};
+  const float auroraD[3] = {0.5f, 0.20f, 0.25f};
+
+  std::vector<Definition> palettes;
+  palettes.push_back(
+      sampled("Ocean", cosine(10.0f, half, half, one, {0.00f, 0.10f, 0.20f})));
+
+  const Function magma =
+      cosine(10.0f, half, half, {1.0f, 1.0f, 0.5f}, {0.8f, 0.9f, 0.3f});
+  palettes.push_back(sampled("Magma", [magma](float t, float *color) {
+    static const float dark[3] = {0.1f, 0.0f, 0.0f};
+    magma(t, color);
+    const float a = std::sin(t * 20.0f) * 0.5f + 0.5f;
+    for (int i = 0; i < 3; ++i)
+      color[i] = mix(dark[i], color[i], a);
+  }));
+
+  palettes.push_back(
+      sampled("Aurora", cosine(15.0f, half, half, auroraC, auroraD)));
+  palettes.push_back(
+      sampled("Amber", cosine(8.0f, warmA, warmB, warmC, warmD)));
+
+  // Ported from generateFractalExtremePalette in script.js, cycles every
+  // 512 iterations at any depth
+  palettes.push_back(fromStops(
+      "Extreme",
+      {{0.00f, 0, 0, 0},       {0.05f, 25, 7, 26},     {0.10f, 9, 1, 47},
+       {0.15f, 4, 4, 73},      {0.20f, 0, 7, 100},     {0.25f, 12, 44, 138},
+       {0.30f, 24, 82, 177},   {0.35f, 57, 125, 209},  {0.40f, 134, 181, 229},
+       {0.45f, 211, 236, 248}, {0.50f, 241, 233, 191}, {0.55f, 248, 201, 95},
+       {0.60f, 255, 170, 0},   {0.65f, 240, 126, 13},  {0.70f, 204, 71, 10},
+       {0.75f, 158, 1, 66},    {0.80f, 110, 0, 95},    {0.85f, 106, 0, 168},
+       {0.90f, 77, 16, 140},   {0.95f, 45, 20, 80},    {1.00f, 0, 0, 0}},
+      512.0f));
+
+  const Function neon = cosine(4.0f, half, half, one, {0.3f, 0.2f, 0.2f});
+  palettes.push_back(sampled("Neon", [neon](float t, float *color) {
+    static const float cyan[3] = {0.0f, 1.0f, 1.0f};
+    neon(t, color);
+    const float a = std::sin(t * 10.0f) * 0.5f + 0.5f;
+    for (int i = 0; i < 3; ++i)
+      color[i] = mix(color[i], cyan[i], a);
+  }));
+
+  const Function golden = cosine(5.0f, warmA, warmB, warmC, warmD);
+  palettes.push_back(sampled("Golden", [golden](float t, float *color) {
+    static const float glow[3] = {0.2f, 0.1f, 0.0f};
+    golden(t, color);
+    for (int i = 0; i < 3; ++i)
+      color[i] += glow[i];
+  }));
+
+  const Function cyber = cosine(6.0f, half, half, auroraC, auroraD);
+  palettes.push_back(sampled("Cyber", [cyber](float t, float *color) {
+    cyber(t, color);
+    for (int i = 0; i < 3; ++i)
+      color[i] = 1.0f - color[i];
+  }));
+
+  palettes.push_back(
+      sampled("Ice", cosine(12.0f, half, half, one, {0.0f, 0.33f, 0.67f})));
+  palettes.push_back(sampled("Forest", cosine(8.0f, {0.2f, 0.7f, 0.4f},
+                                              {0.5f, 0.2f, 0.3f}, one,
+                                              {0.0f, 0.1f, 0.0f})));
+  return palettes;
+}
+
+Definition fromStops(const std::string &name,
+                     const std::vector<ColorStop> &stops, float cycleLength) {
+  Definition palette;
+  palette.name = name;
+  palette.cycleLength = cycleLength;
+  palette.texels.resize(kTextureSize * 4);
+
+  // Texels ascend, so the pair of stops around them only ever moves forward
+  size_t upper = 1;
+  for (int i = 0; i < kTextureSize; ++i) {
+    const float t = (i + 0.5f) / kTextureSize;
+    while (upper + 1 < stops.size() && t > stops[upper].position)
+      ++upper;
+    const ColorStop &a = stops[upper - 1];
+    const ColorStop &b = stops[upper];
+
+    const float localT = (t - a.position) / (b.position - a.position);
+    const float smoothT = localT * localT * (3 - 2 * localT); // Smoothstep
+
+    float *texel = &palette.texels[4 * i];
+    texel[0] = (a.r + (b.r - a.r) * smoothT) / 255.0f;
+    texel[1] = (a.g + (b.g - a.g) * smoothT) / 255.0f;
+    texel[2] = (a.b + (b.b - a.b) * smoothT) / 255.0f;
+    texel[3] = 1.0f;
+  }
+  return palette;
+}
+
+} // namespace Palette
@@ -0,0 +1,57 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Palettes as rows of one texture atlas, shared by the GPU coloring
+ * pass and the CPU colorizer
+ *
+ * Every palette is baked into kTextureSize RGBA float texels, sampled at
+ * texel centers. The coloring pass then only fetches from the palette's
+ * row, so new palettes need no shader change.
+ */
+namespace Palette {
+
+// Texels in one atlas row
+constexpr int kTextureSize = 2048;
+
+// Built-in palettes, IDs 0 to kPaletteCount - 1
+constexpr int kPaletteCount = 10;
+
+// The built-in "Extreme" palette, which also colors Sierpinski
+constexpr int kExtremeId = 4;
+
+// Gradient stop, components 0-255
+struct ColorStop {
+  float position;
+  int r, g, b;
+};
+
+struct Definition {
+  std::string name;
+
+  // 0: the row spans smooth iteration counts from 0 to maxIterations.
+  // Otherwise it repeats every cycleLength iterations.
+  float cycleLength = 0.0f;
+
+  // kTextureSize * 4 floats, RGBA, components nominally 0-1 but not clamped
+  std::vector<float> texels;
+};
+
+// The built-in palettes in ID order, ported from script.js
+std::vector<Definition> builtIn();
+
+/**
+ * @brief Palette from gradient stops, smoothstep between neighbours
+ *
+ * @p stops must be sorted by position and span 0 to 1.
+ */
+Definition fromStops(const std::string &name,
+                     const std::vector<ColorStop> &stops,
+                     float cycleLength = 0.0f);
+
+} // namespace Palette
+
+#endif // PALETTE_H
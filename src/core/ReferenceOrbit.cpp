@@ -0,0 +1,204 @@
+#include "ReferenceOrbit.h"
+#include "Formula.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+namespace {
+// Orbits are computed on several threads
+std::atomic<int> g_nextGeneration{1};
+} // namespace
+
+ReferenceOrbit::ReferenceOrbit()
+    : m_maxIterations(0), m_fractalType(0), m_juliaCx(0.0), m_juliaCy(0.0),
+      m_escaped(false), m_extendable(false), m_generation(0) {}
+
+void ReferenceOrbit::compute(const BigReal &centerX, const BigReal &centerY,
+                             int maxIterations, int fractalType,
+                             double juliaCx, double juliaCy) {
+  m_centerX = centerX;
+  m_centerY = centerY;
+  m_maxIterations = 0;
+  m_fractalType = fractalType;
+  m_juliaCx = juliaCx;
+  m_juliaCy = juliaCy;
+  m_escaped = false;
+  m_extendable = true;
+  m_generation = g_nextGeneration++;
+
+  const int limbs = std::max(centerX.limbCount(), centerY.limbCount());
+  m_centerX.setLimbCount(limbs);
+  m_centerY.setLimbCount(limbs);
+
+  m_zx = BigReal(0.0, limbs);
+  m_zy = BigReal(0.0, limbs);
+  m_cx = m_centerX;
+  m_cy = m_centerY;
+
+  if (fractalType == Formula::Julia) {
+    // Julia: the reference point is the starting z, c is fixed
+    m_zx = m_centerX;
+    m_zy = m_centerY;
+    m_cx = BigReal(juliaCx, limbs);
+    m_cy = BigReal(juliaCy, limbs);
+  }
+
+  m_packed.clear();
+  m_pointsDouble.clear();
+  iterateTo(maxIterations);
+}
+
+bool ReferenceOrbit::extend(int maxIterations) {
+  if (!m_extendable || m_escaped || isEmpty() ||
+      maxIterations <= m_maxIterations)
+    return false;
+  iterateTo(maxIterations);
+  return true;
+}
+
+void ReferenceOrbit::iterateTo(int maxIterations) {
+  const size_t values = 2 * (static_cast<size_t>(maxIterations) + 1);
+  m_packed.reserve(values);
+  m_pointsDouble.reserve(values);
+
+  BigReal &zx = m_zx;
+  BigReal &zy = m_zy;
+  for (int i = length(); i <= maxIterations; ++i) {
+    double x = zx.toDouble();
+    double y = zy.toDouble();
+    pack(x, y);
+    m_pointsDouble.push_back(x);
+    m_pointsDouble.push_back(y);
+
+    // Keep the escaping point so pixels next to the reference escape too
+    if (x * x + y * y > 4.0) {
+      m_escaped = true;
+      break;
+    }
+
+    // The folds of fractal.frag's formulaStep()
+    if (m_fractalType == Formula::BurningShip) {
+      if (zx.isNegative())
+        zx = -zx;
+      if (zy.isNegative())
+        zy = -zy;
+    } else if (m_fractalType == Formula::Tricorn) {
+      zy = -zy;
+    }
+
+    const int power = Formula::power(m_fractalType);
+    if (power == 2) {
+      BigReal zx2 = zx * zx;
+      BigReal zy2 = zy * zy;
+      BigReal zxy = zx * zy;
+
+      zx = zx2 - zy2 + m_cx;
+      zy = zxy + zxy + m_cy;
+    } else {
+      BigReal px = zx;
+      BigReal py = zy;
+      for (int k = 1; k < power; ++k) {
+        BigReal x = px * zx - py * zy;
+        py = px * zy + py * zx;
+        px = std::move(x);
+      }
+      zx = px + m_cx;
+      zy = py + m_cy;
+    }
+  }
+  m_maxIterations = maxIterations;
+}
+
+void ReferenceOrbit::pack(double x, double y) {
+  // Shared exponent of the larger component, the smaller one keeps the
+  // same absolute precision
+  int exponent = 0;
+  if (x != 0.0 || y != 0.0) {
+    int exponentX = 0;
+    int exponentY = 0;
+    std::frexp(x, &exponentX);
+    std::frexp(y, &exponentY);
+    exponent = std::max(x != 0.0 ? exponentX : exponentY,
+                        y != 0.0 ? exponentY : exponentX);
+  }
+  // Units of 2^-23 leave one bit for the sign and one for rounding up to 1
+  const int shift = kMantissaBits - 2 - exponent;
+  const auto mantissaX =
+      static_cast<int32_t>(std::lround(std::ldexp(x, shift)));
+  const auto mantissaY =
+      static_cast<int32_t>(std::lround(std::ldexp(y, shift)));
+
+  const uint32_t mantissaMask = (1u << kMantissaBits) - 1;
+  const uint32_t biased = static_cast<uint32_t>(exponent + kExponentBias);
+  const uint32_t halfBits = 32 - kMantissaBits;
+  const uint32_t halfMask = (1u << halfBits) - 1;
+  m_packed.push_back(static_cast<int32_t>(
+      (static_cast<uint32_t>(mantissaX) & mantissaMask) |
+      ((biased & halfMask) << kMantissaBits)));
+  m_packed.push_back(static_cast<int32_t>(
+      (static_cast<uint32_t>(mantissaY) & mantissaMask) |
+      ((biased >> halfBits) << kMantissaBits)));
+}
+
+void ReferenceOrbit::assign(const BigReal &centerX, const BigReal &centerY,
+                            int maxIterations, int fractalType,
+                            double juliaCx, double juliaCy, bool escaped,
+                            std::vector<double> points) {
+  m_centerX = centerX;
+  m_centerY = centerY;
+  m_maxIterations = maxIterations;
+  m_fractalType = fractalType;
+  m_juliaCx = juliaCx;
+  m_juliaCy = juliaCy;
+  m_escaped = escaped;
+  m_generation = g_nextGeneration++;
+
+  const int limbs = std::max(centerX.limbCount(), centerY.limbCount());
+  m_centerX.setLimbCount(limbs);
+  m_centerY.setLimbCount(limbs);
+
+  // Nothing to continue from
+  m_extendable = false;
+
+  m_pointsDouble = std::move(points);
+  m_packed.clear();
+  m_packed.reserve(m_pointsDouble.size());
+  for (size_t i = 0; i + 1 < m_pointsDouble.size(); i += 2)
+    pack(m_pointsDouble[i], m_pointsDouble[i + 1]);
+}
+
+void ReferenceOrbit::clear() {
+  m_packed.clear();
+  m_pointsDouble.clear();
+  m_extendable = false;
+  m_generation = g_nextGeneration++;
+  m_maxIterations = 0;
+  m_escaped = false;
+}
+
+bool ReferenceOrbit::covers(const FractalState &state) const {
+  return coversView(state) &&
+         (m_escaped || m_maxIterations >= state.maxIterations);
+}
+
+bool ReferenceOrbit::extendsTo(const FractalState &state) const {
+  return m_extendable && !m_escaped && coversView(state);
+}
+
+bool ReferenceOrbit::coversView(const FractalState &state) const {
+  if (isEmpty() || m_fractalType != state.fractalType ||
+      m_juliaCx != state.juliaCx || m_juliaCy != state.juliaCy ||
+      limbCount() < BigReal::limbsForScale(state.zoomSize))
+    return false;
+
+  // Panning is free while the reference stays on screen
+  const double offsetX = (state.deepCenterX - m_centerX).toDouble();
+  const double offsetY = (state.deepCenterY - m_centerY).toDouble();
+  return std::abs(offsetX) <= state.zoomSize &&
+         std::abs(offsetY) <= state.zoomSize;
+}
+
+int ReferenceOrbit::textureHeight() const {
+  return (length() + kTextureWidth - 1) / kTextureWidth;
+}
@@ -0,0 +1,149 @@
+#ifndef REFERENCEORBIT_H
+#define REFERENCEORBIT_H
+
+#include "core/BigReal.h"
+#include "core/FractalState.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief High-precision reference orbit for perturbation rendering
+ *
+ * Iterates z = z^2 + c once per frame region in BigReal arithmetic and keeps
+ * each Z_n rounded to float. The shader then only iterates the per-pixel
+ * offset delta_n = z_n - Z_n in single precision:
+ *
+ *   delta_{n+1} = 2 * Z_n * delta_n + delta_n^2 + delta_c
+ *
+ * For Mandelbrot c is the reference point and Z_0 = 0. For Julia c is the
+ * Julia constant and Z_0 is the reference point, the pixel offset goes into
+ * delta_0 instead of delta_c.
+ *
+ * The GPU copy packs each Z_n as two 25-bit mantissas with a shared 14-bit
+ * exponent in two int32, the size of a float pair but with the exponent
+ * range of double. Points near a nucleus fall below float's 1e-38, and
+ * rebasing in fractal.frag needs them at the scale of the pixel offsets.
+ */
+class ReferenceOrbit {
+public:
+  // Orbit points are laid out row-major in a texture of this width
+  static constexpr int kTextureWidth = 4096;
+
+  // Packed point layout, see packedPoints()
+  static constexpr int kMantissaBits = 25;
+  static constexpr int kExponentBias = 8192;
+
+  ReferenceOrbit();
+
+  /**
+   * @brief Computes the orbit seeded at (centerX, centerY)
+   *
+   * Stops after maxIterations steps or once the reference escapes. The
+   * precision of the iteration is the limb count of the center.
+   */
+  void compute(const BigReal &centerX, const BigReal &centerY,
+               int maxIterations, int fractalType, double juliaCx,
+               double juliaCy);
+
+  /**
+   * @brief Continues a computed orbit up to @p maxIterations steps
+   *
+   * Only appends points, which keeps generation() so consumers can pick up
+   * just the new ones. Returns false without changes if the orbit escaped,
+   * already has that many iterations or came from assign().
+   */
+  bool extend(int maxIterations);
+
+  /**
+   * @brief Takes over an orbit computed elsewhere, e.g. received over the
+   * network
+   *
+   * @p points are the interleaved double (x, y) pairs of pointsDouble().
+   */
+  void assign(const BigReal &centerX, const BigReal &centerY,
+              int maxIterations, int fractalType, double juliaCx,
+              double juliaCy, bool escaped, std::vector<double> points);
+
+  void clear();
+
+  bool isEmpty() const { return m_pointsDouble.empty(); }
+
+  /**
+   * @brief Two int32 per stored Z_n, the layout of the RG32I orbit texture
+   *
+   * Bits 0-24 of each are the x and y mantissa, two's complement in units
+   * of 2^-23, so |mantissa| <= 1. Bits 25-31 of the first hold the low and
+   * of the second the high half of the exponent E + kExponentBias, with
+   * Z_n = mantissa * 2^E.
+   */
+  const std::vector<int32_t> &packedPoints() const { return m_packed; }
+
+  /**
+   * @brief The same orbit in double precision, for CPU-side analysis
+   */
+  const std::vector<double> &pointsDouble() const { return m_pointsDouble; }
+
+  // Number of stored Z_n values
+  int length() const { return static_cast<int>(m_pointsDouble.size() / 2); }
+
+  // Texture rows needed to hold length() points
+  int textureHeight() const;
+
+  // True if the reference left the bailout radius before maxIterations
+  bool escaped() const { return m_escaped; }
+
+  /**
+   * @brief True if the orbit can serve as the reference of @p state
+   *
+   * It must be of the same fractal with at least the limbs and iterations
+   * the view needs, and the reference must lie within one view size of
+   * its center.
+   */
+  bool covers(const FractalState &state) const;
+
+  // True if extend() to the iterations of @p state makes it cover @p state
+  bool extendsTo(const FractalState &state) const;
+
+  const BigReal &centerX() const { return m_centerX; }
+  const BigReal &centerY() const { return m_centerY; }
+  int maxIterations() const { return m_maxIterations; }
+  int fractalType() const { return m_fractalType; }
+  double juliaCx() const { return m_juliaCx; }
+  double juliaCy() const { return m_juliaCy; }
+  int limbCount() const { return m_centerX.limbCount(); }
+
+  // Changes on every compute() or assign(), lets consumers cache derived
+  // data. Unique across orbits, so swapping in another orbit changes it too.
+  int generation() const { return m_generation; }
+
+private:
+  // Same view conditions as covers(), without the iteration count
+  bool coversView(const FractalState &state) const;
+
+  // Stores points until maxIterations steps or the bailout
+  void iterateTo(int maxIterations);
+
+  // Appends the packed form of (x, y)
+  void pack(double x, double y);
+
+  std::vector<int32_t> m_packed;
+  std::vector<double> m_pointsDouble;
+  BigReal m_centerX;
+  BigReal m_centerY;
+  int m_maxIterations;
+  int m_fractalType;
+  double m_juliaCx;
+  double m_juliaCy;
+  bool m_escaped;
+
+  // Where compute() left off, for extend(): the next z and c
+  BigReal m_zx;
+  BigReal m_zy;
+  BigReal m_cx;
+  BigReal m_cy;
+  bool m_extendable;
+
+  int m_generation;
+};
+
+#endif // REFERENCEORBIT_H
@@ -0,0 +1,125 @@
+#include "SeriesApproximation.h"
+#include "Formula.h"
+#include "ReferenceOrbit.h"
+#include <algorithm>
+#include <cmath>
+
+SeriesApproximation::SeriesApproximation()
+    : m_skip(0), m_exponent(0), m_orbitGeneration(-1),
+      m_offsetX(0.0), m_offsetY(0.0), m_viewHeight(0.0), m_aspect(0.0),
+      m_scaleExponent(0), m_maxIterations(0) {}
+
+void SeriesApproximation::compute(const ReferenceOrbit &orbit, double offsetX,
+                                  double offsetY, double viewHeight,
+                                  double aspect, int scaleExponent,
+                                  int maxIterations) {
+  if (computedFor(orbit, offsetX, offsetY, viewHeight, aspect, scaleExponent,
+                  maxIterations))
+    return;
+
+  m_orbitGeneration = orbit.generation();
+  m_offsetX = offsetX;
+  m_offsetY = offsetY;
+  m_viewHeight = viewHeight;
+  m_aspect = aspect;
+  m_scaleExponent = scaleExponent;
+  m_maxIterations = maxIterations;
+
+  m_skip = 0;
+  m_a = m_b = m_c = 0.0;
+  m_exponent = 0;
+
+  // The other formulas start perturbation at iteration 0
+  if (!Formula::hasSeries(orbit.fractalType()))
+    return;
+
+  using Complex = std::complex<double>;
+
+  const std::vector<double> &points = orbit.pointsDouble();
+  const bool julia = orbit.fractalType() == Formula::Julia;
+  const double scale = std::ldexp(1.0, scaleExponent);
+
+  // Probes on the view border, where |u| and so the truncation error peak
+  Complex probeU[kProbeCount];
+  Complex probeDelta[kProbeCount];
+  const double halfWidth = 0.5 * aspect * viewHeight;
+  const double halfHeight = 0.5 * viewHeight;
+  int probe = 0;
+  for (int iy = -1; iy <= 1; ++iy) {
+    for (int ix = -1; ix <= 1; ++ix) {
+      if (ix == 0 && iy == 0)
+        continue;
+      probeU[probe] = Complex((offsetX + ix * halfWidth) / scale,
+                              (offsetY + iy * halfHeight) / scale);
+      probeDelta[probe] = julia ? probeU[probe] * scale : Complex(0.0);
+      ++probe;
+    }
+  }
+
+  // Julia starts with delta_0 = u * scale, Mandelbrot adds it every step
+  Complex a = julia ? Complex(scale) : Complex(0.0);
+  Complex b = 0.0;
+  Complex c = 0.0;
+  const Complex dcTerm = julia ? Complex(0.0) : Complex(scale);
+
+  const int limit = std::min(maxIterations - 1, orbit.length() - 1);
+  for (int n = 0; n < limit; ++n) {
+    const Complex twoZ = 2.0 * Complex(points[2 * n], points[2 * n + 1]);
+    const Complex nextZ(points[2 * n + 2], points[2 * n + 3]);
+
+    Complex nextA = twoZ * a + dcTerm;
+    Complex nextB = twoZ * b + a * a;
+    Complex nextC = twoZ * c + 2.0 * a * b;
+
+    // Step the probes exactly and stop once the series drifts from them
+    bool valid = true;
+    for (int p = 0; p < kProbeCount && valid; ++p) {
+      const Complex u = probeU[p];
+      Complex &delta = probeDelta[p];
+      delta = twoZ * delta + delta * delta + (julia ? Complex(0.0) : u * scale);
+
+      const Complex predicted = ((nextC * u + nextB) * u + nextA) * u;
+      valid = std::abs(predicted - delta) <= kTolerance * std::abs(delta) &&
+              std::norm(nextZ + delta) <= 4.0;
+    }
+    if (!valid)
+      break;
+
+    a = nextA;
+    b = nextB;
+    c = nextC;
+    m_skip = n + 1;
+  }
+
+  if (m_skip == 0)
+    return;
+
+  // Normalize so the shader can hold the coefficients in float
+  double magnitude = std::max(std::abs(a.real()), std::abs(a.imag()));
+  std::frexp(magnitude, &m_exponent);
+  auto normalize = [this](const Complex &z) {
+    return Complex(std::ldexp(z.real(), -m_exponent),
+                   std::ldexp(z.imag(), -m_exponent));
+  };
+  m_a = normalize(a);
+  m_b = normalize(b);
+  m_c = normalize(c);
+}
+
+void SeriesApproximation::clear() {
+  m_skip = 0;
+  m_a = m_b = m_c = 0.0;
+  m_exponent = 0;
+  m_orbitGeneration = -1;
+}
+
+bool SeriesApproximation::computedFor(const ReferenceOrbit &orbit,
+                                      double offsetX, double offsetY,
+                                      double viewHeight, double aspect,
+                                      int scaleExponent,
+                                      int maxIterations) const {
+  return m_orbitGeneration == orbit.generation() && m_offsetX == offsetX &&
+         m_offsetY == offsetY && m_viewHeight == viewHeight &&
+         m_aspect == aspect && m_scaleExponent == scaleExponent &&
+         m_maxIterations == maxIterations;
+}
@@ -0,0 +1,92 @@
+#ifndef SERIESAPPROXIMATION_H
+#define SERIESAPPROXIMATION_H
+
+#include <complex>
+
+class ReferenceOrbit;
+
+/**
+ * @brief Cubic series approximation of the perturbation delta
+ *
+ * Early in the orbit every pixel's delta is a smooth function of its offset
+ * u from the reference, so it can be written as
+ *
+ *   delta_n = a_n * u + b_n * u^2 + c_n * u^3
+ *
+ * with coefficients that depend only on the reference orbit. The shader
+ * evaluates this once and starts iterating at n = skipIterations() instead
+ * of 0.
+ *
+ * u is the pixel offset in units of 2^scaleExponent, the same scaled offset
+ * the perturbation shader works in. This keeps b_n and c_n inside double
+ * range at zooms far below 1e-154. The skip count is validated against
+ * probe points on the view border, where the truncation error is largest.
+ */
+class SeriesApproximation {
+public:
+  SeriesApproximation();
+
+  /**
+   * @brief Computes coefficients and the safe skip count for a view
+   * @param orbit Reference orbit the view is rendered against
+   * @param offsetX,offsetY View center minus reference point
+   * @param viewHeight Fractal-space height of the view (zoomSize)
+   * @param aspect View width / height
+   * @param scaleExponent Exponent e of the u scale, 2^e ~ viewHeight
+   * @param maxIterations Skip count never exceeds maxIterations - 1
+   *
+   * Returns immediately if none of the inputs changed since the last call.
+   * Only models z^2 + c, other formulas get a skip count of 0.
+   */
+  void compute(const ReferenceOrbit &orbit, double offsetX, double offsetY,
+               double viewHeight, double aspect, int scaleExponent,
+               int maxIterations);
+
+  void clear();
+
+  /**
+   * @brief True if the coefficients are those compute() yields for the
+   * inputs
+   *
+   * The orbit is matched by generation, so a series computed elsewhere
+   * against a copy of @p orbit still counts.
+   */
+  bool computedFor(const ReferenceOrbit &orbit, double offsetX,
+                   double offsetY, double viewHeight, double aspect,
+                   int scaleExponent, int maxIterations) const;
+
+  // Iterations every pixel can skip, 0 when the series is not usable
+  int skipIterations() const { return m_skip; }
+
+  /**
+   * @brief Coefficients at the skip point scaled by 2^-exponent()
+   *
+   * Evaluating the series with them yields the delta mantissa; exponent()
+   * is the matching delta exponent.
+   */
+  std::complex<double> a() const { return m_a; }
+  std::complex<double> b() const { return m_b; }
+  std::complex<double> c() const { return m_c; }
+  int exponent() const { return m_exponent; }
+
+private:
+  static constexpr int kProbeCount = 8;
+  static constexpr double kTolerance = 1e-4;
+
+  int m_skip;
+  std::complex<double> m_a;
+  std::complex<double> m_b;
+  std::complex<double> m_c;
+  int m_exponent;
+
+  // Inputs of the last compute(), for change detection
+  int m_orbitGeneration;
+  double m_offsetX;
+  double m_offsetY;
+  double m_viewHeight;
+  double m_aspect;
+  int m_scaleExponent;
+  int m_maxIterations;
+};
+
+#endif // SERIESAPPROXIMATION_H
@@ -0,0 +1,168 @@
+#include "TileStore.h"
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+namespace {
+constexpr uint32_t kRecordMagic = 0x31435446; // "FTC1"
+} // namespace
+
+struct TileStore::RecordHeader {
+  uint32_t magic;
+  uint32_t version;
+  int32_t fractalType;
+  int32_t maxIterations;
+  int32_t level;
+  int32_t x;
+  int32_t y;
+  int32_t reserved;
+  double juliaCx;
+  double juliaCy;
+  uint64_t lastUse;
+  uint64_t padding; // Keeps the texels 16-byte aligned
+};
+
+namespace {
+constexpr qint64 kRecordSize =
+    64 + static_cast<qint64>(TileStore::kTexelFloats) * sizeof(float);
+} // namespace
+
+bool TileKey::operator<(const TileKey &other) const {
+  return std::tie(fractalType, juliaCx, juliaCy, maxIterations, level, x, y) <
+         std::tie(other.fractalType, other.juliaCx, other.juliaCy,
+                  other.maxIterations, other.level, other.x, other.y);
+}
+
+bool TileKey::operator==(const TileKey &other) const {
+  return std::tie(fractalType, juliaCx, juliaCy, maxIterations, level, x, y) ==
+         std::tie(other.fractalType, other.juliaCx, other.juliaCy,
+                  other.maxIterations, other.level, other.x, other.y);
+}
+
+TileStore::TileStore() : m_data(nullptr), m_capacity(0), m_clock(1) {
+  static_assert(sizeof(RecordHeader) == 64, "Record header layout changed");
+}
+
+TileStore::~TileStore() { close(); }
+
+bool TileStore::open(const QString &path, int capacity) {
+  close();
+  if (capacity <= 0) {
+    m_error = "Tile store capacity must be positive";
+    return false;
+  }
+
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::ReadWrite)) {
+    m_error = m_file.errorString();
+    return false;
+  }
+
+  // Sparse on most file systems, untouched records cost no disk space
+  const qint64 fileSize = static_cast<qint64>(capacity) * kRecordSize;
+  if (m_file.size() != fileSize && !m_file.resize(fileSize)) {
+    m_error = m_file.errorString();
+    m_file.close();
+    return false;
+  }
+  m_data = m_file.map(0, fileSize);
+  if (!m_data) {
+    m_error = m_file.errorString();
+    m_file.close();
+    return false;
+  }
+  m_capacity = capacity;
+
+  for (int record = 0; record < m_capacity; ++record) {
+    const RecordHeader *h = header(record);
+    if (h->magic != kRecordMagic || h->version != kFormatVersion) {
+      m_free.push_back(record);
+      continue;
+    }
+    TileKey key;
+    key.fractalType = h->fractalType;
+    key.juliaCx = h->juliaCx;
+    key.juliaCy = h->juliaCy;
+    key.maxIterations = h->maxIterations;
+    key.level = h->level;
+    key.x = h->x;
+    key.y = h->y;
+    m_records[key] = record;
+    m_clock = std::max(m_clock, h->lastUse + 1);
+  }
+  return true;
+}
+
+void TileStore::close() {
+  if (m_data) {
+    m_file.unmap(m_data);
+    m_data = nullptr;
+  }
+  if (m_file.isOpen())
+    m_file.close();
+  m_capacity = 0;
+  m_records.clear();
+  m_free.clear();
+}
+
+bool TileStore::contains(const TileKey &key) const {
+  return m_records.count(key) != 0;
+}
+
+const float *TileStore::find(const TileKey &key) {
+  auto it = m_records.find(key);
+  if (it == m_records.end())
+    return nullptr;
+  header(it->second)->lastUse = m_clock++;
+  return texels(it->second);
+}
+
+void TileStore::store(const TileKey &key, const float *data) {
+  if (!m_data)
+    return;
+
+  int record;
+  auto it = m_records.find(key);
+  if (it != m_records.end()) {
+    record = it->second;
+  } else if (!m_free.empty()) {
+    record = m_free.back();
+    m_free.pop_back();
+  } else {
+    auto oldest = std::min_element(
+        m_records.begin(), m_records.end(), [this](const auto &a, const auto &b) {
+          return header(a.second)->lastUse < header(b.second)->lastUse;
+        });
+    record = oldest->second;
+    m_records.erase(oldest);
+  }
+
+  // Invalid while the texels are written, so an interrupted write leaves
+  // an empty record rather than a corrupt tile
+  RecordHeader *h = header(record);
+  h->magic = 0;
+  std::memcpy(texels(record), data, sizeof(float) * kTexelFloats);
+
+  h->version = kFormatVersion;
+  h->fractalType = key.fractalType;
+  h->maxIterations = key.maxIterations;
+  h->level = key.level;
+  h->x = key.x;
+  h->y = key.y;
+  h->reserved = 0;
+  h->juliaCx = key.juliaCx;
+  h->juliaCy = key.juliaCy;
+  h->lastUse = m_clock++;
+  h->padding = 0;
+  h->magic = kRecordMagic;
+  m_records[key] = record;
+}
+
+TileStore::RecordHeader *TileStore::header(int record) const {
+  return reinterpret_cast<RecordHeader *>(m_data + record * kRecordSize);
+}
+
+float *TileStore::texels(int record) const {
+  return reinterpret_cast<float *>(m_data + record * kRecordSize +
+                                   sizeof(RecordHeader));
+}
@@ -0,0 +1,98 @@
+#ifndef TILESTORE_H
+#define TILESTORE_H
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * @brief Identifies one tile of iteration data in the tile quadtree
+ *
+ * Level 0 tiles span TileStore::kRootSpan fractal units, every level halves
+ * that. Tile (x, y) of a level covers [x, x + 1) * span along each axis,
+ * y pointing up like the iteration buffer.
+ */
+struct TileKey {
+  int fractalType = 0;
+  double juliaCx = 0.0; // Only set for Julia
+  double juliaCy = 0.0;
+  int maxIterations = 0; // Not set for Sierpinski, which ignores it
+  int level = 0;
+  int x = 0;
+  int y = 0;
+
+  bool operator<(const TileKey &other) const;
+  bool operator==(const TileKey &other) const;
+};
+
+/**
+ * @brief On-disk tier of the tile cache, one memory-mapped file
+ *
+ * The file holds a fixed number of records, each a small header with the
+ * key and a use stamp followed by the tile's texels (smooth count and
+ * escaped flag, two floats each). Records are rewritten in place and the
+ * least recently used one is replaced when the file is full, so the file
+ * never grows past its capacity and survives restarts.
+ *
+ * Bump kFormatVersion whenever the meaning of the iteration data changes,
+ * records of older versions are treated as empty.
+ */
+class TileStore {
+public:
+  static constexpr int kTileSize = 256; // Texels along each side
+  static constexpr int kTexelFloats = kTileSize * kTileSize * 2;
+  static constexpr double kRootSpan = 4.0;
+  static constexpr uint32_t kFormatVersion = 1;
+
+  TileStore();
+  ~TileStore();
+
+  /**
+   * @brief Opens or creates the store at @p path with room for @p capacity
+   * tiles
+   *
+   * An existing file is resized to the capacity, keeping the records that
+   * still fit.
+   *
+   * @return false on failure, see errorString()
+   */
+  bool open(const QString &path, int capacity);
+  void close();
+
+  bool isOpen() const { return m_data != nullptr; }
+  int capacity() const { return m_capacity; }
+  int size() const { return static_cast<int>(m_records.size()); }
+  QString errorString() const { return m_error; }
+
+  bool contains(const TileKey &key) const;
+
+  /**
+   * @brief Texels of @p key, kTexelFloats floats, or nullptr if not stored
+   *
+   * Marks the tile as used. The data stays valid until the next store() or
+   * close().
+   */
+  const float *find(const TileKey &key);
+
+  // Stores kTexelFloats floats for @p key, replacing the least recently
+  // used tile if full
+  void store(const TileKey &key, const float *texels);
+
+private:
+  struct RecordHeader;
+
+  RecordHeader *header(int record) const;
+  float *texels(int record) const;
+
+  QFile m_file;
+  unsigned char *m_data;
+  int m_capacity;
+  uint64_t m_clock; // Next use stamp
+  std::map<TileKey, int> m_records;
+  std::vector<int> m_free;
+  QString m_error;
+};
+
+#endif // TILESTORE_H
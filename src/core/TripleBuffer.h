@@ -0,0 +1,58 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+ * @brief Lock-free handoff of the latest value from one thread to another
+ *
+ * One writer fills its buffer and publishes it, one reader picks up the
+ * newest published buffer. Each side owns its buffer exclusively until it
+ * swaps it, through an atomic exchange with a third buffer in the middle,
+ * so neither side ever waits for the other. Values the reader did not pick
+ * up in time are overwritten, which is what both the state snapshots and
+ * the finished frames want.
+ */
+template <class T> class TripleBuffer {
+public:
+  // Writer side: the buffer to fill, the writer's until publish()
+  T &writeBuffer() { return m_buffers[m_write]; }
+
+  // Hands the write buffer to the reader and takes the middle one
+  void publish() {
+    const int previous =
+        m_middle.exchange(m_write | kFresh, std::memory_order_acq_rel);
+    m_write = previous & kIndexMask;
+  }
+
+  /**
+   * @brief Reader side: takes the newest published buffer
+   * @return false if nothing was published since the last call, the read
+   * buffer is unchanged then
+   */
+  bool update() {
+    if (!(m_middle.load(std::memory_order_acquire) & kFresh))
+      return false;
+    const int previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+    m_read = previous & kIndexMask;
+    return true;
+  }
+
+  // Reader side: the buffer update() took last, the reader's until then
+  T &readBuffer() { return m_buffers[m_read]; }
+
+  // Any thread, once both sides have stopped, e.g. for cleanup
+  T *buffers() { return m_buffers; }
+  static constexpr int kBufferCount = 3;
+
+private:
+  static constexpr int kIndexMask = 3;
+  static constexpr int kFresh = 4;
+
+  T m_buffers[kBufferCount];
+  int m_write = 0;
+  std::atomic<int> m_middle{1};
+  int m_read = 2;
+};
+
+#endif // TRIPLEBUFFER_H
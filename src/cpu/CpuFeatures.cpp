@@ -0,0 +1,84 @@
+#include "CpuFeatures.h"
+#include <initializer_list>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+
+#if defined(FRACTONAUT_X86) && defined(_MSC_VER)
+// CPUID only reports the instructions, XCR0 tells if the OS saves the
+// wider registers on context switches
+bool msvcSupports(SimdLevel level) {
+  int info[4];
+  __cpuid(info, 1);
+  const bool osxsave = info[2] & (1 << 27);
+  if (!osxsave)
+    return false;
+  const unsigned long long xcr0 = _xgetbv(0);
+
+  __cpuidex(info, 7, 0);
+  if (level == SimdLevel::Avx2)
+    return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5));
+  return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)); // AVX-512F
+}
+#endif
+
+} // namespace
+
+namespace CpuFeatures {
+
+bool supports(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return true;
+  case SimdLevel::Neon:
+#ifdef FRACTONAUT_ARM64
+    return true; // Part of the AArch64 baseline
+#else
+    return false;
+#endif
+  case SimdLevel::Avx2:
+  case SimdLevel::Avx512:
+#if defined(FRACTONAUT_X86) && defined(_MSC_VER)
+    return msvcSupports(level);
+#elif defined(FRACTONAUT_X86)
+    // The runtime also checks that the OS enabled the register state
+    return level == SimdLevel::Avx2 ? __builtin_cpu_supports("avx2")
+                                    : __builtin_cpu_supports("avx512f");
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+SimdLevel bestSimdLevel() {
+  static const SimdLevel level = []() {
+    for (SimdLevel candidate :
+         {SimdLevel::Avx512, SimdLevel::Avx2, SimdLevel::Neon}) {
+      if (supports(candidate))
+        return candidate;
+    }
+    return SimdLevel::Scalar;
+  }();
+  return level;
+}
+
+const char *simdLevelName(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return "Scalar";
+  case SimdLevel::Neon:
+    return "NEON";
+  case SimdLevel::Avx2:
+    return "AVX2";
+  case SimdLevel::Avx512:
+    return "AVX-512";
+  }
+  return "Unknown";
+}
+
+} // namespace CpuFeatures
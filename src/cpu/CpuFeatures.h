@@ -0,0 +1,33 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+// Target architecture, selects which kernel files have code
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+#define FRACTONAUT_X86 1
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define FRACTONAUT_ARM64 1
+#endif
+
+/**
+ * @brief Vector instruction sets the CPU engine has kernels for
+ *
+ * Ordered by preference within an architecture. Lanes per group are
+ * 16/8/4 floats (8/4/2 doubles) for AVX-512, AVX2 and NEON.
+ */
+enum class SimdLevel { Scalar, Neon, Avx2, Avx512 };
+
+namespace CpuFeatures {
+
+// True if this build has a kernel for @p level and the CPU and OS run it
+bool supports(SimdLevel level);
+
+// Widest supported level, detected once
+SimdLevel bestSimdLevel();
+
+const char *simdLevelName(SimdLevel level);
+
+} // namespace CpuFeatures
+
+#endif // CPUFEATURES_H
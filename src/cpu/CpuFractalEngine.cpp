@@ -0,0 +1,505 @@
+#include "CpuFractalEngine.h"
+#include "core/Formula.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+KernelSet kernelsFor(SimdLevel level) {
+  switch (level) {
+#ifdef FRACTONAUT_X86
+  case SimdLevel::Avx512:
+    return avx512Kernels();
+  case SimdLevel::Avx2:
+    return avx2Kernels();
+#endif
+#ifdef FRACTONAUT_ARM64
+  case SimdLevel::Neon:
+    return neonKernels();
+#endif
+  default:
+    return scalarKernels();
+  }
+}
+
+// Main cardioid or period-2 bulb, with the margin of fractal.frag
+bool inMainBulbs(double cx, double cy) {
+  const double x = cx - 0.25;
+  const double y2 = cy * cy;
+  const double q = x * x + y2;
+  if (q * (q + x) < 0.25 * y2 - 1e-5)
+    return true;
+  const double b = cx + 1.0;
+  return b * b + y2 < 0.0625 - 1e-5;
+}
+
+// diffabs() of fractal.frag, unscaled: |W + w| - |W|, exact where the
+// fold of Burning Ship flips the sign
+double diffabs(double W, double w) {
+  const double s = W + w;
+  if (W >= 0.0)
+    return s >= 0.0 ? w : -(2.0 * W + w);
+  return s > 0.0 ? 2.0 * W + w : -w;
+}
+
+// formulaDelta() of fractal.frag: f(Z + delta) - f(Z), without delta_c
+template <int kType>
+void deltaStep(double zx, double zy, double dx, double dy, double &nextX,
+               double &nextY) {
+  if constexpr (kType == Formula::BurningShip) {
+    nextX = 2.0 * (zx * dx - zy * dy) + (dx * dx - dy * dy);
+    nextY = 2.0 * diffabs(zx * zy, zx * dy + zy * dx + dx * dy);
+  } else if constexpr (kType == Formula::Tricorn) {
+    // conj(2 Z delta + delta^2)
+    nextX = 2.0 * (zx * dx - zy * dy) + (dx * dx - dy * dy);
+    nextY = -(2.0 * (zx * dy + zy * dx) + 2.0 * dx * dy);
+  } else if constexpr (Formula::power(kType) == 2) {
+    // 2 Z delta + delta^2
+    nextX = 2.0 * (zx * dx - zy * dy) + (dx * dx - dy * dy);
+    nextY = 2.0 * (zx * dy + zy * dx) + 2.0 * dx * dy;
+  } else {
+    // delta * sum C(n, k) Z^(n-k) delta^(k-1), by Horner from k = n down
+    constexpr int n = Formula::power(kType);
+    double powersX[n];
+    double powersY[n];
+    powersX[0] = 1.0;
+    powersY[0] = 0.0;
+    for (int k = 1; k < n; ++k) {
+      powersX[k] = powersX[k - 1] * zx - powersY[k - 1] * zy;
+      powersY[k] = powersX[k - 1] * zy + powersY[k - 1] * zx;
+    }
+    double binomial = 1.0;
+    double sumX = 1.0;
+    double sumY = 0.0;
+    for (int k = n - 1; k >= 1; --k) {
+      binomial = binomial * (k + 1) / (n - k);
+      const double x = binomial * powersX[n - k] + (sumX * dx - sumY * dy);
+      sumY = binomial * powersY[n - k] + (sumX * dy + sumY * dx);
+      sumX = x;
+    }
+    nextX = sumX * dx - sumY * dy;
+    nextY = sumX * dy + sumY * dx;
+  }
+}
+
+// GLSL mix()
+float mix(float x, float y, float a) { return x * (1.0f - a) + y * a; }
+
+// Float to UNORM8 as the framebuffer stores it
+unsigned char toUnorm8(float value) {
+  return static_cast<unsigned char>(
+      std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+} // namespace
+
+CpuFractalEngine::CpuFractalEngine()
+    : CpuFractalEngine(CpuFeatures::bestSimdLevel()) {}
+
+CpuFractalEngine::CpuFractalEngine(SimdLevel level)
+    : m_level(CpuFeatures::supports(level) ? level : SimdLevel::Scalar),
+      m_kernels(kernelsFor(m_level)), m_boundaryFill(true),
+      m_palettes(Palette::builtIn()),
+      m_params(), m_precision(Precision::Float) {}
+
+void CpuFractalEngine::prepare(const FractalState &state, const QSize &size) {
+  m_state = state;
+  m_size = size;
+
+  m_params.width = size.width();
+  m_params.height = size.height();
+  m_params.centerX = state.zoomCenterX;
+  m_params.centerY = state.zoomCenterY;
+  m_params.zoomSize = state.zoomSize;
+  m_params.juliaCx = state.juliaCx;
+  m_params.juliaCy = state.juliaCy;
+  m_params.maxIterations = std::min(state.maxIterations, kIterationLimit);
+  m_params.fractalType = state.fractalType;
+
+  // Sierpinski folds the plane a fixed number of times and never needs
+  // more than the direct kernels
+  const bool escapeTime = Formula::isEscapeTime(state.fractalType);
+  if (escapeTime && state.zoomSize < kPerturbationZoomThreshold)
+    m_precision = Precision::Perturbation;
+  else if (state.zoomSize < kFloatZoomThreshold)
+    m_precision = Precision::Double;
+  else
+    m_precision = Precision::Float;
+
+  const double pixelSize = state.zoomSize / std::max(1, size.height());
+  const double periodEpsilon =
+      std::max(kPeriodicityPixelFraction * pixelSize,
+               m_precision == Precision::Float ? kFloatPeriodicityFloor
+                                               : kDoublePeriodicityFloor);
+  m_params.periodEpsilonSq = periodEpsilon * periodEpsilon;
+
+  if (m_precision != Precision::Perturbation)
+    return;
+
+  const bool orbitCurrent =
+      !m_orbit.isEmpty() && m_orbit.centerX() == state.deepCenterX &&
+      m_orbit.centerY() == state.deepCenterY &&
+      m_orbit.maxIterations() == state.maxIterations &&
+      m_orbit.fractalType() == state.fractalType &&
+      m_orbit.juliaCx() == state.juliaCx && m_orbit.juliaCy() == state.juliaCy;
+  if (!orbitCurrent)
+    m_orbit.compute(state.deepCenterX, state.deepCenterY, state.maxIterations,
+                    state.fractalType, state.juliaCx, state.juliaCy);
+
+  // A center outside the set escapes at once and is no usable reference
+  if (m_orbit.length() < 2)
+    m_precision = Precision::Double;
+}
+
+void CpuFractalEngine::iterate(const QRect &region, float *out) const {
+  const QRect clipped = region & QRect(QPoint(0, 0), m_size);
+  if (clipped.isEmpty())
+    return;
+
+  if (m_boundaryFill && Formula::hasNoHoles(m_state.fractalType))
+    fillRegion(clipped, out);
+  else
+    iterateDirect(clipped, out);
+}
+
+void CpuFractalEngine::iterateDirect(const QRect &region, float *out) const {
+  if (m_precision == Precision::Perturbation) {
+    iteratePerturbation(region, out);
+    return;
+  }
+
+  KernelFunction kernel = m_precision == Precision::Float
+                              ? m_kernels.iterateFloat
+                              : m_kernels.iterateDouble;
+  kernel(m_params, region.x(), region.y(), region.width(), region.height(),
+         out);
+  if (Formula::isEscapeTime(m_state.fractalType))
+    smoothEscapeData(region, m_size.width(),
+                     Formula::power(m_state.fractalType), out);
+}
+
+void CpuFractalEngine::fillRegion(const QRect &region, float *out) const {
+  // Pixels neither iterated as a border nor filled yet
+  std::vector<unsigned char> pending(
+      static_cast<size_t>(region.width()) * region.height(), 1);
+  subdivide(region, region, pending, out);
+
+  // Whatever is left runs in row spans as long as possible, so lanes are
+  // not wasted on the ragged leaves of the subdivision
+  for (int y = region.top(); y <= region.bottom(); ++y) {
+    const unsigned char *row =
+        pending.data() + static_cast<size_t>(y - region.top()) * region.width();
+    for (int x = 0; x < region.width();) {
+      if (!row[x]) {
+        ++x;
+        continue;
+      }
+      int end = x;
+      while (end < region.width() && row[end])
+        ++end;
+      iterateDirect(QRect(region.left() + x, y, end - x, 1), out);
+      x = end;
+    }
+  }
+}
+
+void CpuFractalEngine::subdivide(const QRect &rect, const QRect &region,
+                                 std::vector<unsigned char> &pending,
+                                 float *out) const {
+  if (rect.width() < kMinFillSize || rect.height() < kMinFillSize)
+    return;
+
+  auto clear = [&](const QRect &done) {
+    for (int y = done.top(); y <= done.bottom(); ++y)
+      std::fill_n(pending.data() +
+                      static_cast<size_t>(y - region.top()) * region.width() +
+                      (done.left() - region.left()),
+                  done.width(), 0);
+  };
+
+  // Border first: two rows, then the columns between them
+  const int left = rect.left();
+  const int right = rect.right();
+  const int top = rect.top();
+  const int bottom = rect.bottom();
+  const QRect border[] = {QRect(left, top, rect.width(), 1),
+                          QRect(left, bottom, rect.width(), 1),
+                          QRect(left, top + 1, 1, rect.height() - 2),
+                          QRect(right, top + 1, 1, rect.height() - 2)};
+  for (const QRect &side : border) {
+    iterateDirect(side, out);
+    clear(side);
+  }
+
+  const int width = m_size.width();
+  auto escaped = [&](int x, int y) {
+    return out[(static_cast<size_t>(y) * width + x) * 2 + 1] != 0.0f;
+  };
+  int insideCount = 0;
+  for (int x = left; x <= right; ++x)
+    insideCount += !escaped(x, top) + !escaped(x, bottom);
+  for (int y = top + 1; y < bottom; ++y)
+    insideCount += !escaped(left, y) + !escaped(right, y);
+  const int borderCount = 2 * (rect.width() + rect.height()) - 4;
+
+  // Most likely all exterior, where splitting further only adds borders
+  if (insideCount == 0)
+    return;
+
+  const QRect interior = rect.adjusted(1, 1, -1, -1);
+  if (insideCount == borderCount) {
+    for (int y = interior.top(); y <= interior.bottom(); ++y)
+      std::fill_n(out + (static_cast<size_t>(y) * width + interior.left()) * 2,
+                  interior.width() * 2, 0.0f);
+    clear(interior);
+    return;
+  }
+
+  // Quarters of the interior, each starting over with its own border
+  const int midX = interior.left() + interior.width() / 2;
+  const int midY = interior.top() + interior.height() / 2;
+  subdivide(QRect(QPoint(interior.left(), interior.top()),
+                  QPoint(midX - 1, midY - 1)),
+            region, pending, out);
+  subdivide(QRect(QPoint(midX, interior.top()),
+                  QPoint(interior.right(), midY - 1)),
+            region, pending, out);
+  subdivide(QRect(QPoint(interior.left(), midY),
+                  QPoint(midX - 1, interior.bottom())),
+            region, pending, out);
+  subdivide(QRect(QPoint(midX, midY),
+                  QPoint(interior.right(), interior.bottom())),
+            region, pending, out);
+}
+
+void CpuFractalEngine::iteratePerturbation(const QRect &region,
+                                           float *out) const {
+  switch (m_state.fractalType) {
+  case Formula::Julia:
+    return iteratePerturbationFor<Formula::Julia>(region, out);
+  case Formula::BurningShip:
+    return iteratePerturbationFor<Formula::BurningShip>(region, out);
+  case Formula::Tricorn:
+    return iteratePerturbationFor<Formula::Tricorn>(region, out);
+  case Formula::Multibrot3:
+    return iteratePerturbationFor<Formula::Multibrot3>(region, out);
+  case Formula::Multibrot4:
+    return iteratePerturbationFor<Formula::Multibrot4>(region, out);
+  case Formula::Multibrot5:
+    return iteratePerturbationFor<Formula::Multibrot5>(region, out);
+  default:
+    return iteratePerturbationFor<Formula::Mandelbrot>(region, out);
+  }
+}
+
+template <int kType>
+void CpuFractalEngine::iteratePerturbationFor(const QRect &region,
+                                              float *out) const {
+  // Same recurrence as the shader's perturbation branch. Doubles reach
+  // 1e-308, so no exponent scaling or series skip is needed.
+  const std::vector<double> &orbit = m_orbit.pointsDouble();
+  const int orbitLength = m_orbit.length();
+  constexpr bool julia = kType == Formula::Julia;
+  const int width = m_size.width();
+  const double height = m_size.height();
+
+  for (int y = region.top(); y <= region.bottom(); ++y) {
+    const double uvY = (y + 0.5 - 0.5 * height) / height;
+    for (int x = region.left(); x <= region.right(); ++x) {
+      const double uvX = (x + 0.5 - 0.5 * width) / height;
+
+      // Pixel offset from the reference, which is the view center
+      const double dcx = uvX * m_state.zoomSize;
+      const double dcy = uvY * m_state.zoomSize;
+
+      float *pixel = out + (static_cast<size_t>(y) * width + x) * 2;
+      pixel[0] = 0.0f;
+      pixel[1] = 0.0f;
+      if constexpr (Formula::hasBulbTest(kType)) {
+        if (inMainBulbs(m_state.zoomCenterX + dcx, m_state.zoomCenterY + dcy))
+          continue;
+      }
+
+      double dx = julia ? dcx : 0.0;
+      double dy = julia ? dcy : 0.0;
+      int m = 0; // Index into the reference orbit
+      int iterations = 0;
+      double escapeRadius = 0.0;
+
+      // Brent snapshot of the reference and the delta riding on it
+      double periodZx = 1e300, periodZy = 1e300;
+      double periodDx = 0.0, periodDy = 0.0;
+      int checkpoint = 1;
+
+      for (int i = 0; i < m_state.maxIterations; ++i) {
+        const double zx = orbit[2 * m];
+        const double zy = orbit[2 * m + 1];
+
+        // delta' = f(Z + delta) - f(Z) (+ delta_c)
+        double nextX, nextY;
+        deltaStep<kType>(zx, zy, dx, dy, nextX, nextY);
+        if constexpr (!julia) {
+          nextX += dcx;
+          nextY += dcy;
+        }
+        dx = nextX;
+        dy = nextY;
+        ++m;
+
+        const double px = orbit[2 * m] + dx;
+        const double py = orbit[2 * m + 1] + dy;
+        const double r2 = px * px + py * py;
+        if (r2 > 4.0) {
+          iterations = i;
+          escapeRadius = r2;
+          break;
+        }
+
+        const double rx = orbit[2 * m] - periodZx;
+        const double ry = orbit[2 * m + 1] - periodZy;
+        const double ex = dx - periodDx;
+        const double ey = dy - periodDy;
+        if (rx * rx + ry * ry < kReferenceCycleEpsilonSq &&
+            ex * ex + ey * ey <
+                kDeltaCycleEpsilonSq * (periodDx * periodDx + periodDy * periodDy))
+          break;
+        if (i == checkpoint) {
+          periodZx = orbit[2 * m];
+          periodZy = orbit[2 * m + 1];
+          periodDx = dx;
+          periodDy = dy;
+          checkpoint *= 2;
+        }
+
+        // Reference escaped first: continue from Z_0 with the full value.
+        // Rebasing like fractal.frag: continue from Z_0 = 0 once z is
+        // closer to it than to the reference. Not for Julia, as there:
+        // Z_0 is the reference point and Z_m - Z_0 in double is too coarse
+        // for the delta.
+        if (m >= orbitLength - 1) {
+          dx = px - orbit[0];
+          dy = py - orbit[1];
+          m = 0;
+        } else if (!julia && r2 < dx * dx + dy * dy) {
+          dx = px;
+          dy = py;
+          m = 0;
+        }
+      }
+
+      pixel[0] = static_cast<float>(iterations);
+      pixel[1] = static_cast<float>(escapeRadius);
+    }
+  }
+  smoothEscapeData(region, width, Formula::power(kType), out);
+}
+
+void CpuFractalEngine::smoothEscapeData(const QRect &region, int width,
+                                        int power, float *out) {
+  // Evaluated in float like the end of fractal.frag
+  const float powerLog = std::log2(static_cast<float>(power));
+  for (int y = region.top(); y <= region.bottom(); ++y) {
+    float *pixel = out + (static_cast<size_t>(y) * width + region.left()) * 2;
+    for (int x = 0; x < region.width(); ++x, pixel += 2) {
+      const float r2 = pixel[1];
+      if (r2 > 0.0f) {
+        const float logZn = std::log2(r2) / 2.0f;
+        float nu = std::log2(logZn);
+        if (power != 2)
+          nu /= powerLog;
+        pixel[0] = pixel[0] + 1.0f - nu;
+        pixel[1] = 1.0f;
+      } else {
+        pixel[0] = 0.0f;
+        pixel[1] = 0.0f;
+      }
+    }
+  }
+}
+
+void CpuFractalEngine::colorize(const float *iterations, unsigned char *rgb,
+                                int bytesPerLine, const QRect &region) const {
+  const QRect view(QPoint(0, 0), m_size);
+  const QRect clipped = region.isNull() ? view : region & view;
+  const int width = m_size.width();
+  const int height = m_size.height();
+
+  for (int y = clipped.top(); y <= clipped.bottom(); ++y) {
+    // Images are top-down, the iteration buffer bottom-up
+    const float *src = iterations + static_cast<size_t>(y) * width * 2;
+    unsigned char *dst =
+        rgb + static_cast<size_t>(height - 1 - y) * bytesPerLine;
+    for (int x = clipped.left(); x <= clipped.right(); ++x) {
+      float color[3];
+      shade(src + 2 * x, color);
+      dst[3 * x] = toUnorm8(color[0]);
+      dst[3 * x + 1] = toUnorm8(color[1]);
+      dst[3 * x + 2] = toUnorm8(color[2]);
+    }
+  }
+}
+
+QImage CpuFractalEngine::render(const FractalState &state,
+                                const QSize &size) {
+  prepare(state, size);
+  std::vector<float> iterations(static_cast<size_t>(size.width()) *
+                                size.height() * 2);
+  iterate(QRect(QPoint(0, 0), size), iterations.data());
+
+  QImage image(size, QImage::Format_RGB888);
+  colorize(iterations.data(), image.bits(), image.bytesPerLine());
+  return image;
+}
+
+void CpuFractalEngine::setPalettes(std::vector<Palette::Definition> palettes) {
+  if (!palettes.empty())
+    m_palettes = std::move(palettes);
+}
+
+void CpuFractalEngine::shade(const float *data, float *color) const {
+  const int count = static_cast<int>(m_palettes.size());
+  const int paletteId = std::clamp(m_state.paletteId, 0, count - 1);
+
+  // Sierpinski Triangle (Type 2): r holds the orbit trap distance, the
+  // palette ID only shifts the phase into the Extreme row
+  if (m_state.fractalType == 2) {
+    const float t = 0.5f + 0.5f * std::sin(data[0] * 4.0f + paletteId);
+    samplePalette(m_palettes[std::min(Palette::kExtremeId, count - 1)], t,
+                  color);
+
+    // Background black-ish, then inverted completely
+    for (int i = 0; i < 3; ++i)
+      color[i] = 1.0f - (data[1] < 0.5f ? 0.0f : color[i]);
+    return;
+  }
+
+  color[0] = color[1] = color[2] = 0.0f;
+  if (data[1] <= 0.5f)
+    return;
+
+  const Palette::Definition &palette = m_palettes[paletteId];
+  const float smoothI = data[0];
+  float u;
+  if (palette.cycleLength > 0.0f) {
+    // GLSL mod()
+    const float cycle = palette.cycleLength;
+    u = (smoothI - cycle * std::floor(smoothI / cycle)) / cycle;
+  } else {
+    u = smoothI / static_cast<float>(m_state.maxIterations);
+  }
+  samplePalette(palette, u, color);
+}
+
+void CpuFractalEngine::samplePalette(const Palette::Definition &palette,
+                                     float u, float *color) {
+  // Texel centers sit at (i + 0.5) / size, blend the two around u
+  const float position = std::clamp(u * Palette::kTextureSize - 0.5f, 0.0f,
+                                    Palette::kTextureSize - 1.0f);
+  const int first = static_cast<int>(position);
+  const int second = std::min(first + 1, Palette::kTextureSize - 1);
+  const float weight = position - first;
+
+  for (int i = 0; i < 3; ++i)
+    color[i] = mix(palette.texels[4 * first + i],
+                   palette.texels[4 * second + i], weight);
+}
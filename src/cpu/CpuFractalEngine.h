@@ -0,0 +1,159 @@
+#ifndef CPUFRACTALENGINE_H
+#define CPUFRACTALENGINE_H
+
+#include "CpuFeatures.h"
+#include "SimdKernels.h"
+#include "core/FractalState.h"
+#include "core/Palette.h"
+#include "core/ReferenceOrbit.h"
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <vector>
+
+/**
+ * @brief CPU implementation of fractal.frag and colorize.frag
+ *
+ * Renders without a GPU (farm nodes, headless jobs) and serves as a
+ * reference when checking shader changes. The iteration data has the same
+ * layout and meaning as the GL iteration buffer, so the two can be compared
+ * texel by texel.
+ *
+ * The inner loop runs on vector lane groups with per-lane escape masks,
+ * using the widest instruction set the CPU supports. Precision follows the
+ * zoom: float like the shader's low-precision path, native double below
+ * kFloatZoomThreshold, and double perturbation against a BigReal reference
+ * orbit below kPerturbationZoomThreshold.
+ *
+ * prepare() sets up a view, iterate() may then run from several threads on
+ * disjoint regions.
+ */
+class CpuFractalEngine {
+public:
+  enum class Precision { Float, Double, Perturbation };
+
+  // Same switch point as the emulated double path in script.js
+  static constexpr double kFloatZoomThreshold = 1e-3;
+
+  // Below this double runs out of bits between neighbouring pixels
+  static constexpr double kPerturbationZoomThreshold = 1e-12;
+
+  // Loop bound of the shader's direct iteration paths
+  static constexpr int kIterationLimit = 10000;
+
+  // Uses the widest supported instruction set
+  CpuFractalEngine();
+
+  // Forces @p level, falling back to scalar if this CPU lacks it
+  explicit CpuFractalEngine(SimdLevel level);
+
+  SimdLevel simdLevel() const { return m_level; }
+
+  /**
+   * @brief Skips the interior of rectangles whose border stays bounded
+   *
+   * Mariani-Silver subdivision, on by default and used for the formulas
+   * whose sets have no holes (Formula::hasNoHoles()), where a rectangle
+   * whose whole border is inside is inside too. Only filaments thinner than
+   * a pixel slipping through the border can be missed.
+   */
+  void setBoundaryFill(bool enabled) { m_boundaryFill = enabled; }
+  bool boundaryFill() const { return m_boundaryFill; }
+  Precision precision() const { return m_precision; }
+
+  /**
+   * @brief Replaces the palettes paletteId indexes, Palette::builtIn() by
+   * default
+   *
+   * Ignored if @p palettes is empty.
+   */
+  void setPalettes(std::vector<Palette::Definition> palettes);
+  const std::vector<Palette::Definition> &palettes() const {
+    return m_palettes;
+  }
+  QSize size() const { return m_size; }
+
+  /**
+   * @brief Sets up @p state at @p size for iterate() and colorize()
+   *
+   * Computes the reference orbit if the view needs perturbation and it
+   * changed.
+   */
+  void prepare(const FractalState &state, const QSize &size);
+
+  /**
+   * @brief Iterates @p region of the prepared view into @p out
+   *
+   * @p out holds two floats per pixel of the whole view, bottom row first:
+   * smooth iteration count and escaped flag (Sierpinski: trap distance and
+   * inside flag). Safe to call concurrently on disjoint regions.
+   */
+  void iterate(const QRect &region, float *out) const;
+
+  /**
+   * @brief Colors iteration data of the prepared view like colorize.frag
+   *
+   * Writes RGB8, top row first, @p bytesPerLine apart. @p region is in
+   * iteration buffer coordinates like for iterate(), the whole view if
+   * null, so a tile can be iterated and colored in one go.
+   */
+  void colorize(const float *iterations, unsigned char *rgb, int bytesPerLine,
+                const QRect &region = QRect()) const;
+
+  // prepare(), iterate() and colorize() for a whole view
+  QImage render(const FractalState &state, const QSize &size);
+
+private:
+  // Rectangles smaller than this along either side are iterated directly
+  static constexpr int kMinFillSize = 8;
+
+  // Periodicity tolerance as in FractalRenderer: a fraction of a pixel,
+  // above what the arithmetic of each path resolves
+  static constexpr double kPeriodicityPixelFraction = 1e-3;
+  static constexpr double kFloatPeriodicityFloor = 1e-6;
+  static constexpr double kDoublePeriodicityFloor = 1e-14;
+
+  // Perturbation periodicity, squared: the reference returns to within
+  // double resolution and the delta repeats to this relative accuracy
+  static constexpr double kReferenceCycleEpsilonSq = 1e-30;
+  static constexpr double kDeltaCycleEpsilonSq = 1e-10;
+
+  void iterateDirect(const QRect &region, float *out) const;
+  void fillRegion(const QRect &region, float *out) const;
+
+  // Fills or splits @p rect, clearing what it covers in @p pending, one
+  // flag per pixel of @p region
+  void subdivide(const QRect &rect, const QRect &region,
+                 std::vector<unsigned char> &pending, float *out) const;
+  void iteratePerturbation(const QRect &region, float *out) const;
+
+  // iteratePerturbation() for one Formula::Type
+  template <int kType>
+  void iteratePerturbationFor(const QRect &region, float *out) const;
+
+  // Turns kernel output (iteration, |z|^2) into the smooth count of a
+  // formula raising z to @p power
+  static void smoothEscapeData(const QRect &region, int width, int power,
+                               float *out);
+
+  // One pixel of colorize.frag's shade(), components in [0, 1]
+  void shade(const float *data, float *color) const;
+
+  // GL_LINEAR, GL_CLAMP_TO_EDGE lookup in one palette atlas row
+  static void samplePalette(const Palette::Definition &palette, float u,
+                            float *color);
+
+  SimdLevel m_level;
+  KernelSet m_kernels;
+  bool m_boundaryFill;
+  std::vector<Palette::Definition> m_palettes;
+
+  // The prepared view
+  FractalState m_state;
+  QSize m_size;
+  KernelParams m_params;
+  Precision m_precision;
+  ReferenceOrbit m_orbit;
+};
+
+#endif // CPUFRACTALENGINE_H
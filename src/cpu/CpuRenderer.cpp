@@ -0,0 +1,58 @@
+#include "CpuRenderer.h"
+
+CpuRenderer::CpuRenderer(int threadCount, int tileSize)
+    : m_scheduler(threadCount), m_tileSize(tileSize) {}
+
+CpuRenderer::~CpuRenderer() { cancel(); }
+
+QImage CpuRenderer::render(const FractalState &state, const QSize &size) {
+  std::shared_ptr<Frame> frame = createFrame(state, size);
+  m_scheduler.run(size, m_tileSize,
+                  [frame](const QRect &tile) { renderTile(*frame, tile); });
+  return frame->image;
+}
+
+void CpuRenderer::renderAsync(const FractalState &state, const QSize &size,
+                              FrameCallback finished) {
+  QMutexLocker locker(&m_mutex);
+  if (m_pending)
+    m_pending->cancel();
+
+  std::shared_ptr<Frame> frame = createFrame(state, size);
+  m_pending = m_scheduler.submit(
+      size, m_tileSize,
+      [frame](const QRect &tile) { renderTile(*frame, tile); },
+      [frame, finished]() {
+        if (finished)
+          finished(frame->image);
+      });
+}
+
+void CpuRenderer::cancel() {
+  QMutexLocker locker(&m_mutex);
+  if (m_pending) {
+    m_pending->cancel();
+    m_pending.reset();
+  }
+}
+
+std::shared_ptr<CpuRenderer::Frame>
+CpuRenderer::createFrame(const FractalState &state, const QSize &size) const {
+  auto engine = std::make_shared<CpuFractalEngine>(m_engine.simdLevel());
+  engine->prepare(state, size);
+
+  auto frame = std::make_shared<Frame>();
+  frame->engine = engine;
+  frame->iterations.resize(static_cast<size_t>(size.width()) * size.height() *
+                           2);
+  frame->image = QImage(size, QImage::Format_RGB888);
+  // Detach once here, the workers then only write through the pointer
+  frame->pixels = frame->image.bits();
+  return frame;
+}
+
+void CpuRenderer::renderTile(Frame &frame, const QRect &tile) {
+  frame.engine->iterate(tile, frame.iterations.data());
+  frame.engine->colorize(frame.iterations.data(), frame.pixels,
+                         frame.image.bytesPerLine(), tile);
+}
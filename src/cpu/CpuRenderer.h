@@ -0,0 +1,68 @@
+#ifndef CPURENDERER_H
+#define CPURENDERER_H
+
+#include "CpuFractalEngine.h"
+#include "TileScheduler.h"
+#include <QImage>
+#include <QMutex>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Multi-threaded CPU rendering of whole views
+ *
+ * A view is prepared once on the calling thread, which includes computing
+ * the reference orbit. Its tiles are then iterated and colored on a
+ * TileScheduler. Each tile writes only its own pixels, so the workers share
+ * nothing but the read-only engine.
+ */
+class CpuRenderer {
+public:
+  using FrameCallback = std::function<void(const QImage &image)>;
+
+  // 0 threads means one per allowed core
+  explicit CpuRenderer(int threadCount = 0,
+                       int tileSize = TileScheduler::kDefaultTileSize);
+  ~CpuRenderer();
+
+  int threadCount() const { return m_scheduler.threadCount(); }
+  SimdLevel simdLevel() const { return m_engine.simdLevel(); }
+
+  // Renders @p state and blocks until the image is complete
+  QImage render(const FractalState &state, const QSize &size);
+
+  /**
+   * @brief Starts rendering @p state and returns at once
+   *
+   * Cancels the previous request first, so following a moving target
+   * state never queues stale frames. @p finished runs on a worker thread
+   * and is never called for a cancelled request.
+   */
+  void renderAsync(const FractalState &state, const QSize &size,
+                   FrameCallback finished);
+
+  // Cancels the pending renderAsync() request, if any
+  void cancel();
+
+private:
+  // Everything the tiles of one frame share
+  struct Frame {
+    std::shared_ptr<const CpuFractalEngine> engine;
+    std::vector<float> iterations;
+    QImage image;
+    unsigned char *pixels = nullptr;
+  };
+
+  std::shared_ptr<Frame> createFrame(const FractalState &state,
+                                     const QSize &size) const;
+  static void renderTile(Frame &frame, const QRect &tile);
+
+  CpuFractalEngine m_engine; // Only used to report the instruction set
+  TileScheduler m_scheduler;
+  int m_tileSize;
+
+  QMutex m_mutex;
+  std::shared_ptr<TileJob> m_pending;
+};
+
+#endif // CPURENDERER_H
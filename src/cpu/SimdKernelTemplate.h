@@ -0,0 +1,292 @@
+#ifndef SIMDKERNELTEMPLATE_H
+#define SIMDKERNELTEMPLATE_H
+
+#include "SimdKernels.h"
+#include "core/Formula.h"
+#include <cstddef>
+
+/**
+ * @brief The iteration kernel, written once against a lane-group type
+ *
+ * Only included by the per-instruction-set kernel files. B wraps one vector
+ * register type and provides:
+ *
+ *   Scalar, Vec, Mask, kLanes
+ *   set1, iota (0, 1, 2, ...), add, sub, mul, div, min, sqrt, abs
+ *   greater, maskAnd, maskOr, maskAndNot (a & ~b), allTrue, any,
+ *   select (m ? a : b)
+ *   store (unaligned)
+ *
+ * The operations and their order follow fractal.frag term by term, without
+ * fused multiply-adds, so every instruction set produces the same bits and
+ * the float kernel tracks the shader's float path. GPU results still differ
+ * in the last bits where the driver approximates log2 or contracts terms.
+ *
+ * This file must stay free of inline non-template code, including standard
+ * library helpers: every instantiation is compiled with its own instruction
+ * set flags, and the linker may pick any copy of a shared inline function.
+ * The Formula traits are constexpr and only evaluated at compile time.
+ *
+ * Each formula gets its own instantiation of the loops, so the formula is
+ * chosen once per call and Mandelbrot runs the same code as before the
+ * other formulas existed.
+ */
+template <class B> struct SimdKernel {
+  using T = typename B::Scalar;
+  using Vec = typename B::Vec;
+  using Mask = typename B::Mask;
+
+  static void iterate(const KernelParams &params, int x0, int y0, int w,
+                      int h, float *out) {
+    switch (params.fractalType) {
+    case Formula::Julia:
+      return iterateFormula<Formula::Julia>(params, x0, y0, w, h, out);
+    case Formula::Sierpinski:
+      return iterateFormula<Formula::Sierpinski>(params, x0, y0, w, h, out);
+    case Formula::BurningShip:
+      return iterateFormula<Formula::BurningShip>(params, x0, y0, w, h, out);
+    case Formula::Tricorn:
+      return iterateFormula<Formula::Tricorn>(params, x0, y0, w, h, out);
+    case Formula::Multibrot3:
+      return iterateFormula<Formula::Multibrot3>(params, x0, y0, w, h, out);
+    case Formula::Multibrot4:
+      return iterateFormula<Formula::Multibrot4>(params, x0, y0, w, h, out);
+    case Formula::Multibrot5:
+      return iterateFormula<Formula::Multibrot5>(params, x0, y0, w, h, out);
+    default:
+      return iterateFormula<Formula::Mandelbrot>(params, x0, y0, w, h, out);
+    }
+  }
+
+  template <int kType>
+  static void iterateFormula(const KernelParams &params, int x0, int y0,
+                             int w, int h, float *out) {
+    const Vec halfWidth = B::set1(T(0.5) * T(params.width));
+    const Vec halfHeight = B::set1(T(0.5) * T(params.height));
+    const Vec viewHeight = B::set1(T(params.height));
+    const Vec centerX = B::set1(T(params.centerX));
+    const Vec centerY = B::set1(T(params.centerY));
+    const Vec zoomSize = B::set1(T(params.zoomSize));
+
+    // gl_FragCoord is the pixel center
+    const Vec laneCenters = B::add(B::iota(), B::set1(T(0.5)));
+
+    T first[B::kLanes];
+    T second[B::kLanes];
+
+    // A single column runs its lanes down the column instead, so a border
+    // strip never keeps lanes busy with pixels outside the region
+    if (w == 1 && h > 1) {
+      const Vec uvX = B::div(
+          B::sub(B::add(B::set1(T(x0)), B::set1(T(0.5))), halfWidth),
+          viewHeight);
+      const Vec pointX = B::add(centerX, B::mul(uvX, zoomSize));
+
+      for (int y = y0; y < y0 + h; y += B::kLanes) {
+        const Vec uvY = B::div(
+            B::sub(B::add(B::set1(T(y)), laneCenters), halfHeight),
+            viewHeight);
+        const Vec pointY = B::add(centerY, B::mul(uvY, zoomSize));
+
+        Vec a, b;
+        if constexpr (kType == Formula::Sierpinski)
+          sierpinski(pointX, pointY, a, b);
+        else
+          escape<kType>(params, pointX, pointY, a, b);
+        B::store(first, a);
+        B::store(second, b);
+
+        const int count = y0 + h - y < B::kLanes ? y0 + h - y : B::kLanes;
+        for (int lane = 0; lane < count; ++lane) {
+          float *dst =
+              out + (static_cast<size_t>(y + lane) * params.width + x0) * 2;
+          dst[0] = static_cast<float>(first[lane]);
+          dst[1] = static_cast<float>(second[lane]);
+        }
+      }
+      return;
+    }
+
+    for (int y = y0; y < y0 + h; ++y) {
+      const Vec uvY = B::div(
+          B::sub(B::add(B::set1(T(y)), B::set1(T(0.5))), halfHeight),
+          viewHeight);
+      const Vec pointY = B::add(centerY, B::mul(uvY, zoomSize));
+
+      for (int x = x0; x < x0 + w; x += B::kLanes) {
+        const Vec uvX = B::div(
+            B::sub(B::add(B::set1(T(x)), laneCenters), halfWidth),
+            viewHeight);
+        const Vec pointX = B::add(centerX, B::mul(uvX, zoomSize));
+
+        Vec a, b;
+        if constexpr (kType == Formula::Sierpinski)
+          sierpinski(pointX, pointY, a, b);
+        else
+          escape<kType>(params, pointX, pointY, a, b);
+        B::store(first, a);
+        B::store(second, b);
+
+        // The last group of a row may stick out of the region
+        const int count = x0 + w - x < B::kLanes ? x0 + w - x : B::kLanes;
+        float *dst =
+            out + (static_cast<size_t>(y) * params.width + x) * 2;
+        for (int lane = 0; lane < count; ++lane) {
+          dst[2 * lane] = static_cast<float>(first[lane]);
+          dst[2 * lane + 1] = static_cast<float>(second[lane]);
+        }
+      }
+    }
+  }
+
+  // Escape-time formulas, escape iteration and |z|^2 per lane
+  template <int kType>
+  static void escape(const KernelParams &params, Vec pointX, Vec pointY,
+                     Vec &iterations, Vec &escapeRadius) {
+    constexpr bool julia = kType == Formula::Julia;
+    const Vec zero = B::set1(T(0));
+    const Vec two = B::set1(T(2));
+    const Vec four = B::set1(T(4));
+
+    // Julia: c is constant, z is pixel. Mandelbrot: z starts at 0.
+    const Vec cx = julia ? B::set1(T(params.juliaCx)) : pointX;
+    const Vec cy = julia ? B::set1(T(params.juliaCy)) : pointY;
+    Vec zx = julia ? pointX : zero;
+    Vec zy = julia ? pointY : zero;
+
+    iterations = zero;
+    escapeRadius = zero;
+    Mask active = B::allTrue();
+
+    // Lanes in the main cardioid or period-2 bulb are done before starting
+    if constexpr (Formula::hasBulbTest(kType)) {
+      active = B::maskAndNot(active, inMainBulbs(cx, cy));
+      if (!B::any(active))
+        return;
+    }
+
+    // Brent snapshot, refreshed at power-of-two iterations
+    const Vec periodEpsilonSq = B::set1(T(params.periodEpsilonSq));
+    Vec periodX = zx;
+    Vec periodY = zy;
+    int checkpoint = 1;
+
+    // Escaped lanes keep iterating until the whole group is done, their
+    // results are already latched and later compares are masked off
+    for (int i = 0; i < params.maxIterations; ++i) {
+      Vec x, y;
+      if constexpr (Formula::isQuadratic(kType)) {
+        x = B::add(B::sub(B::mul(zx, zx), B::mul(zy, zy)), cx);
+        y = B::add(B::mul(B::mul(two, zx), zy), cy);
+      } else {
+        step<kType>(zx, zy, x, y);
+        x = B::add(x, cx);
+        y = B::add(y, cy);
+      }
+      const Vec r2 = B::add(B::mul(x, x), B::mul(y, y));
+
+      const Mask escaped = B::maskAnd(active, B::greater(r2, four));
+      if (B::any(escaped)) {
+        iterations = B::select(escaped, B::set1(T(i)), iterations);
+        escapeRadius = B::select(escaped, r2, escapeRadius);
+        active = B::maskAndNot(active, escaped);
+        if (!B::any(active))
+          break;
+      }
+      zx = x;
+      zy = y;
+
+      // Cycling lanes never escape and keep their (0, 0) result
+      const Vec dx = B::sub(zx, periodX);
+      const Vec dy = B::sub(zy, periodY);
+      const Mask cycling = B::maskAnd(
+          active, B::greater(periodEpsilonSq,
+                             B::add(B::mul(dx, dx), B::mul(dy, dy))));
+      if (B::any(cycling)) {
+        active = B::maskAndNot(active, cycling);
+        if (!B::any(active))
+          break;
+      }
+      if (i == checkpoint) {
+        periodX = zx;
+        periodY = zy;
+        checkpoint *= 2;
+      }
+    }
+  }
+
+  // formulaStep() of fractal.frag: f(z) without c
+  template <int kType>
+  static void step(Vec zx, Vec zy, Vec &x, Vec &y) {
+    if constexpr (kType == Formula::BurningShip) {
+      zx = B::abs(zx);
+      zy = B::abs(zy);
+    } else if constexpr (kType == Formula::Tricorn) {
+      zy = B::sub(B::set1(T(0)), zy);
+    }
+
+    if constexpr (Formula::power(kType) == 2) {
+      x = B::sub(B::mul(zx, zx), B::mul(zy, zy));
+      y = B::mul(B::mul(B::set1(T(2)), zx), zy);
+    } else {
+      x = zx;
+      y = zy;
+      for (int k = 1; k < Formula::power(kType); ++k) {
+        const Vec px = B::sub(B::mul(x, zx), B::mul(y, zy));
+        y = B::add(B::mul(x, zy), B::mul(y, zx));
+        x = px;
+      }
+    }
+  }
+
+  // inMainBulbs() of fractal.frag, with the same margin
+  static Mask inMainBulbs(Vec cx, Vec cy) {
+    const Vec margin = B::set1(T(1e-5));
+    const Vec quarter = B::set1(T(0.25));
+    const Vec x = B::sub(cx, quarter);
+    const Vec y2 = B::mul(cy, cy);
+    const Vec q = B::add(B::mul(x, x), y2);
+    const Mask cardioid =
+        B::greater(B::sub(B::mul(quarter, y2), margin),
+                   B::mul(q, B::add(q, x)));
+
+    const Vec b = B::add(cx, B::set1(T(1)));
+    const Mask bulb = B::greater(B::sub(B::set1(T(0.0625)), margin),
+                                 B::add(B::mul(b, b), y2));
+    return B::maskOr(cardioid, bulb);
+  }
+
+  // Sierpinski (2), orbit trap distance and inside flag per lane
+  static void sierpinski(Vec pointX, Vec pointY, Vec &trap, Vec &inside) {
+    const Vec zero = B::set1(T(0));
+    const Vec one = B::set1(T(1));
+    const Vec two = B::set1(T(2));
+
+    // Center correction
+    Vec zx = pointX;
+    Vec zy = B::sub(pointY, B::set1(T(0.25)));
+    Vec d = B::set1(T(1000));
+
+    for (int i = 0; i < 20; ++i) { // Fixed iterations for IFS
+      zx = B::abs(zx);
+      zy = B::abs(zy);
+
+      const Mask fold = B::greater(B::add(zx, zy), one);
+      const Vec foldedX = B::sub(one, zy);
+      const Vec foldedY = B::sub(one, zx);
+      zx = B::select(fold, foldedX, zx);
+      zy = B::select(fold, foldedY, zy);
+
+      zx = B::mul(zx, two);
+      zy = B::sub(B::mul(zy, two), one); // Standard Gasket shift
+
+      d = B::min(d, B::sqrt(B::add(B::mul(zx, zx), B::mul(zy, zy))));
+    }
+
+    const Vec length = B::sqrt(B::add(B::mul(zx, zx), B::mul(zy, zy)));
+    trap = d;
+    inside = B::select(B::greater(length, two), zero, one);
+  }
+};
+
+#endif // SIMDKERNELTEMPLATE_H
@@ -0,0 +1,54 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+/**
+ * @brief View parameters as the iteration kernels see them
+ *
+ * Pixel (x, y) maps to fractal space exactly as gl_FragCoord does in
+ * fractal.frag, with y counted from the bottom row.
+ */
+struct KernelParams {
+  int width;
+  int height;
+  double centerX;
+  double centerY;
+  double zoomSize;
+  double juliaCx;
+  double juliaCy;
+  int maxIterations;
+  int fractalType; // Formula::Type
+
+  // Squared distance at which an orbit returning to its Brent snapshot
+  // counts as cycling, like u_periodEpsilonSq
+  double periodEpsilonSq;
+};
+
+/**
+ * @brief Iterates the pixels [x0, x0 + w) x [y0, y0 + h) of a view
+ *
+ * @p out holds two floats per view pixel, row-major from the bottom row like
+ * the GL iteration buffer. Escape-time pixels get the escape
+ * iteration and |z|^2 at escape, or (0, 0) if they stay bounded; the smooth
+ * count is derived from these by the caller. Sierpinski pixels get their
+ * final (trap distance, inside) data. A region one pixel wide runs the lanes
+ * down the column, with the same results.
+ */
+using KernelFunction = void (*)(const KernelParams &params, int x0, int y0,
+                                int w, int h, float *out);
+
+// Kernels of one instruction set, in single and double precision
+struct KernelSet {
+  KernelFunction iterateFloat;
+  KernelFunction iterateDouble;
+  int floatLanes;
+  int doubleLanes;
+};
+
+// Each is defined in its own file, compiled for that instruction set. Only
+// the ones matching the target architecture exist.
+KernelSet scalarKernels();
+KernelSet avx2Kernels();
+KernelSet avx512Kernels();
+KernelSet neonKernels();
+
+#endif // SIMDKERNELS_H
@@ -0,0 +1,67 @@
+#include "CpuFeatures.h"
+
+#ifdef FRACTONAUT_X86
+#include "SimdKernelTemplate.h"
+#include <immintrin.h>
+
+namespace {
+
+// 8 floats per group. Compiled with AVX2 enabled, see CMakeLists.txt.
+struct Avx2Float {
+  using Scalar = float;
+  using Vec = __m256;
+  using Mask = __m256;
+  static constexpr int kLanes = 8;
+
+  static Vec set1(float value) { return _mm256_set1_ps(value); }
+  static Vec iota() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+  static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+  static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+  static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+  static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+  static Vec sqrt(Vec a) { return _mm256_sqrt_ps(a); }
+  static Vec abs(Vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+  static Mask greater(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+  static Mask maskAnd(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+  static Mask maskOr(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+  static Mask maskAndNot(Mask a, Mask b) { return _mm256_andnot_ps(b, a); }
+  static Mask allTrue() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+  static bool any(Mask m) { return _mm256_movemask_ps(m) != 0; }
+  static Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+  static void store(float *dst, Vec v) { _mm256_storeu_ps(dst, v); }
+};
+
+// 4 doubles per group
+struct Avx2Double {
+  using Scalar = double;
+  using Vec = __m256d;
+  using Mask = __m256d;
+  static constexpr int kLanes = 4;
+
+  static Vec set1(double value) { return _mm256_set1_pd(value); }
+  static Vec iota() { return _mm256_setr_pd(0, 1, 2, 3); }
+  static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+  static Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+  static Vec div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+  static Vec min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+  static Vec sqrt(Vec a) { return _mm256_sqrt_pd(a); }
+  static Vec abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+  static Mask greater(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+  static Mask maskAnd(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+  static Mask maskOr(Mask a, Mask b) { return _mm256_or_pd(a, b); }
+  static Mask maskAndNot(Mask a, Mask b) { return _mm256_andnot_pd(b, a); }
+  static Mask allTrue() { return _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); }
+  static bool any(Mask m) { return _mm256_movemask_pd(m) != 0; }
+  static Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b, a, m); }
+  static void store(double *dst, Vec v) { _mm256_storeu_pd(dst, v); }
+};
+
+} // namespace
+
+KernelSet avx2Kernels() {
+  return {SimdKernel<Avx2Float>::iterate, SimdKernel<Avx2Double>::iterate,
+          Avx2Float::kLanes, Avx2Double::kLanes};
+}
+#endif // FRACTONAUT_X86
@@ -0,0 +1,75 @@
+#include "CpuFeatures.h"
+
+#ifdef FRACTONAUT_X86
+#include "SimdKernelTemplate.h"
+#include <immintrin.h>
+
+namespace {
+
+// 16 floats per group with k-register masks. Compiled with AVX-512F
+// enabled, see CMakeLists.txt.
+struct Avx512Float {
+  using Scalar = float;
+  using Vec = __m512;
+  using Mask = __mmask16;
+  static constexpr int kLanes = 16;
+
+  static Vec set1(float value) { return _mm512_set1_ps(value); }
+  static Vec iota() {
+    return _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                          15);
+  }
+  static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+  static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+  static Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+  static Vec min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+  static Vec sqrt(Vec a) { return _mm512_sqrt_ps(a); }
+  static Vec abs(Vec a) { return _mm512_abs_ps(a); }
+  static Mask greater(Vec a, Vec b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+  }
+  static Mask maskAnd(Mask a, Mask b) { return a & b; }
+  static Mask maskOr(Mask a, Mask b) { return a | b; }
+  static Mask maskAndNot(Mask a, Mask b) { return a & ~b; }
+  static Mask allTrue() { return 0xffff; }
+  static bool any(Mask m) { return m != 0; }
+  static Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+  static void store(float *dst, Vec v) { _mm512_storeu_ps(dst, v); }
+};
+
+// 8 doubles per group
+struct Avx512Double {
+  using Scalar = double;
+  using Vec = __m512d;
+  using Mask = __mmask8;
+  static constexpr int kLanes = 8;
+
+  static Vec set1(double value) { return _mm512_set1_pd(value); }
+  static Vec iota() { return _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7); }
+  static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+  static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+  static Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+  static Vec div(Vec a, Vec b) { return _mm512_div_pd(a, b); }
+  static Vec min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+  static Vec sqrt(Vec a) { return _mm512_sqrt_pd(a); }
+  static Vec abs(Vec a) { return _mm512_abs_pd(a); }
+  static Mask greater(Vec a, Vec b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ);
+  }
+  static Mask maskAnd(Mask a, Mask b) { return a & b; }
+  static Mask maskOr(Mask a, Mask b) { return a | b; }
+  static Mask maskAndNot(Mask a, Mask b) { return a & ~b; }
+  static Mask allTrue() { return 0xff; }
+  static bool any(Mask m) { return m != 0; }
+  static Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_pd(m, b, a); }
+  static void store(double *dst, Vec v) { _mm512_storeu_pd(dst, v); }
+};
+
+} // namespace
+
+KernelSet avx512Kernels() {
+  return {SimdKernel<Avx512Float>::iterate, SimdKernel<Avx512Double>::iterate,
+          Avx512Float::kLanes, Avx512Double::kLanes};
+}
+#endif // FRACTONAUT_X86
@@ -0,0 +1,73 @@
+#include "CpuFeatures.h"
+
+#ifdef FRACTONAUT_ARM64
+#include "SimdKernelTemplate.h"
+#include <arm_neon.h>
+
+namespace {
+
+// 4 floats per group, NEON is part of the AArch64 baseline
+struct NeonFloat {
+  using Scalar = float;
+  using Vec = float32x4_t;
+  using Mask = uint32x4_t;
+  static constexpr int kLanes = 4;
+
+  static Vec set1(float value) { return vdupq_n_f32(value); }
+  static Vec iota() {
+    static const float kIndices[4] = {0, 1, 2, 3};
+    return vld1q_f32(kIndices);
+  }
+  static Vec add(Vec a, Vec b) { return vaddq_f32(a, b); }
+  static Vec sub(Vec a, Vec b) { return vsubq_f32(a, b); }
+  static Vec mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+  static Vec div(Vec a, Vec b) { return vdivq_f32(a, b); }
+  static Vec min(Vec a, Vec b) { return vminq_f32(a, b); }
+  static Vec sqrt(Vec a) { return vsqrtq_f32(a); }
+  static Vec abs(Vec a) { return vabsq_f32(a); }
+  static Mask greater(Vec a, Vec b) { return vcgtq_f32(a, b); }
+  static Mask maskAnd(Mask a, Mask b) { return vandq_u32(a, b); }
+  static Mask maskOr(Mask a, Mask b) { return vorrq_u32(a, b); }
+  static Mask maskAndNot(Mask a, Mask b) { return vbicq_u32(a, b); }
+  static Mask allTrue() { return vdupq_n_u32(~0u); }
+  static bool any(Mask m) { return vmaxvq_u32(m) != 0; }
+  static Vec select(Mask m, Vec a, Vec b) { return vbslq_f32(m, a, b); }
+  static void store(float *dst, Vec v) { vst1q_f32(dst, v); }
+};
+
+// 2 doubles per group
+struct NeonDouble {
+  using Scalar = double;
+  using Vec = float64x2_t;
+  using Mask = uint64x2_t;
+  static constexpr int kLanes = 2;
+
+  static Vec set1(double value) { return vdupq_n_f64(value); }
+  static Vec iota() {
+    static const double kIndices[2] = {0, 1};
+    return vld1q_f64(kIndices);
+  }
+  static Vec add(Vec a, Vec b) { return vaddq_f64(a, b); }
+  static Vec sub(Vec a, Vec b) { return vsubq_f64(a, b); }
+  static Vec mul(Vec a, Vec b) { return vmulq_f64(a, b); }
+  static Vec div(Vec a, Vec b) { return vdivq_f64(a, b); }
+  static Vec min(Vec a, Vec b) { return vminq_f64(a, b); }
+  static Vec sqrt(Vec a) { return vsqrtq_f64(a); }
+  static Vec abs(Vec a) { return vabsq_f64(a); }
+  static Mask greater(Vec a, Vec b) { return vcgtq_f64(a, b); }
+  static Mask maskAnd(Mask a, Mask b) { return vandq_u64(a, b); }
+  static Mask maskOr(Mask a, Mask b) { return vorrq_u64(a, b); }
+  static Mask maskAndNot(Mask a, Mask b) { return vbicq_u64(a, b); }
+  static Mask allTrue() { return vdupq_n_u64(~0ull); }
+  static bool any(Mask m) { return vmaxvq_u32(vreinterpretq_u32_u64(m)) != 0; }
+  static Vec select(Mask m, Vec a, Vec b) { return vbslq_f64(m, a, b); }
+  static void store(double *dst, Vec v) { vst1q_f64(dst, v); }
+};
+
+} // namespace
+
+KernelSet neonKernels() {
+  return {SimdKernel<NeonFloat>::iterate, SimdKernel<NeonDouble>::iterate,
+          NeonFloat::kLanes, NeonDouble::kLanes};
+}
+#endif // FRACTONAUT_ARM64
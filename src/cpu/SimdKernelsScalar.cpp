@@ -0,0 +1,37 @@
+#include "SimdKernelTemplate.h"
+#include <cmath>
+
+namespace {
+
+// One pixel per group, the fallback and the reference for the others
+template <class T> struct ScalarBatch {
+  using Scalar = T;
+  using Vec = T;
+  using Mask = bool;
+  static constexpr int kLanes = 1;
+
+  static Vec set1(T value) { return value; }
+  static Vec iota() { return T(0); }
+  static Vec add(Vec a, Vec b) { return a + b; }
+  static Vec sub(Vec a, Vec b) { return a - b; }
+  static Vec mul(Vec a, Vec b) { return a * b; }
+  static Vec div(Vec a, Vec b) { return a / b; }
+  static Vec min(Vec a, Vec b) { return b < a ? b : a; }
+  static Vec sqrt(Vec a) { return std::sqrt(a); }
+  static Vec abs(Vec a) { return std::fabs(a); }
+  static Mask greater(Vec a, Vec b) { return a > b; }
+  static Mask maskAnd(Mask a, Mask b) { return a && b; }
+  static Mask maskOr(Mask a, Mask b) { return a || b; }
+  static Mask maskAndNot(Mask a, Mask b) { return a && !b; }
+  static Mask allTrue() { return true; }
+  static bool any(Mask m) { return m; }
+  static Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+  static void store(T *dst, Vec v) { *dst = v; }
+};
+
+} // namespace
+
+KernelSet scalarKernels() {
+  return {SimdKernel<ScalarBatch<float>>::iterate,
+          SimdKernel<ScalarBatch<double>>::iterate, 1, 1};
+}
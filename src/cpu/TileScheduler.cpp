@@ -0,0 +1,268 @@
+#include "TileScheduler.h"
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+struct Core {
+  int cpu;
+  int node;
+};
+
+#ifdef __linux__
+// Parses a sysfs CPU list such as "0-15,32-47"
+std::vector<int> parseCpuList(const QString &text) {
+  std::vector<int> cpus;
+  for (const QString &range : text.trimmed().split(',')) {
+    if (range.isEmpty())
+      continue;
+    const int dash = range.indexOf("-");
+    const int first = range.left(dash < 0 ? range.size() : dash).toInt();
+    const int last = dash < 0 ? first : range.mid(dash + 1).toInt();
+    for (int cpu = first; cpu <= last; ++cpu)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+#endif
+
+/**
+ * Cores this process may run on, interleaved across NUMA nodes so that any
+ * prefix of the list uses every node's memory bandwidth.
+ */
+std::vector<Core> allowedCores() {
+  std::vector<Core> cores;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return cores;
+
+  std::vector<int> nodeOf(CPU_SETSIZE, 0);
+  int nodeCount = 1;
+  QDir nodes("/sys/devices/system/node");
+  for (const QString &entry : nodes.entryList(QStringList() << "node*")) {
+    QFile list(nodes.filePath(entry + "/cpulist"));
+    if (!list.open(QIODevice::ReadOnly))
+      continue;
+    const int node = entry.mid(4).toInt();
+    nodeCount = std::max(nodeCount, node + 1);
+    for (int cpu : parseCpuList(QString::fromLatin1(list.readAll())))
+      if (cpu >= 0 && cpu < CPU_SETSIZE)
+        nodeOf[cpu] = node;
+  }
+
+  std::vector<std::vector<int>> perNode(nodeCount);
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &allowed))
+      perNode[nodeOf[cpu]].push_back(cpu);
+
+  for (size_t i = 0;; ++i) {
+    bool added = false;
+    for (int node = 0; node < nodeCount; ++node) {
+      if (i < perNode[node].size()) {
+        cores.push_back({perNode[node][i], node});
+        added = true;
+      }
+    }
+    if (!added)
+      break;
+  }
+#endif
+  return cores;
+}
+
+void pinCurrentThread(int cpu) {
+#ifdef __linux__
+  if (cpu < 0)
+    return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+} // namespace
+
+bool TileJob::isFinished() const {
+  QMutexLocker locker(&m_mutex);
+  return m_finishedFlag;
+}
+
+void TileJob::wait() {
+  QMutexLocker locker(&m_mutex);
+  while (!m_finishedFlag)
+    m_done.wait(&m_mutex);
+}
+
+TileScheduler::TileScheduler(int threadCount) {
+  std::vector<Core> cores = allowedCores();
+  if (threadCount <= 0)
+    threadCount = cores.empty() ? QThread::idealThreadCount()
+                                : static_cast<int>(cores.size());
+  threadCount = std::max(1, threadCount);
+
+  for (int i = 0; i < threadCount; ++i) {
+    auto worker = std::make_unique<Worker>();
+    if (!cores.empty()) {
+      const Core &core = cores[i % cores.size()];
+      worker->cpu = core.cpu;
+      worker->node = core.node;
+    }
+    m_workers.push_back(std::move(worker));
+  }
+
+  // Steal from neighbours on the same node before crossing the interconnect
+  for (int i = 0; i < threadCount; ++i) {
+    std::vector<int> &victims = m_workers[i]->victims;
+    for (int pass = 0; pass < 2; ++pass) {
+      for (int step = 1; step < threadCount; ++step) {
+        const int other = (i + step) % threadCount;
+        const bool sameNode = m_workers[other]->node == m_workers[i]->node;
+        if (sameNode == (pass == 0))
+          victims.push_back(other);
+      }
+    }
+  }
+
+  for (int i = 0; i < threadCount; ++i) {
+    m_workers[i]->thread.reset(QThread::create([this, i]() { workerLoop(i); }));
+    m_workers[i]->thread->start();
+  }
+}
+
+TileScheduler::~TileScheduler() {
+  // Queued tiles are skipped, only tiles already running delay shutdown
+  for (auto &worker : m_workers) {
+    QMutexLocker locker(&worker->mutex);
+    for (Task &task : worker->tasks)
+      task.job->cancel();
+  }
+  {
+    QMutexLocker locker(&m_sleepMutex);
+    m_stopping = true;
+    m_workAvailable.wakeAll();
+  }
+  for (auto &worker : m_workers)
+    worker->thread->wait();
+}
+
+std::shared_ptr<TileJob> TileScheduler::submit(const QSize &size,
+                                               int tileSize,
+                                               TileFunction function,
+                                               std::function<void()> finished) {
+  auto job = std::make_shared<TileJob>();
+  job->m_function = std::move(function);
+  job->m_finished = std::move(finished);
+
+  tileSize = std::max(1, tileSize);
+  std::vector<QRect> tiles;
+  for (int y = 0; y < size.height(); y += tileSize)
+    for (int x = 0; x < size.width(); x += tileSize)
+      tiles.push_back(QRect(x, y, std::min(tileSize, size.width() - x),
+                            std::min(tileSize, size.height() - y)));
+
+  const int tileCount = static_cast<int>(tiles.size());
+  job->m_tileCount = tileCount;
+  job->m_remaining = tileCount;
+  if (tileCount == 0) {
+    if (job->m_finished)
+      job->m_finished();
+    job->m_finishedFlag = true;
+    return job;
+  }
+
+  // Contiguous runs keep each worker's tiles, and the output memory it
+  // touches, together. Stealing evens out the cost afterwards.
+  const int workerCount = threadCount();
+  for (int w = 0; w < workerCount; ++w) {
+    const int begin = static_cast<int>(
+        static_cast<long long>(tileCount) * w / workerCount);
+    const int end = static_cast<int>(
+        static_cast<long long>(tileCount) * (w + 1) / workerCount);
+    QMutexLocker locker(&m_workers[w]->mutex);
+    for (int t = begin; t < end; ++t)
+      m_workers[w]->tasks.push_back({tiles[t], job});
+  }
+
+  QMutexLocker locker(&m_sleepMutex);
+  m_queuedTasks += tileCount;
+  m_workAvailable.wakeAll();
+  return job;
+}
+
+bool TileScheduler::run(const QSize &size, int tileSize,
+                        TileFunction function) {
+  std::shared_ptr<TileJob> job = submit(size, tileSize, std::move(function));
+  job->wait();
+  return !job->isCancelled();
+}
+
+void TileScheduler::workerLoop(int index) {
+  pinCurrentThread(m_workers[index]->cpu);
+
+  for (;;) {
+    Task task;
+    if (takeTask(index, task)) {
+      runTask(task);
+      continue;
+    }
+
+    // The count is updated under this mutex, so no wakeup is lost
+    QMutexLocker locker(&m_sleepMutex);
+    while (m_queuedTasks == 0 && !m_stopping)
+      m_workAvailable.wait(&m_sleepMutex);
+    if (m_stopping && m_queuedTasks == 0)
+      return;
+  }
+}
+
+bool TileScheduler::takeTask(int index, Task &task) {
+  Worker &self = *m_workers[index];
+  {
+    QMutexLocker locker(&self.mutex);
+    if (!self.tasks.empty()) {
+      task = std::move(self.tasks.front());
+      self.tasks.pop_front();
+      --m_queuedTasks;
+      return true;
+    }
+  }
+
+  // Steal from the far end, away from where the owner is working
+  for (int victim : self.victims) {
+    Worker &other = *m_workers[victim];
+    QMutexLocker locker(&other.mutex);
+    if (!other.tasks.empty()) {
+      task = std::move(other.tasks.back());
+      other.tasks.pop_back();
+      --m_queuedTasks;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TileScheduler::runTask(Task &task) {
+  TileJob &job = *task.job;
+  if (!job.m_cancelled)
+    job.m_function(task.tile);
+
+  if (--job.m_remaining == 0) {
+    if (!job.m_cancelled && job.m_finished)
+      job.m_finished();
+    QMutexLocker locker(&job.m_mutex);
+    job.m_finishedFlag = true;
+    job.m_done.wakeAll();
+  }
+  task.job.reset();
+}
@@ -0,0 +1,117 @@
+#ifndef TILESCHEDULER_H
+#define TILESCHEDULER_H
+
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class TileScheduler;
+
+/**
+ * @brief Handle to one batch of tiles submitted to a TileScheduler
+ *
+ * Cancelling skips every tile that has not started yet, so a stale frame
+ * stops costing CPU time after at most one tile per worker.
+ */
+class TileJob {
+public:
+  void cancel() { m_cancelled = true; }
+  bool isCancelled() const { return m_cancelled; }
+
+  // True once every tile has run or been skipped
+  bool isFinished() const;
+  void wait();
+
+  int tileCount() const { return m_tileCount; }
+  int tilesDone() const { return m_tileCount - m_remaining; }
+
+private:
+  friend class TileScheduler;
+
+  std::function<void(const QRect &tile)> m_function;
+  std::function<void()> m_finished;
+  std::atomic<bool> m_cancelled{false};
+  std::atomic<int> m_remaining{0};
+  int m_tileCount = 0;
+
+  mutable QMutex m_mutex;
+  QWaitCondition m_done;
+  bool m_finishedFlag = false;
+};
+
+/**
+ * @brief Persistent worker pool running tiles with work stealing
+ *
+ * A job is cut into small square tiles that are dealt out in contiguous
+ * runs, one deque per worker. Owners take tiles from the front of their own
+ * deque. An idle worker steals from the back of another deque, trying the
+ * workers on its own NUMA node first. Escape-time cost varies by orders of
+ * magnitude between tiles, and stealing keeps every core busy until the
+ * last tile.
+ *
+ * On Linux each worker is pinned to one allowed core, spread across NUMA
+ * nodes in the order the kernel reports them. Other platforms leave
+ * placement to the OS.
+ */
+class TileScheduler {
+public:
+  static constexpr int kDefaultTileSize = 32;
+
+  using TileFunction = std::function<void(const QRect &tile)>;
+
+  // 0 threads means one per allowed core
+  explicit TileScheduler(int threadCount = 0);
+  ~TileScheduler();
+
+  int threadCount() const { return static_cast<int>(m_workers.size()); }
+
+  /**
+   * @brief Queues @p size cut into @p tileSize tiles
+   *
+   * @p function runs once per tile on a worker thread, concurrently for
+   * different tiles. @p finished runs on the worker completing the last
+   * tile, unless the job was cancelled.
+   */
+  std::shared_ptr<TileJob> submit(const QSize &size, int tileSize,
+                                  TileFunction function,
+                                  std::function<void()> finished = {});
+
+  // submit() and wait(), false if the job was cancelled meanwhile
+  bool run(const QSize &size, int tileSize, TileFunction function);
+
+private:
+  struct Task {
+    QRect tile;
+    std::shared_ptr<TileJob> job;
+  };
+
+  struct Worker {
+    QMutex mutex;
+    std::deque<Task> tasks;
+    int node = 0;
+    int cpu = -1;                 // Core to pin to, -1 for none
+    std::vector<int> victims;     // Steal order, own node first
+    std::unique_ptr<QThread> thread;
+  };
+
+  void workerLoop(int index);
+  bool takeTask(int index, Task &task);
+  static void runTask(Task &task);
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  // Sleeping workers wait here until tasks are queued
+  QMutex m_sleepMutex;
+  QWaitCondition m_workAvailable;
+  std::atomic<int> m_queuedTasks{0};
+  bool m_stopping = false;
+};
+
+#endif // TILESCHEDULER_H
@@ -0,0 +1,146 @@
+#include "PosterExporter.h"
+#include "StreamingImageWriter.h"
+#include "rendering/AsyncReadback.h"
+#include "rendering/FractalRenderer.h"
+#include <QOpenGLFramebufferObject>
+#include <algorithm>
+#include <vector>
+
+PosterExporter::PosterExporter() {}
+
+bool PosterExporter::exportImage(const FractalState &state,
+                                 const Settings &settings, const QString &path,
+                                 const ProgressCallback &progress) {
+  m_error.clear();
+  initializeOpenGLFunctions();
+
+  const int width = settings.width;
+  const int height = settings.height;
+  if (width <= 0 || height <= 0) {
+    m_error = "Invalid poster size";
+    return false;
+  }
+
+  // The iteration buffer is twice the tile when supersampling
+  GLint maxTextureSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  const int sampleFactor = settings.supersample ? 2 : 1;
+  const int tileSize =
+      std::max(1, std::min(settings.tileSize, maxTextureSize / sampleFactor));
+
+  FractalRenderer renderer;
+  if (!renderer.initialize()) {
+    m_error = "Failed to initialize the renderer";
+    return false;
+  }
+  renderer.setResolutionScale(static_cast<float>(sampleFactor));
+
+  QOpenGLFramebufferObject tileTarget(tileSize, tileSize);
+  if (!tileTarget.isValid()) {
+    m_error = "Failed to create the tile framebuffer";
+    return false;
+  }
+
+  StreamingImageWriter writer;
+  if (!writer.open(path, width, height,
+                   StreamingImageWriter::formatForPath(path))) {
+    m_error = writer.errorString();
+    return false;
+  }
+
+  const int columns = (width + tileSize - 1) / tileSize;
+  const int bands = (height + tileSize - 1) / tileSize;
+  const int tileCount = columns * bands;
+  int tilesDone = 0;
+
+  std::vector<unsigned char> bandPixels(static_cast<size_t>(width) *
+                                        tileSize * 3);
+
+  // Tiles are read back while the next one renders. The worker drops
+  // alpha, flips the rows to top-down order and places the tile, tagged
+  // with its column, in the band.
+  AsyncReadback readback([&bandPixels, width, tileSize](
+                             const AsyncReadback::Frame &frame) {
+    const size_t column = static_cast<size_t>(frame.tag);
+    for (int row = 0; row < frame.height; ++row) {
+      const unsigned char *src =
+          frame.pixels +
+          static_cast<size_t>(frame.height - 1 - row) * frame.stride;
+      unsigned char *dst =
+          bandPixels.data() +
+          (static_cast<size_t>(row) * width + column * tileSize) * 3;
+      for (int x = 0; x < frame.width; ++x) {
+        dst[3 * x] = src[4 * x];
+        dst[3 * x + 1] = src[4 * x + 1];
+        dst[3 * x + 2] = src[4 * x + 2];
+      }
+    }
+  });
+  if (!readback.initialize()) {
+    m_error = "Failed to initialize the readback";
+    writer.abort();
+    return false;
+  }
+
+  for (int band = 0; band < bands; ++band) {
+    const int bandRows = std::min(tileSize, height - band * tileSize);
+
+    for (int column = 0; column < columns; ++column) {
+      const int tileColumns = std::min(tileSize, width - column * tileSize);
+      FractalState tile =
+          tileState(state, width, height, tileSize, column, band);
+
+      // Time-sliced like on screen, so no single draw trips the watchdog
+      do {
+        renderer.render(tile, QSize(tileSize, tileSize), tileTarget.handle());
+      } while (renderer.hasPendingWork());
+
+      // Only the top bandRows x tileColumns are inside the poster
+      readback.capture(tileTarget.handle(),
+                       QRect(0, tileSize - bandRows, tileColumns, bandRows),
+                       column);
+      readback.poll();
+
+      ++tilesDone;
+      if (progress && !progress(tilesDone, tileCount)) {
+        writer.abort();
+        m_error = "Export cancelled";
+        return false;
+      }
+    }
+
+    readback.flush();
+    if (readback.hasFailed()) {
+      m_error = readback.errorString();
+      writer.abort();
+      return false;
+    }
+    if (!writer.writeRows(bandPixels.data(), bandRows)) {
+      m_error = writer.errorString();
+      writer.abort();
+      return false;
+    }
+  }
+
+  if (!writer.finish()) {
+    m_error = writer.errorString();
+    return false;
+  }
+  return true;
+}
+
+FractalState PosterExporter::tileState(const FractalState &state, int width,
+                                       int height, int tileSize, int column,
+                                       int band) {
+  // Same pixel size as the poster, zoomSize spans the poster height
+  const double pixelSize = state.zoomSize / height;
+
+  FractalState tile = state;
+  tile.zoomSize = pixelSize * tileSize;
+
+  // Tile center relative to the poster center in pixels, fractal y is up
+  const double offsetX = (column + 0.5) * tileSize - 0.5 * width;
+  const double offsetY = 0.5 * height - (band + 0.5) * tileSize;
+  tile.translate(offsetX * pixelSize, offsetY * pixelSize);
+  return tile;
+}
@@ -0,0 +1,63 @@
+#ifndef POSTEREXPORTER_H
+#define POSTEREXPORTER_H
+
+#include "core/FractalState.h"
+#include <QOpenGLExtraFunctions>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Renders a view to an image file far larger than any framebuffer
+ *
+ * The poster is cut into square tiles, each rendered offscreen by its own
+ * FractalRenderer with the tile's center and scale. Tiles are collected one
+ * band (a row of tiles) at a time and the band's rows go straight to a
+ * StreamingImageWriter. Memory use is one band, so a 32768x32768 poster
+ * needs about 100 MB rather than 3 GB.
+ *
+ * The poster shows the same vertical extent (zoomSize) as the view. Other
+ * aspect ratios widen or narrow it horizontally.
+ */
+class PosterExporter : protected QOpenGLExtraFunctions {
+public:
+  struct Settings {
+    int width = 3840;
+    int height = 2160;
+    int tileSize = 1024; // Clamped to the GL texture size limit
+    bool supersample = false; // 2x2 samples per pixel
+  };
+
+  // Called after every tile, return false to cancel
+  using ProgressCallback = std::function<bool(int tilesDone, int tileCount)>;
+
+  PosterExporter();
+
+  /**
+   * @brief Renders @p state and writes it to @p path (PNG or TIFF)
+   * @return false on failure or cancel, see errorString()
+   *
+   * Must be called with a GL context current. A cancelled or failed export
+   * leaves no file behind.
+   */
+  bool exportImage(const FractalState &state, const Settings &settings,
+                   const QString &path,
+                   const ProgressCallback &progress = ProgressCallback());
+
+  QString errorString() const { return m_error; }
+
+  /**
+   * @brief View of tile (column, band) of the poster, bands counted from
+   * the top
+   *
+   * Parts of the last column and band may lie outside the poster, the
+   * poster's pixels are the tile's top left.
+   */
+  static FractalState tileState(const FractalState &state, int width,
+                                int height, int tileSize, int column,
+                                int band);
+
+private:
+  QString m_error;
+};
+
+#endif // POSTEREXPORTER_H
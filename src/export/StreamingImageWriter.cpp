@@ -0,0 +1,273 @@
+#include "StreamingImageWriter.h"
+#include <QFileInfo>
+#include <cstdint>
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+// Compressed bytes per IDAT chunk
+constexpr size_t kDeflateBufferSize = 1 << 16;
+
+void appendU16LE(std::vector<unsigned char> &out, uint16_t value) {
+  out.push_back(value & 0xff);
+  out.push_back((value >> 8) & 0xff);
+}
+
+void appendU32LE(std::vector<unsigned char> &out, uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8)
+    out.push_back((value >> shift) & 0xff);
+}
+
+void appendU32BE(std::vector<unsigned char> &out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    out.push_back((value >> shift) & 0xff);
+}
+
+// One 12-byte TIFF directory entry, values that fit are stored inline
+void appendTiffEntry(std::vector<unsigned char> &out, uint16_t tag,
+                     uint16_t type, uint32_t count, uint32_t value) {
+  appendU16LE(out, tag);
+  appendU16LE(out, type);
+  appendU32LE(out, count);
+  appendU32LE(out, value);
+}
+
+constexpr uint16_t kTiffShort = 3;
+constexpr uint16_t kTiffLong = 4;
+constexpr uint16_t kTiffRational = 5;
+} // namespace
+
+StreamingImageWriter::StreamingImageWriter()
+    : m_format(Format::Png), m_width(0), m_height(0), m_rowsWritten(0) {}
+
+StreamingImageWriter::~StreamingImageWriter() {
+  if (m_file.isOpen())
+    abort();
+}
+
+StreamingImageWriter::Format
+StreamingImageWriter::formatForPath(const QString &path) {
+  QString suffix = QFileInfo(path).suffix().toLower();
+  return suffix == "tif" || suffix == "tiff" ? Format::Tiff : Format::Png;
+}
+
+bool StreamingImageWriter::open(const QString &path, int width, int height,
+                                Format format) {
+  m_format = format;
+  m_width = width;
+  m_height = height;
+  m_rowsWritten = 0;
+  m_error.clear();
+
+  if (width <= 0 || height <= 0)
+    return fail(QString("Invalid image size %1x%2").arg(width).arg(height));
+
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return fail(m_file.errorString());
+
+  return format == Format::Tiff ? writeTiffHeader() : writePngHeader();
+}
+
+bool StreamingImageWriter::writeRows(const unsigned char *rgb, int rowCount) {
+  if (!m_file.isOpen())
+    return fail("Image file is not open");
+  if (m_rowsWritten + rowCount > m_height)
+    return fail("More rows written than the image height");
+
+  const size_t rowBytes = static_cast<size_t>(m_width) * 3;
+
+  if (m_format == Format::Tiff) {
+    qint64 bytes = static_cast<qint64>(rowBytes) * rowCount;
+    if (m_file.write(reinterpret_cast<const char *>(rgb), bytes) != bytes)
+      return fail(m_file.errorString());
+    m_rowsWritten += rowCount;
+    return true;
+  }
+
+  // PNG: every row gets a filter type byte, Sub predicts from the pixel to
+  // the left which suits smooth gradients
+  for (int row = 0; row < rowCount; ++row) {
+    const unsigned char *src = rgb + row * rowBytes;
+    m_filteredRow[0] = 1;
+    for (size_t i = 0; i < rowBytes; ++i)
+      m_filteredRow[i + 1] =
+          static_cast<unsigned char>(src[i] - (i >= 3 ? src[i - 3] : 0));
+
+    if (!deflate(m_filteredRow.data(), m_filteredRow.size(), Z_NO_FLUSH))
+      return false;
+    ++m_rowsWritten;
+  }
+  return true;
+}
+
+bool StreamingImageWriter::finish() {
+  if (!m_file.isOpen())
+    return fail("Image file is not open");
+  if (m_rowsWritten != m_height) {
+    fail(QString("Only %1 of %2 rows written").arg(m_rowsWritten).arg(m_height));
+    abort();
+    return false;
+  }
+
+  if (m_format == Format::Png) {
+    if (!deflate(nullptr, 0, Z_FINISH))
+      return false;
+    deflateEnd(m_zstream.get());
+    m_zstream.reset();
+    if (!writePngChunk("IEND", nullptr, 0))
+      return false;
+  }
+
+  m_file.close();
+  return true;
+}
+
+void StreamingImageWriter::abort() {
+  if (m_zstream) {
+    deflateEnd(m_zstream.get());
+    m_zstream.reset();
+  }
+  if (m_file.isOpen()) {
+    m_file.close();
+    m_file.remove();
+  }
+}
+
+bool StreamingImageWriter::writeTiffHeader() {
+  // Header, one directory and its out-of-line values, then the pixels
+  constexpr uint32_t kEntryCount = 13;
+  constexpr uint32_t kDirectoryOffset = 8;
+  constexpr uint32_t kBitsOffset = kDirectoryOffset + 2 + kEntryCount * 12 + 4;
+  constexpr uint32_t kXResolutionOffset = kBitsOffset + 6;
+  constexpr uint32_t kYResolutionOffset = kXResolutionOffset + 8;
+  constexpr uint32_t kDataOffset = kYResolutionOffset + 8;
+
+  const uint64_t dataBytes = static_cast<uint64_t>(m_width) * m_height * 3;
+  if (kDataOffset + dataBytes > 0xffffffffull)
+    return fail("Image too large for TIFF (4 GiB limit), use PNG instead");
+
+  std::vector<unsigned char> header;
+  header.push_back('I');
+  header.push_back('I');
+  appendU16LE(header, 42);
+  appendU32LE(header, kDirectoryOffset);
+
+  // Entries must be sorted by tag
+  appendU16LE(header, kEntryCount);
+  appendTiffEntry(header, 256, kTiffLong, 1, m_width);     // ImageWidth
+  appendTiffEntry(header, 257, kTiffLong, 1, m_height);    // ImageLength
+  appendTiffEntry(header, 258, kTiffShort, 3, kBitsOffset); // BitsPerSample
+  appendTiffEntry(header, 259, kTiffShort, 1, 1);          // No compression
+  appendTiffEntry(header, 262, kTiffShort, 1, 2);          // RGB
+  appendTiffEntry(header, 273, kTiffLong, 1, kDataOffset); // StripOffsets
+  appendTiffEntry(header, 277, kTiffShort, 1, 3);          // SamplesPerPixel
+  appendTiffEntry(header, 278, kTiffLong, 1, m_height);    // RowsPerStrip
+  appendTiffEntry(header, 279, kTiffLong, 1,
+                  static_cast<uint32_t>(dataBytes)); // StripByteCounts
+  appendTiffEntry(header, 282, kTiffRational, 1, kXResolutionOffset);
+  appendTiffEntry(header, 283, kTiffRational, 1, kYResolutionOffset);
+  appendTiffEntry(header, 284, kTiffShort, 1, 1); // Interleaved samples
+  appendTiffEntry(header, 296, kTiffShort, 1, 2); // Resolution in inches
+  appendU32LE(header, 0);                         // No further directories
+
+  for (int i = 0; i < 3; ++i)
+    appendU16LE(header, 8);
+  for (int i = 0; i < 2; ++i) {
+    appendU32LE(header, 72); // 72 dpi
+    appendU32LE(header, 1);
+  }
+
+  qint64 bytes = static_cast<qint64>(header.size());
+  if (m_file.write(reinterpret_cast<const char *>(header.data()), bytes) !=
+      bytes)
+    return fail(m_file.errorString());
+  return true;
+}
+
+bool StreamingImageWriter::writePngHeader() {
+  static const unsigned char kSignature[8] = {0x89, 'P',  'N',  'G',
+                                              '\r', '\n', 0x1a, '\n'};
+  if (m_file.write(reinterpret_cast<const char *>(kSignature), 8) != 8)
+    return fail(m_file.errorString());
+
+  std::vector<unsigned char> ihdr;
+  appendU32BE(ihdr, m_width);
+  appendU32BE(ihdr, m_height);
+  ihdr.push_back(8); // Bit depth
+  ihdr.push_back(2); // Truecolor RGB
+  ihdr.push_back(0); // Deflate
+  ihdr.push_back(0); // Adaptive filtering
+  ihdr.push_back(0); // No interlace
+  if (!writePngChunk("IHDR", ihdr.data(), ihdr.size()))
+    return false;
+
+  m_zstream = std::make_unique<z_stream_s>();
+  std::memset(m_zstream.get(), 0, sizeof(z_stream_s));
+  if (deflateInit(m_zstream.get(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+    m_zstream.reset();
+    return fail("Failed to initialize the PNG compressor");
+  }
+
+  m_filteredRow.assign(static_cast<size_t>(m_width) * 3 + 1, 0);
+  m_deflateBuffer.resize(kDeflateBufferSize);
+  m_zstream->next_out = m_deflateBuffer.data();
+  m_zstream->avail_out = static_cast<uInt>(m_deflateBuffer.size());
+  return true;
+}
+
+bool StreamingImageWriter::writePngChunk(const char *type,
+                                         const unsigned char *data,
+                                         size_t size) {
+  std::vector<unsigned char> head;
+  appendU32BE(head, static_cast<uint32_t>(size));
+  head.insert(head.end(), type, type + 4);
+
+  // CRC covers the type and the data, not the length
+  uLong crc = crc32(0L, Z_NULL, 0);
+  crc = crc32(crc, head.data() + 4, 4);
+  if (size > 0)
+    crc = crc32(crc, data, static_cast<uInt>(size));
+  std::vector<unsigned char> tail;
+  appendU32BE(tail, static_cast<uint32_t>(crc));
+
+  qint64 dataBytes = static_cast<qint64>(size);
+  if (m_file.write(reinterpret_cast<const char *>(head.data()), 8) != 8 ||
+      (size > 0 && m_file.write(reinterpret_cast<const char *>(data),
+                                dataBytes) != dataBytes) ||
+      m_file.write(reinterpret_cast<const char *>(tail.data()), 4) != 4)
+    return fail(m_file.errorString());
+  return true;
+}
+
+bool StreamingImageWriter::deflate(const unsigned char *data, size_t size,
+                                   int flush) {
+  z_stream_s *stream = m_zstream.get();
+  stream->next_in = const_cast<Bytef *>(data);
+  stream->avail_in = static_cast<uInt>(size);
+
+  for (;;) {
+    int result = ::deflate(stream, flush);
+    if (result == Z_STREAM_ERROR)
+      return fail("PNG compression failed");
+
+    // Emit a chunk when the buffer is full, or with whatever is left at
+    // the end of the stream
+    size_t produced = m_deflateBuffer.size() - stream->avail_out;
+    bool done = flush == Z_FINISH ? result == Z_STREAM_END
+                                  : stream->avail_in == 0;
+    if (stream->avail_out == 0 || (done && flush == Z_FINISH && produced > 0)) {
+      if (!writePngChunk("IDAT", m_deflateBuffer.data(), produced))
+        return false;
+      stream->next_out = m_deflateBuffer.data();
+      stream->avail_out = static_cast<uInt>(m_deflateBuffer.size());
+    }
+    if (done)
+      return true;
+  }
+}
+
+bool StreamingImageWriter::fail(const QString &message) {
+  m_error = message;
+  return false;
+}
@@ -0,0 +1,78 @@
+#ifndef STREAMINGIMAGEWRITER_H
+#define STREAMINGIMAGEWRITER_H
+
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <vector>
+
+struct z_stream_s;
+
+/**
+ * @brief Writes an 8-bit RGB image row by row without holding it in memory
+ *
+ * Rows are encoded and written as they arrive, top to bottom, so the peak
+ * memory use is independent of the image height. Supported formats:
+ *
+ *   PNG   deflate-compressed, Sub row filter
+ *   TIFF  baseline, uncompressed, single strip (limited to 4 GiB)
+ */
+class StreamingImageWriter {
+public:
+  enum class Format { Png, Tiff };
+
+  StreamingImageWriter();
+  ~StreamingImageWriter();
+
+  // TIFF for a .tif/.tiff suffix, PNG otherwise
+  static Format formatForPath(const QString &path);
+
+  /**
+   * @brief Creates the file and writes the header
+   * @return false on failure, see errorString()
+   */
+  bool open(const QString &path, int width, int height, Format format);
+
+  /**
+   * @brief Appends rows of tightly packed RGB (width * 3 bytes each)
+   * @return false on failure or when more than height rows are written
+   */
+  bool writeRows(const unsigned char *rgb, int rowCount);
+
+  /**
+   * @brief Flushes the encoder and closes the file
+   * @return false if not all rows were written or writing failed
+   */
+  bool finish();
+
+  // Closes and deletes a partially written file
+  void abort();
+
+  int rowsWritten() const { return m_rowsWritten; }
+  QString errorString() const { return m_error; }
+
+private:
+  bool writeTiffHeader();
+  bool writePngHeader();
+  bool writePngChunk(const char *type, const unsigned char *data,
+                     size_t size);
+
+  // Feeds m_zstream and emits IDAT chunks whenever the output fills up
+  bool deflate(const unsigned char *data, size_t size, int flush);
+
+  bool fail(const QString &message);
+
+  QFile m_file;
+  Format m_format;
+  int m_width;
+  int m_height;
+  int m_rowsWritten;
+  QString m_error;
+
+  // PNG encoder state
+  std::unique_ptr<z_stream_s> m_zstream;
+  std::vector<unsigned char> m_filteredRow;
+  std::vector<unsigned char> m_deflateBuffer;
+};
+
+#endif // STREAMINGIMAGEWRITER_H
@@ -0,0 +1,216 @@
+#include "VideoEncoderPipe.h"
+#include <QFile>
+#include <QProcess>
+
+VideoEncoderPipe::VideoEncoderPipe()
+    : m_frameBytes(0), m_started(false), m_closing(false), m_aborting(false),
+      m_failed(false), m_framesEncoded(0) {}
+
+VideoEncoderPipe::~VideoEncoderPipe() {
+  if (m_encoder)
+    abort();
+}
+
+bool VideoEncoderPipe::open(const QString &path, int width, int height,
+                            int fps, const QString &ffmpegPath) {
+  m_path = path;
+  m_frameBytes = static_cast<size_t>(width) * height * 3;
+  m_queue.clear();
+  m_spareBuffers.clear();
+  m_started = false;
+  m_closing = false;
+  m_aborting = false;
+  m_failed = false;
+  m_framesEncoded = 0;
+  m_error.clear();
+
+  // yuv420p subsamples chroma 2x2, odd sizes are rejected by the encoder
+  if (width <= 0 || height <= 0 || width % 2 || height % 2) {
+    m_failed = true;
+    m_error = QString("Invalid video size %1x%2, both must be even")
+                  .arg(width)
+                  .arg(height);
+    return false;
+  }
+  if (fps <= 0) {
+    m_failed = true;
+    m_error = "Invalid frame rate";
+    return false;
+  }
+
+  const QStringList arguments = {
+      "-y", "-loglevel", "error", "-nostats",
+      // Input: raw frames on stdin
+      "-f", "rawvideo", "-pix_fmt", "rgb24", "-s",
+      QString("%1x%2").arg(width).arg(height), "-r", QString::number(fps),
+      "-i", "-",
+      // Output: H.264 with a keyframe every two seconds
+      "-c:v", "libx264", "-preset", "medium", "-crf", "18", "-pix_fmt",
+      "yuv420p", "-g", QString::number(fps * 2), "-movflags", "+faststart",
+      path};
+
+  m_encoder.reset(QThread::create(
+      [this, ffmpegPath, arguments]() { encoderLoop(ffmpegPath, arguments); }));
+  m_encoder->start();
+
+  QMutexLocker locker(&m_mutex);
+  while (!m_started && !m_failed)
+    m_startDone.wait(&m_mutex);
+  return !m_failed;
+}
+
+bool VideoEncoderPipe::writeFrame(const unsigned char *rgb) {
+  QMutexLocker locker(&m_mutex);
+  while (!m_failed && !m_aborting &&
+         m_queue.size() >= static_cast<size_t>(kMaxQueuedFrames))
+    m_frameTaken.wait(&m_mutex);
+  if (!m_started || m_failed || m_aborting || m_closing)
+    return false;
+
+  // Buffers cycle between the queue and the spares, no per-frame allocation
+  std::vector<unsigned char> buffer;
+  if (!m_spareBuffers.empty()) {
+    buffer = std::move(m_spareBuffers.back());
+    m_spareBuffers.pop_back();
+  }
+
+  // Only this thread adds frames, so the queue cannot fill up meanwhile
+  locker.unlock();
+  buffer.assign(rgb, rgb + m_frameBytes);
+  locker.relock();
+
+  m_queue.push_back(std::move(buffer));
+  m_frameQueued.wakeOne();
+  return true;
+}
+
+bool VideoEncoderPipe::finish() {
+  if (!m_encoder)
+    return false;
+
+  {
+    QMutexLocker locker(&m_mutex);
+    m_closing = true;
+    m_frameQueued.wakeAll();
+  }
+  m_encoder->wait();
+  m_encoder.reset();
+
+  if (hasFailed()) {
+    QFile::remove(m_path);
+    return false;
+  }
+  return true;
+}
+
+void VideoEncoderPipe::abort() {
+  if (!m_encoder)
+    return;
+
+  {
+    QMutexLocker locker(&m_mutex);
+    m_aborting = true;
+    m_frameQueued.wakeAll();
+    m_frameTaken.wakeAll();
+  }
+  m_encoder->wait();
+  m_encoder.reset();
+  QFile::remove(m_path);
+}
+
+bool VideoEncoderPipe::hasFailed() const {
+  QMutexLocker locker(&m_mutex);
+  return m_failed;
+}
+
+int VideoEncoderPipe::framesEncoded() const {
+  QMutexLocker locker(&m_mutex);
+  return m_framesEncoded;
+}
+
+QString VideoEncoderPipe::errorString() const {
+  QMutexLocker locker(&m_mutex);
+  return m_error;
+}
+
+void VideoEncoderPipe::encoderLoop(const QString &program,
+                                   const QStringList &arguments) {
+  // Created here so the process belongs to this thread, the blocking
+  // waitFor*() calls then need no event loop
+  QProcess process;
+  process.setStandardOutputFile(QProcess::nullDevice());
+  process.start(program, arguments);
+  if (!process.waitForStarted()) {
+    setFailed(QString("Failed to start %1: %2")
+                  .arg(program, process.errorString()));
+    return;
+  }
+  {
+    QMutexLocker locker(&m_mutex);
+    m_started = true;
+    m_startDone.wakeAll();
+  }
+
+  bool aborted = false;
+  for (;;) {
+    std::vector<unsigned char> frame;
+    {
+      QMutexLocker locker(&m_mutex);
+      while (m_queue.empty() && !m_closing && !m_aborting)
+        m_frameQueued.wait(&m_mutex);
+      if (m_aborting || m_queue.empty()) {
+        aborted = m_aborting;
+        break;
+      }
+      frame = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+
+    // Waiting also drains ffmpeg's stderr, so it never blocks on a full pipe
+    process.write(reinterpret_cast<const char *>(frame.data()),
+                  static_cast<qint64>(frame.size()));
+    bool written = true;
+    while (written && process.bytesToWrite() > 0)
+      written = process.waitForBytesWritten(-1);
+
+    {
+      QMutexLocker locker(&m_mutex);
+      m_spareBuffers.push_back(std::move(frame));
+      if (written)
+        ++m_framesEncoded;
+      m_frameTaken.wakeAll();
+    }
+    if (!written) {
+      process.kill();
+      process.waitForFinished();
+      setFailed(QString("The encoder stopped accepting frames: %1")
+                    .arg(QString::fromLocal8Bit(process.readAllStandardError())
+                             .trimmed()));
+      return;
+    }
+  }
+
+  if (aborted) {
+    process.kill();
+    process.waitForFinished();
+    return;
+  }
+
+  // End of input lets ffmpeg flush its last frames and the container
+  process.closeWriteChannel();
+  process.waitForFinished(-1);
+  if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0)
+    setFailed(QString("The encoder failed: %1")
+                  .arg(QString::fromLocal8Bit(process.readAllStandardError())
+                           .trimmed()));
+}
+
+void VideoEncoderPipe::setFailed(const QString &message) {
+  QMutexLocker locker(&m_mutex);
+  if (!m_failed) {
+    m_failed = true;
+    m_error = message;
+  }
+  m_startDone.wakeAll();
+  m_frameTaken.wakeAll();
+}
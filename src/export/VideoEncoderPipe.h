@@ -0,0 +1,83 @@
+#ifndef VIDEOENCODERPIPE_H
+#define VIDEOENCODERPIPE_H
+
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Streams raw RGB frames into an ffmpeg subprocess
+ *
+ * writeFrame() only copies the frame into a small bounded queue. An encoder
+ * thread owns the QProcess and writes the queue to ffmpeg's stdin, so
+ * encoding overlaps rendering and readback. A full queue blocks the writer,
+ * which throttles rendering to the encoder's speed instead of buffering the
+ * whole video in memory.
+ *
+ * Frames are 8-bit RGB, top row first, width * 3 bytes per row. The output
+ * is H.264 in yuv420p for broad player support, so the size must be even.
+ */
+class VideoEncoderPipe {
+public:
+  static constexpr int kMaxQueuedFrames = 4;
+
+  VideoEncoderPipe();
+  ~VideoEncoderPipe();
+
+  /**
+   * @brief Starts @p ffmpegPath writing a @p fps video to @p path
+   * @return false if the size is invalid or the process cannot start
+   */
+  bool open(const QString &path, int width, int height, int fps,
+            const QString &ffmpegPath = "ffmpeg");
+
+  /**
+   * @brief Queues one frame, blocks while the queue is full
+   * @return false once the encoder has failed or been aborted
+   *
+   * Safe to call from any one thread at a time.
+   */
+  bool writeFrame(const unsigned char *rgb);
+
+  /**
+   * @brief Encodes the remaining frames and waits for ffmpeg to exit
+   * @return false if ffmpeg failed, see errorString()
+   */
+  bool finish();
+
+  // Stops ffmpeg and removes the partial file
+  void abort();
+
+  bool hasFailed() const;
+  int framesEncoded() const;
+  QString errorString() const;
+
+private:
+  void encoderLoop(const QString &program, const QStringList &arguments);
+  void setFailed(const QString &message);
+
+  QString m_path;
+  size_t m_frameBytes;
+  std::unique_ptr<QThread> m_encoder;
+
+  // Shared with the encoder thread
+  mutable QMutex m_mutex;
+  QWaitCondition m_frameQueued;
+  QWaitCondition m_frameTaken;
+  QWaitCondition m_startDone;
+  std::deque<std::vector<unsigned char>> m_queue;
+  std::vector<std::vector<unsigned char>> m_spareBuffers;
+  bool m_started;
+  bool m_closing;
+  bool m_aborting;
+  bool m_failed;
+  int m_framesEncoded;
+  QString m_error;
+};
+
+#endif // VIDEOENCODERPIPE_H
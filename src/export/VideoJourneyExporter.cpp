@@ -0,0 +1,140 @@
+#include "VideoJourneyExporter.h"
+#include "VideoEncoderPipe.h"
+#include "rendering/AsyncReadback.h"
+#include "rendering/FractalRenderer.h"
+#include <QOpenGLFramebufferObject>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+VideoJourneyExporter::VideoJourneyExporter() {}
+
+bool VideoJourneyExporter::exportVideo(const FractalState &state,
+                                       const Settings &settings,
+                                       const QString &path,
+                                       const ProgressCallback &progress) {
+  m_error.clear();
+  initializeOpenGLFunctions();
+
+  const int width = settings.width;
+  const int height = settings.height;
+  const int frameCount = static_cast<int>(
+      std::lround(settings.durationSeconds * settings.fps));
+  if (frameCount <= 0) {
+    m_error = "Invalid video duration";
+    return false;
+  }
+
+  GLint maxTextureSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  if (width > maxTextureSize || height > maxTextureSize) {
+    m_error = QString("Video size exceeds the GL limit of %1 pixels")
+                  .arg(maxTextureSize);
+    return false;
+  }
+
+  // Falls back to one sample per pixel if 2x is beyond the texture limit
+  FractalRenderer renderer;
+  if (!renderer.initialize()) {
+    m_error = "Failed to initialize the renderer";
+    return false;
+  }
+  renderer.setResolutionScale(settings.supersample ? 2.0f : 1.0f);
+
+  QOpenGLFramebufferObject frameTarget(width, height);
+  if (!frameTarget.isValid()) {
+    m_error = "Failed to create the frame framebuffer";
+    return false;
+  }
+
+  VideoEncoderPipe encoder;
+  if (!encoder.open(path, width, height, settings.fps, settings.ffmpegPath)) {
+    m_error = encoder.errorString();
+    return false;
+  }
+
+  // The worker drops alpha and flips the rows to top-down order. Frames
+  // arrive in capture order, which is the order ffmpeg needs.
+  std::vector<unsigned char> rgb(static_cast<size_t>(width) * height * 3);
+  AsyncReadback readback([&rgb, &encoder](const AsyncReadback::Frame &frame) {
+    for (int row = 0; row < frame.height; ++row) {
+      const unsigned char *src =
+          frame.pixels +
+          static_cast<size_t>(frame.height - 1 - row) * frame.stride;
+      unsigned char *dst =
+          rgb.data() + static_cast<size_t>(row) * frame.width * 3;
+      for (int x = 0; x < frame.width; ++x) {
+        dst[3 * x] = src[4 * x];
+        dst[3 * x + 1] = src[4 * x + 1];
+        dst[3 * x + 2] = src[4 * x + 2];
+      }
+    }
+    encoder.writeFrame(rgb.data());
+  });
+  if (!readback.initialize()) {
+    m_error = "Failed to initialize the readback";
+    return false;
+  }
+
+  // The deepest frame's orbit covers every perturbation frame before it,
+  // computed while the shallow frames render
+  renderer.prefetchReferenceOrbit(
+      frameState(state, settings.startZoomSize, 1.0), QSize(width, height));
+
+  for (int frame = 0; frame < frameCount; ++frame) {
+    const double t =
+        frameCount > 1 ? static_cast<double>(frame) / (frameCount - 1) : 1.0;
+    FractalState view = frameState(state, settings.startZoomSize, t);
+
+    // Time-sliced like on screen, so no single draw trips the watchdog
+    do {
+      renderer.render(view, QSize(width, height), frameTarget.handle());
+    } while (renderer.hasPendingWork());
+
+    readback.capture(frameTarget.handle(), QRect(0, 0, width, height), frame);
+    readback.poll();
+
+    if (encoder.hasFailed()) {
+      m_error = encoder.errorString();
+      encoder.abort();
+      return false;
+    }
+    if (readback.hasFailed()) {
+      m_error = readback.errorString();
+      encoder.abort();
+      return false;
+    }
+    if (progress &&
+        !progress(frame + 1, encoder.framesEncoded(), frameCount)) {
+      encoder.abort();
+      m_error = "Export cancelled";
+      return false;
+    }
+  }
+
+  readback.flush();
+  if (readback.hasFailed()) {
+    m_error = readback.errorString();
+    encoder.abort();
+    return false;
+  }
+  if (!encoder.finish()) {
+    m_error = encoder.errorString();
+    return false;
+  }
+  return true;
+}
+
+FractalState VideoJourneyExporter::frameState(const FractalState &state,
+                                              double startZoomSize, double t) {
+  // Quadratic ease-in-out, slow start and a gentle arrival
+  const double ease = t < 0.5 ? 2.0 * t * t : -1.0 + (4.0 - 2.0 * t) * t;
+
+  const double logStart = std::log(startZoomSize);
+  const double logEnd = std::log(state.zoomSize);
+
+  FractalState view = state;
+  view.zoomSize = t >= 1.0 ? state.zoomSize
+                           : std::exp(logStart + (logEnd - logStart) * ease);
+  return view;
+}
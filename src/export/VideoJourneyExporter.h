@@ -0,0 +1,63 @@
+#ifndef VIDEOJOURNEYEXPORTER_H
+#define VIDEOJOURNEYEXPORTER_H
+
+#include "core/FractalState.h"
+#include <QOpenGLExtraFunctions>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Renders a zoom journey into the current view as a video file
+ *
+ * The journey zooms from startZoomSize down to the view's zoomSize around
+ * the view's center, interpolated in log space with ease-in-out so every
+ * second covers the same zoom factor apart from the ends.
+ *
+ * Three stages overlap: frame N+1 renders on the GPU while frame N is read
+ * back through an AsyncReadback ring and frame N-1 is encoded by ffmpeg
+ * through a VideoEncoderPipe. The slowest stage sets the pace.
+ */
+class VideoJourneyExporter : protected QOpenGLExtraFunctions {
+public:
+  struct Settings {
+    int width = 1920; // Must be even
+    int height = 1080;
+    int fps = 30;
+    double durationSeconds = 30.0;
+    double startZoomSize = 3.0; // The default view
+    bool supersample = false; // 2x2 samples per pixel
+    QString ffmpegPath = "ffmpeg";
+  };
+
+  // Called after every rendered frame, return false to cancel
+  using ProgressCallback = std::function<bool(
+      int framesRendered, int framesEncoded, int frameCount)>;
+
+  VideoJourneyExporter();
+
+  /**
+   * @brief Renders the journey into @p state and encodes it to @p path
+   * @return false on failure or cancel, see errorString()
+   *
+   * Must be called with a GL context current. A cancelled or failed export
+   * leaves no file behind.
+   */
+  bool exportVideo(const FractalState &state, const Settings &settings,
+                   const QString &path,
+                   const ProgressCallback &progress = ProgressCallback());
+
+  QString errorString() const { return m_error; }
+
+  /**
+   * @brief View at journey time @p t in [0, 1]
+   *
+   * Same center as @p state at every step, only the scale changes.
+   */
+  static FractalState frameState(const FractalState &state,
+                                 double startZoomSize, double t);
+
+private:
+  QString m_error;
+};
+
+#endif // VIDEOJOURNEYEXPORTER_H
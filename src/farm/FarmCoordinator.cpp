@@ -0,0 +1,427 @@
+#include "FarmCoordinator.h"
+#include "core/Formula.h"
+#include "export/PosterExporter.h"
+#include "export/VideoJourneyExporter.h"
+#include "rendering/PrecisionPolicy.h"
+#include <QAbstractSocket>
+#include <QDir>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+void log(const QString &line) { QTextStream(stdout) << line << '\n'; }
+} // namespace
+
+FarmCoordinator::FarmCoordinator() : m_jobSerial(0) {
+  QObject::connect(&m_server, &QTcpServer::newConnection, &m_server,
+                   [this] { acceptWorkers(); });
+}
+
+FarmCoordinator::~FarmCoordinator() {
+  // Closing the connections tells the workers to exit
+  for (auto &entry : m_workers) {
+    QTcpSocket *socket = entry.first;
+    QObject::disconnect(socket, nullptr, &m_server, nullptr);
+    socket->disconnectFromHost();
+    if (socket->state() != QAbstractSocket::UnconnectedState)
+      socket->waitForDisconnected(1000);
+  }
+}
+
+bool FarmCoordinator::listen(quint16 port) {
+  if (!m_server.listen(QHostAddress::Any, port)) {
+    m_error = QString("Cannot listen on port %1: %2")
+                  .arg(port)
+                  .arg(m_server.errorString());
+    return false;
+  }
+  return true;
+}
+
+bool FarmCoordinator::render(const RenderJob &job) {
+  m_error.clear();
+  m_run = std::make_unique<Run>();
+  Run &run = *m_run;
+  run.job = &job;
+  run.serial = ++m_jobSerial;
+  if (!prepare(run)) {
+    m_run.reset();
+    return false;
+  }
+
+  if (m_workers.empty())
+    log(QString("Waiting for workers on port %1").arg(m_server.serverPort()));
+  dispatch();
+  if (!run.done && !run.failed)
+    m_loop.exec();
+
+  // Units of a failed job still out on workers come back with a stale
+  // serial and are dropped
+  for (auto &entry : m_workers)
+    entry.second.units.clear();
+  const bool rendered = run.done;
+  m_run.reset();
+  return rendered;
+}
+
+void FarmCoordinator::acceptWorkers() {
+  while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+    socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    m_workers[socket].name = socket->peerAddress().toString();
+    QObject::connect(socket, &QTcpSocket::readyRead, &m_server,
+                     [this, socket] { receive(socket); });
+    QObject::connect(socket, &QTcpSocket::disconnected, &m_server,
+                     [this, socket] { dropWorker(socket); });
+  }
+}
+
+void FarmCoordinator::receive(QTcpSocket *socket) {
+  auto it = m_workers.find(socket);
+  if (it == m_workers.end())
+    return;
+  Worker &worker = it->second;
+  worker.buffer.append(socket->readAll());
+
+  FarmProtocol::Message type;
+  QByteArray payload;
+  bool corrupt = false;
+  while (FarmProtocol::takeMessage(worker.buffer, type, payload, corrupt)) {
+    if (!handle(socket, worker, type, payload)) {
+      corrupt = true;
+      break;
+    }
+  }
+  if (corrupt) {
+    log(QString("Protocol error from %1").arg(worker.name));
+    dropWorker(socket);
+  }
+  dispatch();
+}
+
+void FarmCoordinator::dropWorker(QTcpSocket *socket) {
+  auto it = m_workers.find(socket);
+  if (it == m_workers.end())
+    return;
+  const QString name = it->second.name;
+  const std::set<int> units = std::move(it->second.units);
+  m_workers.erase(it);
+
+  QObject::disconnect(socket, nullptr, &m_server, nullptr);
+  socket->abort();
+  socket->deleteLater();
+
+  log(QString("Worker %1 left").arg(name));
+  for (int index : units)
+    retry(index, QString("worker %1 left").arg(name));
+  dispatch();
+}
+
+bool FarmCoordinator::handle(QTcpSocket *socket, Worker &worker,
+                             FarmProtocol::Message type,
+                             const QByteArray &payload) {
+  using FarmProtocol::Message;
+
+  // Everything but Hello is ignored until the worker introduced itself
+  if (!worker.ready && type != Message::Hello)
+    return false;
+
+  switch (type) {
+  case Message::Hello: {
+    FarmProtocol::Hello hello;
+    if (!FarmProtocol::decode(payload, hello) ||
+        hello.version != FarmProtocol::kVersion)
+      return false;
+    worker.name = QString("%1 (%2, %3)")
+                      .arg(hello.host, socket->peerAddress().toString(),
+                           hello.engine);
+    worker.ready = true;
+    log(QString("Worker %1 joined").arg(worker.name));
+    return true;
+  }
+  case Message::OrbitRequest: {
+    FarmProtocol::OrbitRequest request;
+    if (!FarmProtocol::decode(payload, request))
+      return false;
+    auto it = m_orbits.find(request.orbit);
+    if (it == m_orbits.end())
+      return false;
+    FarmProtocol::Orbit orbit;
+    orbit.orbit = request.orbit;
+    orbit.data = it->second;
+    socket->write(FarmProtocol::encode(orbit));
+    return true;
+  }
+  case Message::Result: {
+    FarmProtocol::Result result;
+    if (!FarmProtocol::decode(payload, result))
+      return false;
+    if (!m_run || result.job != m_run->serial ||
+        worker.units.erase(result.index) == 0)
+      return true;
+    if (result.size != m_run->unitSize) {
+      retry(result.index, QString("wrong result size from %1")
+                              .arg(worker.name));
+      return true;
+    }
+    accept(result.index, std::move(result.rgb));
+    return true;
+  }
+  case Message::Failure: {
+    FarmProtocol::Failure failure;
+    if (!FarmProtocol::decode(payload, failure))
+      return false;
+    if (!m_run || failure.job != m_run->serial ||
+        worker.units.erase(failure.index) == 0)
+      return true;
+    retry(failure.index,
+          QString("%1 on %2").arg(failure.message, worker.name));
+    return true;
+  }
+  case Message::Unit:
+  case Message::Orbit:
+    return false;
+  }
+  return false;
+}
+
+bool FarmCoordinator::prepare(Run &run) {
+  const RenderJob &job = *run.job;
+  const int width = job.size.width();
+  const int height = job.size.height();
+
+  const QString directory = QFileInfo(job.output).absolutePath();
+  if (!QDir().mkpath(directory)) {
+    m_error = QString("Cannot create %1").arg(directory);
+    return false;
+  }
+
+  if (job.kind == RenderJob::Kind::Image) {
+    const int tileSize = kTileSize;
+    run.columns = (width + tileSize - 1) / tileSize;
+    const int bands = (height + tileSize - 1) / tileSize;
+    run.unitSize = QSize(tileSize, tileSize);
+    for (int band = 0; band < bands; ++band) {
+      for (int column = 0; column < run.columns; ++column)
+        run.states.push_back(PosterExporter::tileState(
+            job.state, width, height, tileSize, column, band));
+    }
+    run.band.resize(static_cast<size_t>(width) * tileSize * 3);
+
+    if (!run.writer.open(job.output, width, height,
+                         StreamingImageWriter::formatForPath(job.output))) {
+      m_error = run.writer.errorString();
+      return false;
+    }
+  } else {
+    const int frameCount = job.frameCount();
+    run.unitSize = job.size;
+    for (int frame = 0; frame < frameCount; ++frame) {
+      const double t = frameCount > 1
+                           ? static_cast<double>(frame) / (frameCount - 1)
+                           : 1.0;
+      run.states.push_back(
+          VideoJourneyExporter::frameState(job.state, job.startZoomSize, t));
+    }
+
+    if (!run.encoder.open(job.output, width, height, job.fps)) {
+      m_error = run.encoder.errorString();
+      return false;
+    }
+  }
+
+  const int unitCount = static_cast<int>(run.states.size());
+  run.orbits.assign(unitCount, -1);
+  run.attempts.assign(unitCount, 0);
+  for (int index = 0; index < unitCount; ++index)
+    run.pending.insert(index);
+
+  // The final frame's orbit has the most limbs and covers every frame of
+  // the journey, which all share its center
+  if (job.kind == RenderJob::Kind::Journey &&
+      Formula::isEscapeTime(job.state.fractalType) &&
+      job.state.zoomSize < PrecisionPolicy::kPerturbationZoomThreshold) {
+    const qint32 orbit = sharedOrbit(job.state);
+    for (int index = 0; index < unitCount; ++index) {
+      if (run.states[index].zoomSize <
+          PrecisionPolicy::kPerturbationZoomThreshold)
+        run.orbits[index] = orbit;
+    }
+  }
+  return true;
+}
+
+qint32 FarmCoordinator::sharedOrbit(const FractalState &state) {
+  const int limbs = BigReal::limbsForScale(state.zoomSize);
+  BigReal centerX = state.deepCenterX;
+  BigReal centerY = state.deepCenterY;
+  centerX.setLimbCount(limbs);
+  centerY.setLimbCount(limbs);
+
+  const int digits = limbs * 10 + 2;
+  const QString key = QString("%1 %2 %3 %4 %5 %6")
+                          .arg(QString::fromStdString(centerX.toString(digits)),
+                               QString::fromStdString(centerY.toString(digits)))
+                          .arg(state.maxIterations)
+                          .arg(state.fractalType)
+                          .arg(state.juliaCx, 0, 'g', 17)
+                          .arg(state.juliaCy, 0, 'g', 17);
+  auto it = m_orbitIds.find(key);
+  if (it != m_orbitIds.end())
+    return it->second;
+
+  const qint32 id = static_cast<qint32>(m_orbits.size());
+  ReferenceOrbit &orbit = m_orbits[id];
+  orbit.compute(centerX, centerY, state.maxIterations, state.fractalType,
+                state.juliaCx, state.juliaCy);
+  m_orbitIds[key] = id;
+  log(QString("Shared reference orbit of %1 points").arg(orbit.length()));
+  return id;
+}
+
+void FarmCoordinator::dispatch() {
+  if (!m_run || m_run->done || m_run->failed)
+    return;
+  Run &run = *m_run;
+  const RenderJob &job = *run.job;
+
+  int readyWorkers = 0;
+  for (const auto &entry : m_workers)
+    readyWorkers += entry.second.ready ? 1 : 0;
+
+  // Enough units in flight to keep every slot busy, more only while the
+  // reorder buffer they may end up in stays within its budget
+  const qint64 unitBytes =
+      static_cast<qint64>(run.unitSize.width()) * run.unitSize.height() * 3;
+  const qint64 window =
+      std::max<qint64>(kUnitsPerWorker * std::max(1, readyWorkers),
+                       kReorderBudgetBytes / unitBytes);
+
+  for (auto &entry : m_workers) {
+    Worker &worker = entry.second;
+    if (!worker.ready)
+      continue;
+    while (static_cast<int>(worker.units.size()) < kUnitsPerWorker &&
+           !run.pending.empty()) {
+      const int index = *run.pending.begin();
+      if (index >= run.nextToWrite + window)
+        return;
+      run.pending.erase(run.pending.begin());
+      worker.units.insert(index);
+
+      FarmProtocol::Unit unit;
+      unit.job = run.serial;
+      unit.index = index;
+      unit.state = run.states[index];
+      unit.size = run.unitSize;
+      unit.supersample = job.supersample;
+      unit.engine = job.engine;
+      unit.orbit = run.orbits[index];
+      entry.first->write(FarmProtocol::encode(unit));
+    }
+  }
+}
+
+void FarmCoordinator::retry(int index, const QString &reason) {
+  if (!m_run || m_run->failed)
+    return;
+  Run &run = *m_run;
+  if (++run.attempts[index] >= kMaxAttempts) {
+    fail(QString("Unit %1 failed %2 times, last: %3")
+             .arg(index)
+             .arg(kMaxAttempts)
+             .arg(reason));
+    return;
+  }
+  log(QString("Retrying unit %1: %2").arg(index).arg(reason));
+  run.pending.insert(index);
+}
+
+void FarmCoordinator::accept(int index, QByteArray rgb) {
+  Run &run = *m_run;
+  if (run.failed || index < run.nextToWrite)
+    return;
+  run.finished[index] = std::move(rgb);
+
+  if (!writeFinished())
+    return;
+  if (run.nextToWrite < static_cast<int>(run.states.size()))
+    return;
+
+  const bool finished = run.job->kind == RenderJob::Kind::Image
+                            ? run.writer.finish()
+                            : run.encoder.finish();
+  if (!finished) {
+    fail(run.job->kind == RenderJob::Kind::Image ? run.writer.errorString()
+                                                 : run.encoder.errorString());
+    return;
+  }
+  run.done = true;
+  m_loop.quit();
+}
+
+bool FarmCoordinator::writeFinished() {
+  Run &run = *m_run;
+  for (auto it = run.finished.find(run.nextToWrite); it != run.finished.end();
+       it = run.finished.find(run.nextToWrite)) {
+    if (!write(it->first, it->second))
+      return false;
+    run.finished.erase(it);
+    ++run.nextToWrite;
+  }
+  return true;
+}
+
+bool FarmCoordinator::write(int index, const QByteArray &rgb) {
+  Run &run = *m_run;
+  const RenderJob &job = *run.job;
+  const unsigned char *pixels =
+      reinterpret_cast<const unsigned char *>(rgb.constData());
+
+  if (job.kind == RenderJob::Kind::Journey) {
+    if (!run.encoder.writeFrame(pixels)) {
+      fail(run.encoder.errorString());
+      return false;
+    }
+    return true;
+  }
+
+  // Only the top left of the last column and band lies in the image
+  const int width = job.size.width();
+  const int tileSize = run.unitSize.width();
+  const int column = index % run.columns;
+  const int band = index / run.columns;
+  const int tileColumns = std::min(tileSize, width - column * tileSize);
+  const int bandRows = std::min(tileSize, job.size.height() - band * tileSize);
+  for (int row = 0; row < bandRows; ++row) {
+    std::memcpy(run.band.data() +
+                    (static_cast<size_t>(row) * width + column * tileSize) * 3,
+                pixels + static_cast<size_t>(row) * tileSize * 3,
+                static_cast<size_t>(tileColumns) * 3);
+  }
+
+  if (column == run.columns - 1 &&
+      !run.writer.writeRows(run.band.data(), bandRows)) {
+    fail(run.writer.errorString());
+    return false;
+  }
+  return true;
+}
+
+void FarmCoordinator::fail(const QString &message) {
+  Run &run = *m_run;
+  if (run.failed)
+    return;
+  run.failed = true;
+  run.pending.clear();
+  m_error = message;
+  if (run.job->kind == RenderJob::Kind::Image)
+    run.writer.abort();
+  else
+    run.encoder.abort();
+  m_loop.quit();
+}
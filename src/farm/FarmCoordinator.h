@@ -0,0 +1,142 @@
+#ifndef FARMCOORDINATOR_H
+#define FARMCOORDINATOR_H
+
+#include "FarmProtocol.h"
+#include "batch/JobFile.h"
+#include "core/ReferenceOrbit.h"
+#include "export/StreamingImageWriter.h"
+#include "export/VideoEncoderPipe.h"
+#include <QByteArray>
+#include <QEventLoop>
+#include <QString>
+#include <QTcpServer>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+class QTcpSocket;
+
+/**
+ * @brief Spreads batch jobs over farm workers and assembles their output
+ *
+ * A job is split into independent units: the tiles of an image, with the
+ * geometry of PosterExporter, or the frames of a journey. Units go to the
+ * connected workers, a few at a time each so none idles while a result is
+ * in transit. Results are written in unit order, out-of-order ones wait in
+ * a reorder buffer of bounded size, and no unit is handed out beyond it.
+ *
+ * A unit that fails or whose worker disconnects is handed out again, up to
+ * kMaxAttempts times before the job fails. Workers may join and leave at
+ * any time, a job without workers waits for one.
+ *
+ * Journey frames deep enough for perturbation share the reference orbit of
+ * the final frame: it is computed once here, kept for later jobs at the
+ * same location, and each worker fetches it once.
+ */
+class FarmCoordinator {
+public:
+  // Units a worker holds at once
+  static constexpr int kUnitsPerWorker = 2;
+
+  // Attempts per unit before its job fails
+  static constexpr int kMaxAttempts = 3;
+
+  // Side of the image tiles
+  static constexpr int kTileSize = 512;
+
+  // Results held for reordering, a window of at least one unit per slot
+  static constexpr qint64 kReorderBudgetBytes = 512ll << 20;
+
+  FarmCoordinator();
+  ~FarmCoordinator();
+
+  /**
+   * @brief Accepts workers on @p port
+   * @return false on failure, see errorString()
+   */
+  bool listen(quint16 port);
+
+  /**
+   * @brief Renders @p job on the workers, blocking until it is written
+   * @return false on failure, see errorString(). A failed job leaves no
+   * file behind.
+   */
+  bool render(const RenderJob &job);
+
+  int workerCount() const { return static_cast<int>(m_workers.size()); }
+  QString errorString() const { return m_error; }
+
+private:
+  struct Worker {
+    QString name;
+    QByteArray buffer; // Received bytes not yet forming a message
+    bool ready = false; // Hello received
+    std::set<int> units;
+  };
+
+  // The job being rendered
+  struct Run {
+    const RenderJob *job = nullptr;
+    quint32 serial = 0;
+    std::vector<FractalState> states; // One per unit
+    QSize unitSize;
+    std::vector<qint32> orbits; // Shared orbit per unit, -1 for none
+    std::vector<int> attempts;
+    std::set<int> pending;
+    std::map<int, QByteArray> finished; // Waiting to be written
+    int nextToWrite = 0;
+
+    // Image tiles, collected one band at a time
+    int columns = 0;
+    std::vector<unsigned char> band;
+    StreamingImageWriter writer;
+
+    VideoEncoderPipe encoder;
+
+    bool done = false;
+    bool failed = false;
+  };
+
+  void acceptWorkers();
+  void receive(QTcpSocket *socket);
+  void dropWorker(QTcpSocket *socket);
+  // False on a protocol error
+  bool handle(QTcpSocket *socket, Worker &worker,
+              FarmProtocol::Message type, const QByteArray &payload);
+
+  // Splits the job into units and opens the output
+  bool prepare(Run &run);
+
+  // Shared orbit for @p state, computed if not cached yet
+  qint32 sharedOrbit(const FractalState &state);
+
+  // Hands pending units to workers with free slots
+  void dispatch();
+
+  // Requeues @p index, failing the run once it ran out of attempts
+  void retry(int index, const QString &reason);
+
+  // Stores a result and writes what is in order
+  void accept(int index, QByteArray rgb);
+
+  // Writes finished units in order, false on a write error
+  bool writeFinished();
+
+  // Adds unit @p index to the output
+  bool write(int index, const QByteArray &rgb);
+  void fail(const QString &message);
+
+  QTcpServer m_server;
+  std::map<QTcpSocket *, Worker> m_workers;
+  std::unique_ptr<Run> m_run;
+  QEventLoop m_loop;
+  quint32 m_jobSerial;
+
+  std::map<QString, qint32> m_orbitIds; // By center, depth and fractal
+  std::map<qint32, ReferenceOrbit> m_orbits;
+
+  QString m_error;
+};
+
+#endif // FARMCOORDINATOR_H
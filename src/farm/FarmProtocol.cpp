@@ -0,0 +1,241 @@
+#include "FarmProtocol.h"
+#include <QDataStream>
+#include <QIODevice>
+#include <algorithm>
+#include <utility>
+
+namespace FarmProtocol {
+
+namespace {
+constexpr QDataStream::Version kStreamVersion = QDataStream::Qt_6_0;
+
+// Length prefix and type byte
+constexpr int kHeaderBytes = 5;
+
+// Each 32-bit limb needs under 9.7 decimal digits
+QString centerString(const BigReal &value) {
+  return QString::fromStdString(value.toString(value.limbCount() * 10 + 2));
+}
+
+void writeCenter(QDataStream &stream, const BigReal &x, const BigReal &y) {
+  stream << qint32(std::max(x.limbCount(), y.limbCount())) << centerString(x)
+         << centerString(y);
+}
+
+bool readCenter(QDataStream &stream, BigReal &x, BigReal &y) {
+  qint32 limbs = 0;
+  QString textX;
+  QString textY;
+  stream >> limbs >> textX >> textY;
+  if (stream.status() != QDataStream::Ok || limbs <= 0 || limbs > 4096)
+    return false;
+  // Untrusted text, fromString() rejects what it cannot parse cheaply
+  bool okX = false;
+  bool okY = false;
+  x = BigReal::fromString(textX.toStdString(), limbs, &okX);
+  y = BigReal::fromString(textY.toStdString(), limbs, &okY);
+  return okX && okY;
+}
+
+void writeState(QDataStream &stream, const FractalState &state) {
+  stream << state.zoomSize << qint32(state.maxIterations)
+         << qint32(state.paletteId) << qint32(state.fractalType)
+         << state.juliaCx << state.juliaCy;
+  writeCenter(stream, state.deepCenterX, state.deepCenterY);
+}
+
+bool readState(QDataStream &stream, FractalState &state) {
+  qint32 maxIterations = 0;
+  qint32 paletteId = 0;
+  qint32 fractalType = 0;
+  stream >> state.zoomSize >> maxIterations >> paletteId >> fractalType >>
+      state.juliaCx >> state.juliaCy;
+  if (!readCenter(stream, state.deepCenterX, state.deepCenterY))
+    return false;
+  state.maxIterations = maxIterations;
+  state.paletteId = paletteId;
+  state.fractalType = fractalType;
+  state.zoomCenterX = state.deepCenterX.toDouble();
+  state.zoomCenterY = state.deepCenterY.toDouble();
+  return true;
+}
+
+template <class Write> QByteArray frame(Message type, Write write) {
+  QByteArray payload;
+  {
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(kStreamVersion);
+    write(stream);
+  }
+
+  QByteArray message;
+  {
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream << quint32(payload.size()) << quint8(type);
+  }
+  message.append(payload);
+  return message;
+}
+
+template <class Read> bool parse(const QByteArray &payload, Read read) {
+  QDataStream stream(payload);
+  stream.setVersion(kStreamVersion);
+  return read(stream) && stream.status() == QDataStream::Ok;
+}
+} // namespace
+
+QByteArray encode(const Hello &hello) {
+  return frame(Message::Hello, [&](QDataStream &stream) {
+    stream << hello.version << hello.host << hello.engine;
+  });
+}
+
+QByteArray encode(const Unit &unit) {
+  return frame(Message::Unit, [&](QDataStream &stream) {
+    stream << unit.job << unit.index << qint32(unit.size.width())
+           << qint32(unit.size.height()) << unit.supersample
+           << quint8(unit.engine) << unit.orbit;
+    writeState(stream, unit.state);
+  });
+}
+
+QByteArray encode(const OrbitRequest &request) {
+  return frame(Message::OrbitRequest,
+               [&](QDataStream &stream) { stream << request.orbit; });
+}
+
+QByteArray encode(const Orbit &orbit) {
+  return frame(Message::Orbit, [&](QDataStream &stream) {
+    const ReferenceOrbit &data = orbit.data;
+    stream << orbit.orbit << qint32(data.maxIterations())
+           << qint32(data.fractalType()) << data.juliaCx() << data.juliaCy()
+           << data.escaped();
+    writeCenter(stream, data.centerX(), data.centerY());
+
+    const std::vector<double> &points = data.pointsDouble();
+    stream << quint32(points.size());
+    for (double value : points)
+      stream << value;
+  });
+}
+
+QByteArray encode(const Result &result) {
+  return frame(Message::Result, [&](QDataStream &stream) {
+    // Fast compression, fractal images have long runs of the same color
+    stream << result.job << result.index << qint32(result.size.width())
+           << qint32(result.size.height()) << qCompress(result.rgb, 1);
+  });
+}
+
+QByteArray encode(const Failure &failure) {
+  return frame(Message::Failure, [&](QDataStream &stream) {
+    stream << failure.job << failure.index << failure.message;
+  });
+}
+
+bool takeMessage(QByteArray &buffer, Message &type, QByteArray &payload,
+                 bool &corrupt) {
+  corrupt = false;
+  if (buffer.size() < kHeaderBytes)
+    return false;
+
+  quint32 length = 0;
+  quint8 typeByte = 0;
+  {
+    QDataStream stream(buffer);
+    stream >> length >> typeByte;
+  }
+  if (length > kMaxPayloadBytes || typeByte < quint8(Message::Hello) ||
+      typeByte > quint8(Message::Failure)) {
+    corrupt = true;
+    return false;
+  }
+  if (buffer.size() - kHeaderBytes < static_cast<qsizetype>(length))
+    return false;
+
+  type = static_cast<Message>(typeByte);
+  payload = buffer.mid(kHeaderBytes, length);
+  buffer.remove(0, kHeaderBytes + length);
+  return true;
+}
+
+bool decode(const QByteArray &payload, Hello &hello) {
+  return parse(payload, [&](QDataStream &stream) {
+    stream >> hello.version >> hello.host >> hello.engine;
+    return true;
+  });
+}
+
+bool decode(const QByteArray &payload, Unit &unit) {
+  return parse(payload, [&](QDataStream &stream) {
+    qint32 width = 0;
+    qint32 height = 0;
+    quint8 engine = 0;
+    stream >> unit.job >> unit.index >> width >> height >> unit.supersample >>
+        engine >> unit.orbit;
+    if (engine > quint8(RenderJob::Engine::Cpu) ||
+        !readState(stream, unit.state))
+      return false;
+    unit.size = QSize(width, height);
+    unit.engine = static_cast<RenderJob::Engine>(engine);
+    return !unit.size.isEmpty();
+  });
+}
+
+bool decode(const QByteArray &payload, OrbitRequest &request) {
+  return parse(payload, [&](QDataStream &stream) {
+    stream >> request.orbit;
+    return true;
+  });
+}
+
+bool decode(const QByteArray &payload, Orbit &orbit) {
+  return parse(payload, [&](QDataStream &stream) {
+    qint32 maxIterations = 0;
+    qint32 fractalType = 0;
+    double juliaCx = 0.0;
+    double juliaCy = 0.0;
+    bool escaped = false;
+    BigReal centerX;
+    BigReal centerY;
+    stream >> orbit.orbit >> maxIterations >> fractalType >> juliaCx >>
+        juliaCy >> escaped;
+    if (!readCenter(stream, centerX, centerY))
+      return false;
+
+    quint32 count = 0;
+    stream >> count;
+    if (count > static_cast<quint32>(payload.size() / sizeof(double)))
+      return false;
+    std::vector<double> points(count);
+    for (double &value : points)
+      stream >> value;
+
+    orbit.data.assign(centerX, centerY, maxIterations, fractalType, juliaCx,
+                      juliaCy, escaped, std::move(points));
+    return true;
+  });
+}
+
+bool decode(const QByteArray &payload, Result &result) {
+  return parse(payload, [&](QDataStream &stream) {
+    qint32 width = 0;
+    qint32 height = 0;
+    QByteArray compressed;
+    stream >> result.job >> result.index >> width >> height >> compressed;
+    result.size = QSize(width, height);
+    result.rgb = qUncompress(compressed);
+    return !result.size.isEmpty() &&
+           result.rgb.size() ==
+               static_cast<qsizetype>(width) * height * 3;
+  });
+}
+
+bool decode(const QByteArray &payload, Failure &failure) {
+  return parse(payload, [&](QDataStream &stream) {
+    stream >> failure.job >> failure.index >> failure.message;
+    return true;
+  });
+}
+
+} // namespace FarmProtocol
@@ -0,0 +1,110 @@
+#ifndef FARMPROTOCOL_H
+#define FARMPROTOCOL_H
+
+#include "batch/JobFile.h"
+#include "core/FractalState.h"
+#include "core/ReferenceOrbit.h"
+#include <QByteArray>
+#include <QSize>
+#include <QString>
+
+/**
+ * @brief Messages between a farm coordinator and its workers
+ *
+ * Every message is a 32-bit big-endian payload length, a type byte and a
+ * QDataStream payload. Workers connect to the coordinator and introduce
+ * themselves with Hello, then receive Units and answer each with a Result
+ * or a Failure. A unit may name a shared reference orbit, which the worker
+ * fetches with an OrbitRequest unless it already holds it.
+ *
+ * Centers travel as decimal strings with a few digits more than their
+ * limbs resolve, so deep views arrive at full precision.
+ */
+namespace FarmProtocol {
+
+constexpr quint16 kDefaultPort = 7450;
+constexpr quint32 kVersion = 1;
+
+// Larger length prefixes are treated as a corrupt stream
+constexpr quint32 kMaxPayloadBytes = 1u << 30;
+
+enum class Message : quint8 {
+  Hello = 1,
+  Unit,
+  OrbitRequest,
+  Orbit,
+  Result,
+  Failure,
+};
+
+// Worker to coordinator, first message on a connection
+struct Hello {
+  quint32 version = kVersion;
+  QString host;
+  QString engine; // Engine the worker prefers, for logs
+};
+
+// Coordinator to worker: one view to render
+struct Unit {
+  quint32 job = 0;
+  qint32 index = 0;
+  FractalState state;
+  QSize size;
+  bool supersample = false;
+  RenderJob::Engine engine = RenderJob::Engine::Auto;
+  qint32 orbit = -1; // Shared reference orbit, -1 for none
+};
+
+// Worker to coordinator
+struct OrbitRequest {
+  qint32 orbit = -1;
+};
+
+// Coordinator to worker
+struct Orbit {
+  qint32 orbit = -1;
+  ReferenceOrbit data;
+};
+
+// Worker to coordinator: packed RGB8 of a unit, top row first
+struct Result {
+  quint32 job = 0;
+  qint32 index = 0;
+  QSize size;
+  QByteArray rgb; // Compressed on the wire only
+};
+
+// Worker to coordinator
+struct Failure {
+  quint32 job = 0;
+  qint32 index = 0;
+  QString message;
+};
+
+// Framed messages, ready to write to the socket
+QByteArray encode(const Hello &hello);
+QByteArray encode(const Unit &unit);
+QByteArray encode(const OrbitRequest &request);
+QByteArray encode(const Orbit &orbit);
+QByteArray encode(const Result &result);
+QByteArray encode(const Failure &failure);
+
+/**
+ * @brief Removes the first complete message from @p buffer
+ * @return false if @p buffer holds no complete message yet. Sets
+ * @p corrupt if it never will.
+ */
+bool takeMessage(QByteArray &buffer, Message &type, QByteArray &payload,
+                 bool &corrupt);
+
+// Parse a payload of the matching type, false if malformed
+bool decode(const QByteArray &payload, Hello &hello);
+bool decode(const QByteArray &payload, Unit &unit);
+bool decode(const QByteArray &payload, OrbitRequest &request);
+bool decode(const QByteArray &payload, Orbit &orbit);
+bool decode(const QByteArray &payload, Result &result);
+bool decode(const QByteArray &payload, Failure &failure);
+
+} // namespace FarmProtocol
+
+#endif // FARMPROTOCOL_H
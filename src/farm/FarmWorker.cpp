@@ -0,0 +1,153 @@
+#include "FarmWorker.h"
+#include <QAbstractSocket>
+#include <QOpenGLContext>
+#include <QSysInfo>
+#include <utility>
+#include <vector>
+
+FarmWorker::FarmWorker(BatchRenderer &renderer, RenderJob::Engine engine)
+    : m_renderer(renderer), m_engine(engine), m_orbitId(-1),
+      m_orbitReceived(false), m_unitsRendered(0) {}
+
+bool FarmWorker::run(const QString &host, quint16 port) {
+  m_error.clear();
+  m_socket.connectToHost(host, port);
+  if (!m_socket.waitForConnected(kConnectTimeoutMs)) {
+    m_error = QString("Cannot connect to %1:%2: %3")
+                  .arg(host)
+                  .arg(port)
+                  .arg(m_socket.errorString());
+    return false;
+  }
+  m_socket.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+
+  RenderJob::Engine preferred = m_engine;
+  if (preferred == RenderJob::Engine::Auto)
+    preferred = QOpenGLContext::currentContext() ? RenderJob::Engine::Gpu
+                                                 : RenderJob::Engine::Cpu;
+  FarmProtocol::Hello hello;
+  hello.host = QSysInfo::machineHostName();
+  hello.engine = JobFile::engineName(preferred);
+  if (!send(FarmProtocol::encode(hello)))
+    return false;
+
+  for (;;) {
+    // Only block when there is nothing to render
+    if (!receive(m_units.empty()))
+      return m_error.isEmpty();
+    if (m_units.empty())
+      continue;
+
+    const FarmProtocol::Unit unit = std::move(m_units.front());
+    m_units.pop_front();
+    renderUnit(unit);
+    if (!m_error.isEmpty())
+      return false;
+  }
+}
+
+bool FarmWorker::receive(bool wait) {
+  if (m_socket.bytesAvailable() == 0 && wait &&
+      !m_socket.waitForReadyRead(-1)) {
+    // A closed connection is the coordinator's way of saying it is done
+    if (m_socket.error() != QAbstractSocket::RemoteHostClosedError)
+      m_error = m_socket.errorString();
+    return false;
+  }
+  m_buffer.append(m_socket.readAll());
+
+  FarmProtocol::Message type;
+  QByteArray payload;
+  bool corrupt = false;
+  while (FarmProtocol::takeMessage(m_buffer, type, payload, corrupt)) {
+    if (type == FarmProtocol::Message::Unit) {
+      FarmProtocol::Unit unit;
+      if (!FarmProtocol::decode(payload, unit)) {
+        corrupt = true;
+        break;
+      }
+      m_units.push_back(std::move(unit));
+    } else if (type == FarmProtocol::Message::Orbit) {
+      FarmProtocol::Orbit orbit;
+      if (!FarmProtocol::decode(payload, orbit)) {
+        corrupt = true;
+        break;
+      }
+      m_orbitId = orbit.orbit;
+      m_orbit = std::move(orbit.data);
+      m_orbitReceived = true;
+    } else {
+      corrupt = true;
+      break;
+    }
+  }
+  if (corrupt) {
+    m_error = "Protocol error from the coordinator";
+    return false;
+  }
+  return m_socket.state() == QAbstractSocket::ConnectedState ||
+         m_socket.bytesAvailable() > 0;
+}
+
+bool FarmWorker::fetchOrbit(qint32 orbit) {
+  if (orbit == m_orbitId)
+    return true;
+
+  FarmProtocol::OrbitRequest request;
+  request.orbit = orbit;
+  if (!send(FarmProtocol::encode(request)))
+    return false;
+
+  // Units arriving meanwhile queue up behind the current one
+  m_orbitReceived = false;
+  while (!m_orbitReceived) {
+    if (!receive(true)) {
+      if (m_error.isEmpty())
+        m_error = "Connection closed while waiting for an orbit";
+      return false;
+    }
+  }
+  return m_orbitId == orbit;
+}
+
+bool FarmWorker::send(const QByteArray &message) {
+  m_socket.write(message);
+  while (m_socket.bytesToWrite() > 0) {
+    if (!m_socket.waitForBytesWritten(-1)) {
+      m_error = m_socket.errorString();
+      return false;
+    }
+  }
+  return true;
+}
+
+void FarmWorker::renderUnit(const FarmProtocol::Unit &unit) {
+  if (unit.orbit >= 0) {
+    if (!fetchOrbit(unit.orbit))
+      return;
+    // Set for every unit, the renderer may have replaced it since
+    m_renderer.setReferenceOrbit(m_orbit);
+  }
+
+  const RenderJob::Engine engine =
+      m_engine == RenderJob::Engine::Auto ? unit.engine : m_engine;
+  std::vector<unsigned char> rgb;
+  if (!m_renderer.renderView(unit.state, unit.size, unit.supersample, engine,
+                             rgb)) {
+    FarmProtocol::Failure failure;
+    failure.job = unit.job;
+    failure.index = unit.index;
+    failure.message = m_renderer.errorString();
+    send(FarmProtocol::encode(failure));
+    return;
+  }
+
+  FarmProtocol::Result result;
+  result.job = unit.job;
+  result.index = unit.index;
+  result.size = unit.size;
+  result.rgb = QByteArray(reinterpret_cast<const char *>(rgb.data()),
+                          static_cast<qsizetype>(rgb.size()));
+  if (send(FarmProtocol::encode(result)))
+    ++m_unitsRendered;
+}
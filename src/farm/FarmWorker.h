@@ -0,0 +1,68 @@
+#ifndef FARMWORKER_H
+#define FARMWORKER_H
+
+#include "FarmProtocol.h"
+#include "batch/BatchRenderer.h"
+#include <QByteArray>
+#include <QString>
+#include <QTcpSocket>
+#include <deque>
+
+/**
+ * @brief Renders the units a FarmCoordinator hands out
+ *
+ * Runs a blocking loop on the calling thread, which must have the GL
+ * context current for GPU units. Units are rendered in the order they
+ * arrive, through one BatchRenderer, so its renderers and buffers carry
+ * over from unit to unit. The last shared reference orbit is kept.
+ */
+class FarmWorker {
+public:
+  // Milliseconds to wait for the coordinator to accept the connection
+  static constexpr int kConnectTimeoutMs = 10000;
+
+  /**
+   * @param engine Engine for every unit, Auto to follow each job
+   */
+  explicit FarmWorker(BatchRenderer &renderer,
+                      RenderJob::Engine engine = RenderJob::Engine::Auto);
+
+  /**
+   * @brief Serves the coordinator at @p host : @p port until it closes the
+   * connection
+   * @return false if it could not be reached or the connection broke,
+   * see errorString()
+   */
+  bool run(const QString &host, quint16 port);
+
+  int unitsRendered() const { return m_unitsRendered; }
+  QString errorString() const { return m_error; }
+
+private:
+  /**
+   * @brief Reads the messages that arrived, waiting for one if @p wait
+   * @return false once the connection is closed or broken
+   */
+  bool receive(bool wait);
+
+  // Fetches the shared orbit @p orbit unless it is the current one
+  bool fetchOrbit(qint32 orbit);
+
+  bool send(const QByteArray &message);
+  void renderUnit(const FarmProtocol::Unit &unit);
+
+  BatchRenderer &m_renderer;
+  RenderJob::Engine m_engine;
+  QTcpSocket m_socket;
+  QByteArray m_buffer;
+  std::deque<FarmProtocol::Unit> m_units;
+
+  qint32 m_orbitId; // Of m_orbit, -1 for none
+  ReferenceOrbit m_orbit;
+  bool m_orbitReceived;
+
+  int m_unitsRendered;
+  QString m_error;
+};
+
+#endif // FARMWORKER_H
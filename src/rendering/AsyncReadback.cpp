@@ -0,0 +1,172 @@
+#include "AsyncReadback.h"
+#include <QOpenGLContext>
+#include <algorithm>
+
+namespace {
+// Longest single wait on a fence before re-checking, in nanoseconds
+constexpr GLuint64 kFenceTimeoutNs = 100000000;
+} // namespace
+
+AsyncReadback::AsyncReadback(Consumer consumer, int ringSize)
+    : m_consumer(std::move(consumer)), m_slots(std::max(1, ringSize)),
+      m_nextSlot(0), m_initialized(false), m_failed(false),
+      m_stopping(false) {}
+
+AsyncReadback::~AsyncReadback() {
+  if (!m_initialized)
+    return;
+
+  flush();
+  {
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_workAvailable.wakeAll();
+  }
+  m_worker->wait();
+
+  for (Slot &slot : m_slots)
+    glDeleteBuffers(1, &slot.buffer);
+}
+
+bool AsyncReadback::initialize() {
+  if (!QOpenGLContext::currentContext())
+    return false;
+  initializeOpenGLFunctions();
+
+  for (Slot &slot : m_slots)
+    glGenBuffers(1, &slot.buffer);
+
+  m_worker.reset(QThread::create([this]() { workerLoop(); }));
+  m_worker->start();
+  m_initialized = true;
+  return true;
+}
+
+void AsyncReadback::capture(GLuint fbo, const QRect &rect, quint64 tag) {
+  // The ring is used in order, so the next slot is also the oldest one
+  const int index = m_nextSlot;
+  Slot &slot = m_slots[index];
+  for (;;) {
+    {
+      QMutexLocker locker(&m_mutex);
+      if (slot.state == SlotState::Free)
+        break;
+    }
+    advance(true);
+  }
+
+  const GLsizeiptr size = static_cast<GLsizeiptr>(rect.width()) *
+                          rect.height() * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  if (size > slot.capacity) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    slot.capacity = size;
+  }
+
+  // With a pack buffer bound the read only records a GPU copy
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(rect.x(), rect.y(), rect.width(), rect.height(), GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  slot.frame = {nullptr, rect.width(), rect.height(), rect.width() * 4, tag};
+  {
+    QMutexLocker locker(&m_mutex);
+    slot.state = SlotState::Pending;
+  }
+  m_inFlight.push_back(index);
+  m_nextSlot = (index + 1) % static_cast<int>(m_slots.size());
+}
+
+void AsyncReadback::poll() { advance(false); }
+
+void AsyncReadback::flush() {
+  while (!m_inFlight.empty())
+    advance(true);
+}
+
+void AsyncReadback::advance(bool wait) {
+  // Map signaled readbacks and queue them for the worker, in capture order
+  for (int index : m_inFlight) {
+    Slot &slot = m_slots[index];
+    {
+      QMutexLocker locker(&m_mutex);
+      if (slot.state != SlotState::Pending)
+        continue;
+    }
+
+    // Only the oldest readback is worth blocking for
+    GLuint64 timeout =
+        wait && index == m_inFlight.front() ? kFenceTimeoutNs : 0;
+    GLenum status =
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (status == GL_TIMEOUT_EXPIRED)
+      break;
+    // The fence is unusable, drain the pipeline so the copy is complete
+    // before mapping
+    if (status == GL_WAIT_FAILED)
+      glFinish();
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const GLsizeiptr size =
+        static_cast<GLsizeiptr>(slot.frame.stride) * slot.frame.height;
+    slot.frame.pixels = static_cast<const unsigned char *>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    // The worker skips the frame, the slot is still freed in order
+    if (!slot.frame.pixels && !m_failed) {
+      m_failed = true;
+      m_error = "Failed to map a readback buffer";
+    }
+
+    QMutexLocker locker(&m_mutex);
+    slot.state = SlotState::Mapped;
+    m_workQueue.push_back(index);
+    m_workAvailable.wakeOne();
+  }
+
+  // Unmap and free consumed slots from the front
+  QMutexLocker locker(&m_mutex);
+  if (wait && !m_inFlight.empty()) {
+    while (m_slots[m_inFlight.front()].state == SlotState::Mapped)
+      m_workDone.wait(&m_mutex);
+  }
+  while (!m_inFlight.empty() &&
+         m_slots[m_inFlight.front()].state == SlotState::Consumed) {
+    Slot &slot = m_slots[m_inFlight.front()];
+    if (slot.frame.pixels) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    slot.frame.pixels = nullptr;
+    slot.state = SlotState::Free;
+    m_inFlight.pop_front();
+  }
+}
+
+void AsyncReadback::workerLoop() {
+  QMutexLocker locker(&m_mutex);
+  for (;;) {
+    while (m_workQueue.empty() && !m_stopping)
+      m_workAvailable.wait(&m_mutex);
+    if (m_workQueue.empty())
+      return;
+
+    const int index = m_workQueue.front();
+    m_workQueue.pop_front();
+    const Frame frame = m_slots[index].frame;
+
+    locker.unlock();
+    if (frame.pixels && m_consumer)
+      m_consumer(frame);
+    locker.relock();
+
+    m_slots[index].state = SlotState::Consumed;
+    m_workDone.wakeAll();
+  }
+}
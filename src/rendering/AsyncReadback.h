@@ -0,0 +1,113 @@
+#ifndef ASYNCREADBACK_H
+#define ASYNCREADBACK_H
+
+#include <QMutex>
+#include <QOpenGLExtraFunctions>
+#include <QRect>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Asynchronous framebuffer readback through a ring of PBOs
+ *
+ * capture() only queues a glReadPixels into a pixel pack buffer and a fence,
+ * so the copy of frame N overlaps the rendering of frame N+1. Once a fence
+ * has signaled, poll() maps the buffer and a worker thread runs the consumer
+ * on the mapped memory directly. The buffer is unmapped and reused after the
+ * consumer returns.
+ *
+ * Frames reach the consumer in capture order. Shared by every path that
+ * reads pixels back (poster export, video capture, benchmarks).
+ *
+ * All methods except the consumer run on the thread owning the GL context,
+ * with the context current. Destroy with the context current as well.
+ */
+class AsyncReadback : protected QOpenGLExtraFunctions {
+public:
+  static constexpr int kDefaultRingSize = 3;
+
+  /**
+   * @brief One captured image, valid only during the consumer call
+   *
+   * RGBA8 rows, bottom row first as OpenGL returns them.
+   */
+  struct Frame {
+    const unsigned char *pixels;
+    int width;
+    int height;
+    int stride; // Bytes per row
+    quint64 tag; // Passed through from capture()
+  };
+
+  // Runs on the worker thread
+  using Consumer = std::function<void(const Frame &frame)>;
+
+  explicit AsyncReadback(Consumer consumer, int ringSize = kDefaultRingSize);
+  ~AsyncReadback();
+
+  /**
+   * @brief Creates the pixel buffers and starts the worker
+   * @return false if the context lacks fence or PBO support
+   */
+  bool initialize();
+
+  /**
+   * @brief Queues a readback of @p rect (GL window coordinates) of @p fbo
+   *
+   * Only blocks if every buffer of the ring is still in flight.
+   */
+  void capture(GLuint fbo, const QRect &rect, quint64 tag = 0);
+
+  // Hands finished readbacks to the worker, call once per frame
+  void poll();
+
+  // Blocks until every captured frame has been consumed
+  void flush();
+
+  /**
+   * @brief True once a buffer could not be mapped
+   *
+   * Its frame never reaches the consumer, so the output has a gap. Stays
+   * set, check after poll() or flush().
+   */
+  bool hasFailed() const { return m_failed; }
+  QString errorString() const { return m_error; }
+
+private:
+  enum class SlotState { Free, Pending, Mapped, Consumed };
+
+  struct Slot {
+    GLuint buffer = 0;
+    GLsizeiptr capacity = 0;
+    GLsync fence = nullptr;
+    SlotState state = SlotState::Free;
+    Frame frame = {nullptr, 0, 0, 0, 0};
+  };
+
+  // Advances the oldest in-flight slots, optionally waiting for the first
+  void advance(bool wait);
+  void workerLoop();
+
+  Consumer m_consumer;
+  std::vector<Slot> m_slots;
+  std::deque<int> m_inFlight; // Slot indices in capture order
+  int m_nextSlot;
+  bool m_initialized;
+  bool m_failed;
+  QString m_error;
+
+  // Shared with the worker
+  QMutex m_mutex;
+  QWaitCondition m_workAvailable;
+  QWaitCondition m_workDone;
+  std::deque<int> m_workQueue;
+  bool m_stopping;
+  std::unique_ptr<QThread> m_worker;
+};
+
+#endif // ASYNCREADBACK_H
@@ -1,15 +1,41 @@
 #include "FractalGLWidget.h"
+#include "core/Formula.h"
+#include "export/PosterExporter.h"
+#include "export/VideoJourneyExporter.h"
 #include <QApplication>
 #include <QClipboard>
 #include <QDebug>
+#include <QDir>
+#include <QFileDialog>
+#include <QInputDialog>
 #include <QKeyEvent>
+#include <QMessageBox>
 #include <QMouseEvent>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QPainter>
+#include <QProgressDialog>
+#include <QStandardPaths>
 #include <QWheelEvent>
+#include <algorithm>
 #include <cmath>
 
+namespace {
+// Smoothing and friction constants were tuned per frame at this rate
+constexpr double kReferenceFrameTime = 0.016;
+
+// Longest physics step, so a stalled frame does not jump the view
+constexpr double kMaxFrameTime = 0.1;
+
+// Remaining motion below which the view snaps to its target
+constexpr double kSettleZoomRatio = 1e-5;
+constexpr double kSettlePixels = 0.01;
+} // namespace
+
 FractalGLWidget::FractalGLWidget(QWidget *parent)
-    : QOpenGLWidget(parent), m_vao(0), m_vbo(0), m_isDragging(false),
-      m_velocity(0, 0) {
+    : QOpenGLWidget(parent), m_hasRequested(false), m_animating(false),
+      m_supersample(false), m_adaptiveQuality(true), m_showStats(false),
+      m_isDragging(false), m_velocity(0, 0) {
 
   // Initialize state
   m_state = State();
@@ -19,201 +45,189 @@ FractalGLWidget::FractalGLWidget(QWidget *parent)
   setMouseTracking(true);
   setFocusPolicy(Qt::StrongFocus);
 
-  // Animation timer for 60 FPS
-  m_animationTimer = new QTimer(this);
-  connect(m_animationTimer, &QTimer::timeout, this, &FractalGLWidget::animate);
-  m_animationTimer->start(16); // ~60 FPS
+  // Animation frames are chained off the buffer swap, which v-sync paces.
+  // Nothing is scheduled while the view is at rest.
+  connect(this, &QOpenGLWidget::frameSwapped, this,
+          &FractalGLWidget::onFrameSwapped);
 
   m_frameTimer.start();
 }
 
 FractalGLWidget::~FractalGLWidget() {
+  // GL resources must be released with the context current
   makeCurrent();
-  if (m_vao)
-    glDeleteVertexArrays(1, &m_vao);
-  if (m_vbo)
-    glDeleteBuffers(1, &m_vbo);
+  m_renderThread.reset();
   doneCurrent();
 }
 
 void FractalGLWidget::initializeGL() {
-  initializeOpenGLFunctions();
-
-  // Load shaders
-  if (!m_shaderManager.loadFractalShader()) {
-    qCritical() << "Failed to load fractal shaders!";
-    return;
-  }
-
-  // Create full screen quad
-  GLfloat vertices[] = {
-      -1.0f, 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f,
-  };
-
-  glGenVertexArrays(1, &m_vao);
-  glBindVertexArray(m_vao);
-
-  glGenBuffers(1, &m_vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-  // Position attribute (location 0 in shader)
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(0);
-
-  // Create palette texture
-  createPaletteTexture();
-}
-
-void FractalGLWidget::resizeGL(int w, int h) {
-  // w and h are already multiplied by devicePixelRatio in QOpenGLWidget if set
-  // up correctly But we should rely on devicePixelRatio() for uniforms to be
-  // safe
-  glViewport(0, 0, w, h);
+  m_renderThread = std::make_unique<RenderThread>();
+
+  // Revisited views come from the tile cache, kept across sessions
+  const QString cacheDir =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  m_renderThread->enableTileCache(
+      !cacheDir.isEmpty() && QDir().mkpath(cacheDir)
+          ? QDir(cacheDir).filePath("tiles.bin")
+          : QString());
+
+  // Queued to the GUI thread, every finished frame gets presented
+  connect(m_renderThread.get(), &RenderThread::frameReady, this,
+          [this]() { update(); });
+  if (!m_renderThread->start(context()))
+    m_renderThread.reset();
 }
 
 void FractalGLWidget::paintGL() {
-  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT);
-
-  QOpenGLShaderProgram *program = m_shaderManager.getProgram();
-  if (!program || !program->bind())
-    return;
-
-  updateUniforms();
-
-  // Bind palette texture
-  if (m_paletteTexture) {
-    glActiveTexture(GL_TEXTURE0);
-    m_paletteTexture->bind();
-    program->setUniformValue("u_paletteTexture", 0);
+  QElapsedTimer cpuTimer;
+  cpuTimer.start();
+
+  double physicsMs = 0.0;
+  if (m_animating) {
+    double deltaTime = m_frameTimer.nsecsElapsed() * 1e-9;
+    m_frameTimer.restart();
+    m_animating = updatePhysics(std::min(deltaTime, kMaxFrameTime));
+    physicsMs = cpuTimer.nsecsElapsed() * 1e-6;
   }
 
-  glBindVertexArray(m_vao);
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-  program->release();
-}
-
-void FractalGLWidget::updateUniforms() {
-  QOpenGLShaderProgram *program = m_shaderManager.getProgram();
+  if (!m_renderThread)
+    return;
 
-  // Handle High-DPI: Use physical pixels for resolution
+  // Handle High-DPI: render at physical pixel resolution
   float dpr = devicePixelRatio();
-  program->setUniformValue("u_resolution",
-                           QVector2D(width() * dpr, height() * dpr));
-
-  // Zoom Center (Double Precision Emulation)
-  DoubleSplit centerX = splitDouble(m_state.zoomCenterX);
-  DoubleSplit centerY = splitDouble(m_state.zoomCenterY);
-  DoubleSplit zoomSize = splitDouble(m_state.zoomSize);
-
-  program->setUniformValue("u_zoomCenter_x_hi", centerX.hi);
-  program->setUniformValue("u_zoomCenter_x_lo", centerX.lo);
-  program->setUniformValue("u_zoomCenter_y_hi", centerY.hi);
-  program->setUniformValue("u_zoomCenter_y_lo", centerY.lo);
-  program->setUniformValue("u_zoomSize_hi", zoomSize.hi);
-  program->setUniformValue("u_zoomSize_lo", zoomSize.lo);
-
-  // Other uniforms
-  program->setUniformValue("u_maxIterations", m_state.maxIterations);
-  program->setUniformValue("u_paletteId", m_state.paletteId);
-  program->setUniformValue("u_fractalType", m_state.fractalType);
-  program->setUniformValue("u_juliaC",
-                           QVector2D(m_state.juliaCx, m_state.juliaCy));
-
-  // High precision flag - Enable much earlier to avoid pixelation
-  // Also ensure it's on for deep zooms
-  // DEBUG: Force true to verify if logic is the issue
-  bool highPrecision =
-      true; // m_state.zoomSize < 0.1 && m_state.fractalType < 2;
-  program->setUniformValue("u_highPrecision", highPrecision);
-
-  // DEBUG: Print split values for the coordinates causing issues
-  static int debugCounter = 0;
-  if (debugCounter++ % 300 == 0) { // Print every ~5 seconds
-    // Test coordinate from user report
-    double testVal = -0.9197790506151321;
-    DoubleSplit split = splitDouble(testVal);
-    qDebug() << "--- Split Logic Verification ---";
-    qDebug() << "Input:" << QString::number(testVal, 'g', 17);
-    qDebug() << "Hi:" << QString::number(split.hi, 'g', 9);
-    qDebug() << "Lo:" << QString::number(split.lo, 'g', 9);
-    qDebug() << "Reconstructed:"
-             << QString::number((double)split.hi + (double)split.lo, 'g', 17);
-    qDebug() << "Error:"
-             << QString::number(testVal - ((double)split.hi + (double)split.lo),
-                                'g', 17);
+  QSize pixelSize(qRound(width() * dpr), qRound(height() * dpr));
+
+  // Only a changed view wakes the render thread, presenting alone does not
+  RenderThread::Request request;
+  request.state = m_state;
+  request.size = pixelSize;
+  request.moving = m_animating || m_isDragging;
+  request.panning = isPanning();
+  request.supersample = m_supersample;
+  request.target = m_targetState;
+  request.frameBudgetMs =
+      m_adaptiveQuality ? QualityController::kDefaultFrameBudgetMs : 0.0;
+  if (!m_hasRequested || !request.sameAs(m_lastRequest)) {
+    m_renderThread->request(request);
+    m_lastRequest = request;
+    m_hasRequested = true;
   }
 
-  // DEBUG: Print split values for the coordinates causing issues
-  // static int debugCounter = 0; // This was moved above
-  if (debugCounter++ % 300 == 0) { // Print every ~5 seconds
-    qDebug() << "Center X:" << m_state.zoomCenterX;
-    qDebug() << "Split X:" << centerX.hi << centerX.lo;
-    qDebug() << "High Precision:" << highPrecision;
+  if (!m_renderThread->present(defaultFramebufferObject(), pixelSize)) {
+    QOpenGLFunctions *gl = context()->functions();
+    gl->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    gl->glClear(GL_COLOR_BUFFER_BIT);
   }
-}
 
-FractalGLWidget::DoubleSplit FractalGLWidget::splitDouble(double value) {
-  // Emulate splitDouble from JS/GLSL
-  // Simple cast method is most robust for passing double as two floats
-  float hi = static_cast<float>(value);
-  float lo = static_cast<float>(value - static_cast<double>(hi));
-  return {hi, lo};
+  // The overlay itself is not part of the measured frame. Render thread
+  // figures are only counted for the frame that first presents them.
+  const RenderThread::FrameInfo &info = m_renderThread->presentedInfo();
+  PerformanceMonitor::Sample sample;
+  sample.frameMs = cpuTimer.nsecsElapsed() * 1e-6;
+  sample.physicsMs = physicsMs;
+  if (m_renderThread->presentedFresh()) {
+    sample.iterationGpuMs = info.stats.iterationGpuMs;
+    sample.coloringGpuMs = info.stats.coloringGpuMs;
+    sample.pixelsIterated = info.stats.pixelsIterated;
+  }
+  sample.maxIterations =
+      info.maxIterations > 0 ? info.maxIterations : m_state.maxIterations;
+  sample.zoomSize = m_state.zoomSize;
+  sample.resolutionScale = info.resolutionScale;
+  sample.precision = info.precision;
+  m_performance.addFrame(sample);
+
+  if (m_showStats)
+    drawStatsOverlay();
 }
 
-void FractalGLWidget::createPaletteTexture() {
-  // Ported from generateFractalExtremePalette in script.js
-  // Generates the "Extreme" palette texture (ID 4)
-  // For other palettes, the shader uses cosine gradients, but ID 4 needs this
-  // texture
+void FractalGLWidget::drawStatsOverlay() {
+  const RenderThread::FrameInfo &info = m_renderThread->presentedInfo();
+  const PerformanceMonitor::Summary summary = m_performance.summary();
+  auto gpuMs = [](double ms) {
+    return ms < 0.0 ? QString("n/a") : QString("%1 ms").arg(ms, 0, 'f', 2);
+  };
 
-  struct ColorStop {
-    float pos;
-    int r, g, b;
+  QStringList lines = {
+      QString("Fractal: %1").arg(Formula::name(m_state.fractalType)),
+      QString("Zoom: %1").arg(m_state.zoomSize, 0, 'g', 6),
+      QString("Iterations: %1%2")
+          .arg(info.maxIterations > 0 ? info.maxIterations
+                                      : m_state.maxIterations)
+          .arg(m_adaptiveQuality ? " (auto)" : ""),
+      QString("Precision: %1").arg(PrecisionPolicy::name(info.precision)),
+      QString("Resolution: %1x").arg(info.resolutionScale),
+      QString("Temporal samples: %1").arg(info.stats.temporalSamples),
+      QString("Orbit textures: %1 MB")
+          .arg(info.stats.orbitBytes / (1024.0 * 1024.0), 0, 'f', 1),
+      QString("FPS: %1").arg(summary.fps, 0, 'f', 1),
+      QString("CPU: %1 ms (physics %2 ms)")
+          .arg(summary.frameMs, 0, 'f', 2)
+          .arg(summary.physicsMs, 0, 'f', 2),
+      QString("GPU: iterate %1, color %2")
+          .arg(gpuMs(summary.iterationGpuMs), gpuMs(summary.coloringGpuMs)),
+      QString("Throughput: %1 Giter/s")
+          .arg(summary.iterationsPerSecond * 1e-9, 0, 'f', 2),
   };
-  std::vector<ColorStop> stops = {
-      {0.00f, 0, 0, 0},       {0.05f, 25, 7, 26},     {0.10f, 9, 1, 47},
-      {0.15f, 4, 4, 73},      {0.20f, 0, 7, 100},     {0.25f, 12, 44, 138},
-      {0.30f, 24, 82, 177},   {0.35f, 57, 125, 209},  {0.40f, 134, 181, 229},
-      {0.45f, 211, 236, 248}, {0.50f, 241, 233, 191}, {0.55f, 248, 201, 95},
-      {0.60f, 255, 170, 0},   {0.65f, 240, 126, 13},  {0.70f, 204, 71, 10},
-      {0.75f, 158, 1, 66},    {0.80f, 110, 0, 95},    {0.85f, 106, 0, 168},
-      {0.90f, 77, 16, 140},   {0.95f, 45, 20, 80},    {1.00f, 0, 0, 0}};
-
-  const int textureSize = 2048;
-  QImage image(textureSize, 1, QImage::Format_RGBA8888);
-
-  for (int i = 0; i < textureSize; ++i) {
-    float t = static_cast<float>(i) / (textureSize - 1);
-
-    // Find stops
-    ColorStop lower = stops.front();
-    ColorStop upper = stops.back();
-
-    for (size_t j = 0; j < stops.size() - 1; ++j) {
-      if (t >= stops[j].pos && t <= stops[j + 1].pos) {
-        lower = stops[j];
-        upper = stops[j + 1];
-        break;
-      }
-    }
+  if (m_performance.isTracing())
+    lines << QString("Recording trace: %1 frames")
+                 .arg(m_performance.traceLength());
+
+  QPainter painter(this);
+  QFont font = painter.font();
+  font.setPointSize(Style::Typography::FONT_SIZE_SM);
+  painter.setFont(font);
+
+  const QFontMetrics metrics(font);
+  int textWidth = 0;
+  for (const QString &line : lines)
+    textWidth = std::max(textWidth, metrics.horizontalAdvance(line));
+
+  const int padding = Style::Spacing::SM;
+  const QRect panel(Style::Spacing::MD, Style::Spacing::MD,
+                    textWidth + 2 * padding,
+                    metrics.height() * lines.size() + 2 * padding);
+  QColor background = Style::Colors::SURFACE_CONTAINER;
+  background.setAlpha(200);
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(background);
+  painter.drawRoundedRect(panel, Style::BorderRadius::SM,
+                          Style::BorderRadius::SM);
+
+  painter.setPen(Style::Colors::ON_SURFACE);
+  int y = panel.top() + padding + metrics.ascent();
+  for (const QString &line : lines) {
+    painter.drawText(panel.left() + padding, y, line);
+    y += metrics.height();
+  }
+}
 
-    float localT = (t - lower.pos) / (upper.pos - lower.pos);
-    float smoothT = localT * localT * (3 - 2 * localT); // Smoothstep
+bool FractalGLWidget::isPanning() const {
+  return m_isDragging || m_velocity.manhattanLength() > 0.0 ||
+         centerLagPixels() > kSettlePixels;
+}
 
-    int r = std::round(lower.r + (upper.r - lower.r) * smoothT);
-    int g = std::round(lower.g + (upper.g - lower.g) * smoothT);
-    int b = std::round(lower.b + (upper.b - lower.b) * smoothT);
+double FractalGLWidget::centerLagPixels() const {
+  // Measured in logical pixels, the difference in arbitrary precision
+  double pixelToFractal = m_state.zoomSize / std::max(1, height());
+  double dx = (m_targetState.deepCenterX - m_state.deepCenterX).toDouble();
+  double dy = (m_targetState.deepCenterY - m_state.deepCenterY).toDouble();
+  return std::max(std::abs(dx), std::abs(dy)) / pixelToFractal;
+}
 
-    image.setPixelColor(i, 0, QColor(r, g, b, 255));
+void FractalGLWidget::startAnimation() {
+  if (!m_animating) {
+    m_animating = true;
+    m_frameTimer.restart();
   }
+  update();
+}
 
-  m_paletteTexture = std::make_unique<QOpenGLTexture>(image);
-  m_paletteTexture->setMinificationFilter(QOpenGLTexture::Linear);
-  m_paletteTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-  m_paletteTexture->setWrapMode(QOpenGLTexture::Repeat);
+void FractalGLWidget::onFrameSwapped() {
+  // Refinement needs no frames here, the render thread's frameReady()
+  // schedules those
+  if (m_animating)
+    update();
 }
 
 // Mouse event handlers
@@ -226,6 +240,8 @@ void FractalGLWidget::mousePressEvent(QMouseEvent *event) {
     // Sync target to current when starting drag to avoid jumps
     m_targetState.zoomCenterX = m_state.zoomCenterX;
     m_targetState.zoomCenterY = m_state.zoomCenterY;
+    m_targetState.deepCenterX = m_state.deepCenterX;
+    m_targetState.deepCenterY = m_state.deepCenterY;
   }
 }
 
@@ -239,13 +255,14 @@ void FractalGLWidget::mouseMoveEvent(QMouseEvent *event) {
     double pixelToFractal = m_state.zoomSize / height();
 
     // Direct manipulation for immediate response during drag
-    m_state.zoomCenterX -= delta.x() * pixelToFractal;
-    m_state.zoomCenterY +=
-        delta.y() * pixelToFractal; // Y is inverted in fractal space
+    m_state.translate(-delta.x() * pixelToFractal,
+                      delta.y() * pixelToFractal); // Y is inverted in fractal space
 
     // Update target too so it doesn't drift back
     m_targetState.zoomCenterX = m_state.zoomCenterX;
     m_targetState.zoomCenterY = m_state.zoomCenterY;
+    m_targetState.deepCenterX = m_state.deepCenterX;
+    m_targetState.deepCenterY = m_state.deepCenterY;
 
     // Update velocity for momentum - smoother calculation
     // Use a simple low-pass filter or just the raw delta
@@ -259,6 +276,9 @@ void FractalGLWidget::mouseMoveEvent(QMouseEvent *event) {
 void FractalGLWidget::mouseReleaseEvent(QMouseEvent *event) {
   if (event->button() == Qt::LeftButton) {
     m_isDragging = false;
+
+    // Hand over to momentum panning
+    startAnimation();
   }
 }
 
@@ -278,84 +298,278 @@ void FractalGLWidget::wheelEvent(QWheelEvent *event) {
   double relY = mousePos.y() - height() / 2.0;
   double pixelToFractal = m_targetState.zoomSize / height();
 
-  double mouseFractalX = m_targetState.zoomCenterX + relX * pixelToFractal;
-  double mouseFractalY = m_targetState.zoomCenterY - relY * pixelToFractal;
-
   // Update TARGET zoom size
   m_targetState.zoomSize *= zoomFactor;
 
-  // Calculate new target center to keep mouse position fixed
+  // Shift the target center to keep mouse position fixed. Applied as an
+  // offset so the arbitrary-precision center keeps its low bits.
   double newPixelToFractal = m_targetState.zoomSize / height();
-  m_targetState.zoomCenterX = mouseFractalX - relX * newPixelToFractal;
-  m_targetState.zoomCenterY = mouseFractalY + relY * newPixelToFractal;
+  double shift = pixelToFractal - newPixelToFractal;
+  m_targetState.translate(relX * shift, -relY * shift);
 
-  // Don't call update() here, let animate() handle the interpolation
+  // Animation frames interpolate towards the new target
+  startAnimation();
 }
 
 void FractalGLWidget::keyPressEvent(QKeyEvent *event) {
+  // Enough digits to pin the center to well below one pixel
+  int digits = 16 + std::max(0, static_cast<int>(-std::log10(m_state.zoomSize)));
+  QString deepX = QString::fromStdString(m_state.deepCenterX.toString(digits));
+  QString deepY = QString::fromStdString(m_state.deepCenterY.toString(digits));
+
   if (event->key() == Qt::Key_P) {
     qDebug() << "--- Debug Coordinates ---";
-    qDebug() << "X:" << QString::number(m_state.zoomCenterX, 'g', 16);
-    qDebug() << "Y:" << QString::number(m_state.zoomCenterY, 'g', 16);
+    qDebug() << "X:" << deepX;
+    qDebug() << "Y:" << deepY;
     qDebug() << "Zoom:" << QString::number(m_state.zoomSize, 'g', 16);
-    qDebug() << "High Precision:" << (m_state.zoomSize < 0.1);
+    if (m_renderThread)
+      qDebug() << "Precision:"
+               << PrecisionPolicy::name(
+                      m_renderThread->presentedInfo().precision);
     qDebug() << "-------------------------";
   }
   if (event->key() == Qt::Key_C) {
     QString coords = QString("X: %1\nY: %2\nZoom: %3")
-                         .arg(QString::number(m_state.zoomCenterX, 'g', 16))
-                         .arg(QString::number(m_state.zoomCenterY, 'g', 16))
+                         .arg(deepX)
+                         .arg(deepY)
                          .arg(QString::number(m_state.zoomSize, 'g', 16));
 
     QApplication::clipboard()->setText(coords);
     qDebug() << "Coordinates copied to clipboard!";
   }
+  if (event->key() >= Qt::Key_0 && event->key() <= Qt::Key_9) {
+    // Palette only affects the coloring pass, no re-iteration needed
+    m_state.paletteId = event->key() - Qt::Key_0;
+    m_targetState.paletteId = m_state.paletteId;
+    update();
+  }
+  if (event->key() == Qt::Key_F) {
+    // Next formula at the same view, Shift goes back
+    const int step = event->modifiers() & Qt::ShiftModifier
+                         ? Formula::kCount - 1
+                         : 1;
+    m_state.fractalType = (m_state.fractalType + step) % Formula::kCount;
+    m_targetState.fractalType = m_state.fractalType;
+    qDebug() << "Fractal:" << Formula::name(m_state.fractalType);
+    update();
+  }
+  if (event->key() == Qt::Key_S) {
+    // Supersampling is the last refinement step at rest
+    m_supersample = !m_supersample;
+    qDebug() << "Supersampling:" << m_supersample;
+    update();
+  }
+  if (event->key() == Qt::Key_A) {
+    // Off renders every view at the fixed maxIterations
+    m_adaptiveQuality = !m_adaptiveQuality;
+    qDebug() << "Adaptive quality:" << m_adaptiveQuality;
+    update();
+  }
+  if (event->key() == Qt::Key_I) {
+    m_showStats = !m_showStats;
+    update();
+  }
+  if (event->key() == Qt::Key_T) {
+    toggleTrace();
+  }
+  if (event->key() == Qt::Key_E) {
+    exportPoster();
+  }
+  if (event->key() == Qt::Key_V) {
+    exportVideo();
+  }
   QOpenGLWidget::keyPressEvent(event);
 }
 
-// Animation loop
-void FractalGLWidget::animate() {
-  // Use fixed time step for physics to avoid instability
-  updatePhysics(0.016); // ~60 FPS
+bool FractalGLWidget::updatePhysics(double deltaTime) {
+  // Per-frame constants below are rescaled to the real step, so the motion
+  // is the same at any frame rate
+  double frames = deltaTime / kReferenceFrameTime;
 
-  // Always update for smooth zoom interpolation
-  update();
-}
-
-void FractalGLWidget::updatePhysics(double deltaTime) {
   // 1. Smooth Zoom Interpolation
   // Interpolate zoom size (logarithmic interpolation would be better, but
   // linear on value is okay for small steps) Using exponential smoothing:
   // current += (target - current) * factor
-  double smoothFactor = 0.08; // Slightly smoother than 0.1
+  double smoothFactor =
+      1.0 - std::pow(1.0 - 0.08, frames); // Slightly smoother than 0.1
 
   m_state.zoomSize +=
       (m_targetState.zoomSize - m_state.zoomSize) * smoothFactor;
-  m_state.zoomCenterX +=
-      (m_targetState.zoomCenterX - m_state.zoomCenterX) * smoothFactor;
-  m_state.zoomCenterY +=
-      (m_targetState.zoomCenterY - m_state.zoomCenterY) * smoothFactor;
+
+  // Difference taken in arbitrary precision, it is tiny at deep zoom
+  double centerDx =
+      (m_targetState.deepCenterX - m_state.deepCenterX).toDouble();
+  double centerDy =
+      (m_targetState.deepCenterY - m_state.deepCenterY).toDouble();
+  m_state.translate(centerDx * smoothFactor, centerDy * smoothFactor);
 
   // 2. Momentum Panning
   if (!m_isDragging && m_velocity.manhattanLength() > 0.1) {
     double pixelToFractal = m_state.zoomSize / height();
 
     // Apply velocity to BOTH current and target to maintain momentum
-    double dx = m_velocity.x() * pixelToFractal;
-    double dy = m_velocity.y() * pixelToFractal;
+    double dx = m_velocity.x() * pixelToFractal * frames;
+    double dy = m_velocity.y() * pixelToFractal * frames;
 
-    m_state.zoomCenterX -= dx;
-    m_state.zoomCenterY += dy;
-    m_targetState.zoomCenterX -= dx;
-    m_targetState.zoomCenterY += dy;
+    m_state.translate(-dx, dy);
+    m_targetState.translate(-dx, dy);
 
     // Apply friction - tune this for "sacred smoothness"
     // 0.95 is smoother/longer slide than 0.9
-    m_velocity *= 0.92;
+    m_velocity *= std::pow(0.92, frames);
 
     // Stop if velocity is very small
     if (m_velocity.manhattanLength() < 0.1) {
       m_velocity = QPointF(0, 0);
     }
+  } else if (!m_isDragging) {
+    // A release after a tiny drag never starts momentum
+    m_velocity = QPointF(0, 0);
+  }
+
+  // 3. Snap to the target once the remaining motion is invisible, which
+  // lets the frame chain stop
+  bool zoomSettled = std::abs(m_targetState.zoomSize - m_state.zoomSize) <=
+                     kSettleZoomRatio * m_state.zoomSize;
+  if (!zoomSettled || isPanning())
+    return true;
+
+  m_state.zoomSize = m_targetState.zoomSize;
+  m_state.deepCenterX = m_targetState.deepCenterX;
+  m_state.deepCenterY = m_targetState.deepCenterY;
+  m_state.zoomCenterX = m_targetState.zoomCenterX;
+  m_state.zoomCenterY = m_targetState.zoomCenterY;
+  return false;
+}
+
+void FractalGLWidget::toggleTrace() {
+  if (!m_performance.isTracing()) {
+    m_performance.startTrace();
+    qDebug() << "Recording performance trace";
+    update();
+    return;
   }
+
+  m_performance.stopTrace();
+  update();
+  QString path = QFileDialog::getSaveFileName(
+      this, "Save Performance Trace", "fractonaut_trace.csv",
+      "Traces (*.csv *.json)");
+  if (path.isEmpty())
+    return;
+
+  if (m_performance.saveTrace(path))
+    qDebug() << "Performance trace saved to" << path;
+  else
+    QMessageBox::warning(this, "Save Performance Trace",
+                         m_performance.errorString());
+}
+
+FractalState FractalGLWidget::exportState() const {
+  FractalState state = m_state;
+  if (m_adaptiveQuality && m_renderThread &&
+      m_renderThread->presentedInfo().maxIterations > 0)
+    state.maxIterations = m_renderThread->presentedInfo().maxIterations;
+  return state;
+}
+
+void FractalGLWidget::exportPoster() {
+  QString path = QFileDialog::getSaveFileName(
+      this, "Export Poster", "fractonaut.png", "Images (*.png *.tif *.tiff)");
+  if (path.isEmpty())
+    return;
+
+  const QStringList sizes = {"3840x2160", "7680x4320", "16384x9216",
+                             "16384x16384", "32768x32768"};
+  bool ok = false;
+  QString size = QInputDialog::getItem(this, "Export Poster", "Size:", sizes,
+                                       0, false, &ok);
+  if (!ok)
+    return;
+
+  PosterExporter::Settings settings;
+  settings.width = size.section('x', 0, 0).toInt();
+  settings.height = size.section('x', 1, 1).toInt();
+  settings.supersample = m_supersample;
+
+  QProgressDialog progress("Rendering poster...", "Cancel", 0, 1, this);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(0);
+
+  // Shares the widget's context, every pass binds its own framebuffer
+  makeCurrent();
+  PosterExporter exporter;
+  bool exported = exporter.exportImage(
+      exportState(), settings, path,
+      [this, &progress](int tilesDone, int tileCount) {
+        progress.setMaximum(tileCount);
+        progress.setValue(tilesDone);
+        // setValue() processes events, a repaint may leave another
+        // context current
+        makeCurrent();
+        return !progress.wasCanceled();
+      });
+  doneCurrent();
+
+  if (exported)
+    qDebug() << "Poster exported to" << path;
+  else if (!progress.wasCanceled())
+    QMessageBox::warning(this, "Export Poster", exporter.errorString());
+}
+
+void FractalGLWidget::exportVideo() {
+  QString path = QFileDialog::getSaveFileName(
+      this, "Export Video", "fractonaut_journey.mp4",
+      "Videos (*.mp4 *.mkv *.mov)");
+  if (path.isEmpty())
+    return;
+
+  const QStringList formats = {"1280x720 @ 30", "1920x1080 @ 30",
+                               "1920x1080 @ 60", "3840x2160 @ 30"};
+  bool ok = false;
+  QString format = QInputDialog::getItem(this, "Export Video", "Format:",
+                                         formats, 1, false, &ok);
+  if (!ok)
+    return;
+  double duration = QInputDialog::getDouble(this, "Export Video",
+                                            "Duration (seconds):", 30.0, 1.0,
+                                            600.0, 1, &ok);
+  if (!ok)
+    return;
+
+  VideoJourneyExporter::Settings settings;
+  QString size = format.section(' ', 0, 0);
+  settings.width = size.section('x', 0, 0).toInt();
+  settings.height = size.section('x', 1, 1).toInt();
+  settings.fps = format.section(' ', 2, 2).toInt();
+  settings.durationSeconds = duration;
+  settings.supersample = m_supersample;
+
+  QProgressDialog progress("Rendering video...", "Cancel", 0, 1, this);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(0);
+
+  // Shares the widget's context, every pass binds its own framebuffer
+  makeCurrent();
+  VideoJourneyExporter exporter;
+  bool exported = exporter.exportVideo(
+      exportState(), settings, path,
+      [this, &progress](int framesRendered, int framesEncoded,
+                        int frameCount) {
+        progress.setLabelText(QString("Rendered %1, encoded %2 of %3 frames")
+                                  .arg(framesRendered)
+                                  .arg(framesEncoded)
+                                  .arg(frameCount));
+        progress.setMaximum(frameCount);
+        progress.setValue(framesRendered);
+        // As for posters, events may have switched the context
+        makeCurrent();
+        return !progress.wasCanceled();
+      });
+  doneCurrent();
+
+  if (exported)
+    qDebug() << "Video exported to" << path;
+  else if (!progress.wasCanceled())
+    QMessageBox::warning(this, "Export Video", exporter.errorString());
 }
@@ -2,20 +2,21 @@
 #define FRACTALGLWIDGET_H
 
 #include "Constants.h"
-#include "ShaderManager.h"
+#include "PerformanceMonitor.h"
+#include "RenderThread.h"
+#include "core/FractalState.h"
 #include <QElapsedTimer>
-#include <QOpenGLFunctions>
-#include <QOpenGLTexture>
 #include <QOpenGLWidget>
-#include <QTimer>
+#include <memory>
 
 /**
  * @brief Main OpenGL widget for rendering fractals
  *
- * Handles the rendering loop, shader uniforms, and palette texture generation.
- * Implements the core rendering logic ported from WebGL.
+ * Handles user interaction and the physics of the view on the GUI thread.
+ * Rendering runs on a RenderThread, each frame here only hands over the
+ * current state and presents the newest finished frame.
  */
-class FractalGLWidget : public QOpenGLWidget, protected QOpenGLFunctions {
+class FractalGLWidget : public QOpenGLWidget {
   Q_OBJECT
 
 public:
@@ -24,7 +25,6 @@ public:
 
 protected:
   void initializeGL() override;
-  void resizeGL(int w, int h) override;
   void paintGL() override;
 
   // Mouse interaction
@@ -35,29 +35,54 @@ protected:
   void keyPressEvent(QKeyEvent *event) override;
 
 private slots:
-  void animate();
+  // Chains the next animation frame while the view is still moving
+  void onFrameSwapped();
 
 private:
-  void createPaletteTexture();
-  void updateUniforms();
-  void updatePhysics(double deltaTime);
-
-  // Helper to split double for emulated precision (Dekker's algorithm)
-  struct DoubleSplit {
-    float hi;
-    float lo;
-  };
-  DoubleSplit splitDouble(double value);
-
-  // Rendering resources
-  ShaderManager m_shaderManager;
-  std::unique_ptr<QOpenGLTexture> m_paletteTexture;
-  QTimer *m_animationTimer;
-  QElapsedTimer m_frameTimer;
-
-  // Full screen quad buffers
-  GLuint m_vao;
-  GLuint m_vbo;
+  /**
+   * @brief Advances smoothing and momentum by @p deltaTime seconds
+   * @return false once the view has settled on its target
+   */
+  bool updatePhysics(double deltaTime);
+
+  // Schedules frames until updatePhysics() reports the view settled
+  void startAnimation();
+
+  // True while the center is moving, lets the renderer reproject pans
+  bool isPanning() const;
+
+  // Distance between current and target center in logical pixels
+  double centerLagPixels() const;
+
+  // View and timing stats in the top left corner
+  void drawStatsOverlay();
+
+  // Starts a timing trace, or stops it and asks where to save it
+  void toggleTrace();
+
+  // The current view at the iterations it was last presented with
+  FractalState exportState() const;
+
+  // Asks for a file and size, then renders the current view as a poster
+  void exportPoster();
+
+  // Asks for a file, format and duration, then renders a zoom journey from
+  // the default view into the current one
+  void exportVideo();
+
+  // Rendering, started once the GL context exists
+  std::unique_ptr<RenderThread> m_renderThread;
+  RenderThread::Request m_lastRequest;
+  bool m_hasRequested;
+
+  QElapsedTimer m_frameTimer; // Time since the last physics step
+  bool m_animating;
+  bool m_supersample;
+  bool m_adaptiveQuality; // Iterations and resolution follow a frame budget
+  bool m_showStats;
+
+  // Frame timings for the overlay and traces
+  PerformanceMonitor m_performance;
 
   // Interaction state
   bool m_isDragging;
@@ -65,16 +90,7 @@ private:
   QPointF m_velocity;
 
   // State
-  struct State {
-    double zoomCenterX = -0.5;
-    double zoomCenterY = 0.0;
-    double zoomSize = 3.0;
-    int maxIterations = 500;
-    int paletteId = 0;
-    int fractalType = 0; // 0: Mandelbrot
-    double juliaCx = -0.7269;
-    double juliaCy = 0.1889;
-  };
+  using State = FractalState;
 
   State m_state;       // Current state (rendered)
   State m_targetState; // Target state (for smooth interpolation)
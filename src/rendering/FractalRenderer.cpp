@@ -0,0 +1,1009 @@
+#include "FractalRenderer.h"
+#include "core/Formula.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLVersionFunctionsFactory>
+#include <QVector2D>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+// Texture units, shared by both passes
+constexpr int kPaletteUnit = 0;
+constexpr int kOrbitUnit = 1;
+constexpr int kIterationUnit = 2;
+constexpr int kBoundaryRowsUnit = 3;
+constexpr int kBoundaryColumnsUnit = 4;
+constexpr int kTileUnit = 5;
+
+// Rows of the first tile while the cost per pixel is still unknown
+constexpr int kInitialTileRows = 64;
+
+// Startup fp64 probe, small enough to stay far below any GPU watchdog even
+// at consumer double rates
+constexpr int kDoubleProbeSize = 128;
+constexpr int kDoubleProbeIterations = 1000;
+
+// Float storage so the smooth iteration count survives unquantized
+std::unique_ptr<QOpenGLFramebufferObject>
+createIterationBuffer(const QSize &size) {
+  return std::make_unique<QOpenGLFramebufferObject>(
+      size, QOpenGLFramebufferObject::NoAttachment, GL_TEXTURE_2D, GL_RGBA32F);
+}
+
+// Radical inverse of @p index in @p base, the Halton sequence
+double halton(int index, int base) {
+  double result = 0.0;
+  double fraction = 1.0;
+  for (; index > 0; index /= base) {
+    fraction /= base;
+    result += fraction * (index % base);
+  }
+  return result;
+}
+
+// Sub-pixel offset of temporal sample @p index, sample 0 is the pixel center.
+// Halton (2, 3) fills the pixel evenly for any sample count.
+QVector2D jitterOffset(int index) {
+  if (index == 0)
+    return QVector2D();
+  return QVector2D(static_cast<float>(halton(index, 2) - 0.5),
+                   static_cast<float>(halton(index, 3) - 0.5));
+}
+} // namespace
+
+FractalRenderer::FractalRenderer()
+    : m_doubleFunctions(nullptr), m_palettes(Palette::builtIn()), m_vao(0),
+      m_vbo(0), m_precisionMode(PrecisionPolicy::Mode::Float),
+      m_iterationValid(false), m_interactive(false), m_resolutionScale(1.0f),
+      m_maxTextureSize(0), m_boundaryFill(true), m_boundaryActive(false),
+      m_frameBudgetMs(kDefaultFrameBudgetMs), m_msPerPixel(0.0),
+      m_cacheFillQueued(false), m_temporalSamples(0), m_accumulatedSamples(0),
+      m_sampleRowsDone(0) {}
+
+FractalRenderer::~FractalRenderer() {
+  if (m_vao)
+    glDeleteVertexArrays(1, &m_vao);
+  if (m_vbo)
+    glDeleteBuffers(1, &m_vbo);
+}
+
+bool FractalRenderer::initialize() {
+  initializeOpenGLFunctions();
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
+
+  // Build the default view's variants, the others follow on first use
+  if (!m_shaderManager.iterationProgram(0, PrecisionPolicy::Mode::Float)) {
+    qCritical() << "Failed to load fractal shaders!";
+    return false;
+  }
+  if (!m_shaderManager.colorProgram(0)) {
+    qCritical() << "Failed to load coloring shaders!";
+    return false;
+  }
+
+  // Create full screen quad
+  GLfloat vertices[] = {
+      -1.0f, 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f,
+  };
+
+  glGenVertexArrays(1, &m_vao);
+  glBindVertexArray(m_vao);
+
+  glGenBuffers(1, &m_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+  // Position attribute (location 0 in shader)
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+  glEnableVertexAttribArray(0);
+
+  // Upload the palette atlas
+  createPaletteTexture();
+  m_orbitTextures.initialize();
+
+  if (!m_gpuTimer.initialize())
+    qDebug() << "GPU timer queries unavailable";
+
+#ifndef __APPLE__
+  // Optional, the emulated path covers the same range. macOS drivers have
+  // no fast fp64 path, so it is not even tried there.
+  m_doubleFunctions =
+      QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_4_0_Core>(
+          QOpenGLContext::currentContext());
+  if (m_doubleFunctions && m_doubleFunctions->initializeOpenGLFunctions() &&
+      m_shaderManager.supportsNativeDouble())
+    m_precisionPolicy.setNativeDoubleSupported(nativeDoubleIsFaster());
+#endif
+  m_tilePolicy.setNativeDoubleSupported(
+      m_precisionPolicy.nativeDoubleSupported());
+  return true;
+}
+
+void FractalRenderer::precompileShaders(QOffscreenSurface *surface) {
+  m_shaderManager.precompileVariants(m_precisionPolicy.nativeDoubleSupported(),
+                                     surface);
+}
+
+bool FractalRenderer::nativeDoubleIsFaster() {
+  // Seahorse valley, inside the range both direct double paths cover
+  FractalState probe;
+  probe.zoomCenterX = -0.743643887037151;
+  probe.zoomCenterY = 0.131825904205330;
+  probe.deepCenterX = BigReal(probe.zoomCenterX);
+  probe.deepCenterY = BigReal(probe.zoomCenterY);
+  probe.zoomSize = 1e-4;
+  probe.maxIterations = kDoubleProbeIterations;
+
+  const QSize size(kDoubleProbeSize, kDoubleProbeSize);
+  std::unique_ptr<QOpenGLFramebufferObject> saved =
+      std::move(m_iterationBuffer);
+  m_iterationBuffer = createIterationBuffer(size);
+  const bool savedBoundary = m_boundaryActive;
+  m_boundaryActive = false;
+
+  double elapsedMs[2] = {0.0, 0.0};
+  const PrecisionPolicy::Mode modes[2] = {PrecisionPolicy::Mode::DoubleFloat,
+                                          PrecisionPolicy::Mode::Double};
+  for (int i = 0; i < 2; ++i) {
+    m_precisionMode = modes[i];
+
+    // The first draw of a program may include deferred compilation
+    iterate(probe, size, QRect(0, 0, kDoubleProbeSize, 1));
+    glFinish();
+
+    QElapsedTimer timer;
+    timer.start();
+    iterate(probe, size);
+    glFinish();
+    elapsedMs[i] = timer.nsecsElapsed() * 1e-6;
+  }
+
+  m_iterationBuffer = std::move(saved);
+  m_boundaryActive = savedBoundary;
+  m_precisionMode = PrecisionPolicy::Mode::Float;
+  m_iterationValid = false;
+
+  return elapsedMs[1] < elapsedMs[0];
+}
+
+void FractalRenderer::render(const FractalState &state, const QSize &size,
+                             GLuint targetFbo) {
+  if (size.isEmpty())
+    return;
+
+  collectPrefetchedOrbit();
+
+  // Rounded up so every target pixel has a texel to read
+  QSize bufferSize(
+      static_cast<int>(std::ceil(size.width() * m_resolutionScale)),
+      static_cast<int>(std::ceil(size.height() * m_resolutionScale)));
+  if (bufferSize.width() > m_maxTextureSize ||
+      bufferSize.height() > m_maxTextureSize)
+    bufferSize = size;
+
+  if (!m_iterationBuffer || m_iterationBuffer->size() != bufferSize) {
+    std::unique_ptr<QOpenGLFramebufferObject> buffer =
+        createIterationBuffer(bufferSize);
+
+    // Until its tiles arrive, show the same view at the old resolution
+    buffer->bind();
+    if (m_iterationBuffer && m_iterationValid &&
+        state.sameIterationInputs(m_iteratedState)) {
+      QOpenGLFramebufferObject::blitFramebuffer(
+          buffer.get(), m_iterationBuffer.get(), GL_COLOR_BUFFER_BIT,
+          GL_NEAREST);
+    } else {
+      glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    m_iterationBuffer = std::move(buffer);
+    m_spareIterationBuffer.reset();
+    m_iterationValid = false;
+  }
+
+  if (!m_iterationValid || !state.sameIterationInputs(m_iteratedState)) {
+    if (!m_iterationValid || !reproject(state, bufferSize))
+      queueView(state, bufferSize);
+    m_iterationValid = true;
+  }
+
+  m_gpuTimer.beginFrame();
+  m_frameStats.iterationGpuMs = m_gpuTimer.milliseconds(GpuTimer::Iteration);
+  m_frameStats.coloringGpuMs = m_gpuTimer.milliseconds(GpuTimer::Coloring);
+
+  // Accumulation only refines views at rest, once they are complete
+  const bool accumulating =
+      m_temporalSamples > 1 && !m_interactive && m_pendingTiles.empty();
+
+  m_frameStats.pixelsIterated = 0;
+  if (!m_pendingTiles.empty()) {
+    m_gpuTimer.begin(GpuTimer::Iteration);
+    m_frameStats.pixelsIterated = iteratePendingTiles(bufferSize);
+    m_gpuTimer.end(GpuTimer::Iteration);
+  } else if (accumulating && accumulationCurrent(state, size) &&
+             hasAccumulationWork()) {
+    m_gpuTimer.begin(GpuTimer::Iteration);
+    m_frameStats.pixelsIterated = iterateSample(bufferSize);
+    m_gpuTimer.end(GpuTimer::Iteration);
+  }
+
+  // Once the view is complete, its tiles go to the cache in idle time
+  if (m_tileCache && !m_interactive && m_pendingTiles.empty() &&
+      !m_cacheFillQueued) {
+    queueCacheFill(m_iteratedState, bufferSize);
+    m_cacheFillQueued = true;
+  }
+
+  m_gpuTimer.begin(GpuTimer::Coloring);
+  if (accumulating) {
+    accumulate(state, size, targetFbo);
+  } else {
+    m_accumulatedSamples = 0;
+    colorize(state, size, targetFbo, *m_iterationBuffer);
+  }
+  m_gpuTimer.end(GpuTimer::Coloring);
+  m_frameStats.temporalSamples = m_accumulatedSamples;
+  m_frameStats.orbitBytes = m_orbitTextures.bytes();
+}
+
+void FractalRenderer::probe(const FractalState &state, const QSize &size,
+                            std::vector<float> &data) {
+  if (!m_probeBuffer || m_probeBuffer->size() != size)
+    m_probeBuffer = createIterationBuffer(size);
+
+  // The probe picks its own mode and orbit like a cache tile, without the
+  // view's boundary samples
+  const PrecisionPolicy::Mode viewMode = m_precisionMode;
+  const bool viewBoundary = m_boundaryActive;
+  m_boundaryActive = false;
+  m_tilePolicy.reset();
+  m_precisionMode = m_tilePolicy.update(state, size.height());
+
+  iterate(state, size, QRect(), IterationPass::Full, m_probeBuffer.get(),
+          QVector2D(), OrbitOwner::OffView);
+
+  const size_t pixels = static_cast<size_t>(size.width()) * size.height();
+  std::vector<float> texels(pixels * 4);
+  glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_FLOAT,
+               texels.data());
+  data.resize(pixels * 2);
+  for (size_t i = 0; i < pixels; ++i) {
+    data[2 * i] = texels[4 * i];
+    data[2 * i + 1] = texels[4 * i + 1];
+  }
+
+  m_precisionMode = viewMode;
+  m_boundaryActive = viewBoundary;
+}
+
+void FractalRenderer::setTemporalSamples(int samples) {
+  m_temporalSamples = std::clamp(samples, 0, kMaxTemporalSamples);
+  if (m_temporalSamples <= 1) {
+    m_accumulatedSamples = 0;
+    m_accumulationBuffer.reset();
+    m_sampleBuffer.reset();
+  }
+}
+
+bool FractalRenderer::enableTileCache(const QString &diskPath) {
+  auto cache = std::make_unique<TileCache>();
+  if (!cache->initialize())
+    return false;
+  if (!diskPath.isEmpty())
+    cache->openDiskTier(diskPath);
+  m_tileCache = std::move(cache);
+  m_cacheFill.clear();
+  m_cacheFillQueued = false;
+  return true;
+}
+
+void FractalRenderer::runBackgroundWork() {
+  QElapsedTimer frameTimer;
+  frameTimer.start();
+
+  // Tiles are iterated in their own mode and orbit and without the boundary
+  // fill, whose samples belong to the view
+  const PrecisionPolicy::Mode viewMode = m_precisionMode;
+  const bool viewBoundary = m_boundaryActive;
+  m_boundaryActive = false;
+  const QSize tileSize(TileCache::kTileSize, TileCache::kTileSize);
+
+  while (!m_cacheFill.empty()) {
+    double remainingMs = m_frameBudgetMs - frameTimer.nsecsElapsed() * 1e-6;
+    if (m_frameBudgetMs > 0.0 && remainingMs <= 0.0)
+      break;
+
+    CacheFillTile &tile = m_cacheFill.front();
+    if (tile.rowsDone == 0 && m_tileCache->contains(tile.key)) {
+      m_cacheFill.pop_front();
+      continue;
+    }
+    QOpenGLFramebufferObject *target = m_tileCache->beginTile(tile.key);
+    if (!target) {
+      m_cacheFill.clear();
+      break;
+    }
+
+    int rows = tileSize.height() - tile.rowsDone;
+    if (m_frameBudgetMs > 0.0) {
+      int affordable = kInitialTileRows;
+      if (m_msPerPixel > 0.0)
+        affordable = static_cast<int>(std::min<double>(
+            remainingMs / (m_msPerPixel * tileSize.width()), rows));
+      rows = std::clamp(affordable, 1, rows);
+    }
+
+    m_tilePolicy.reset();
+    m_precisionMode = m_tilePolicy.update(tile.state, tileSize.height());
+
+    QElapsedTimer tileTimer;
+    tileTimer.start();
+    iterate(tile.state, tileSize,
+            QRect(0, tile.rowsDone, tileSize.width(), rows),
+            IterationPass::Full, target, QVector2D(), OrbitOwner::OffView);
+    glFinish();
+    double tilePerPixel =
+        tileTimer.nsecsElapsed() * 1e-6 / (tileSize.width() * rows);
+    m_msPerPixel = m_msPerPixel > 0.0 ? 0.5 * (m_msPerPixel + tilePerPixel)
+                                      : tilePerPixel;
+
+    tile.rowsDone += rows;
+    if (tile.rowsDone == tileSize.height()) {
+      m_tileCache->finishTile();
+      m_cacheFill.pop_front();
+    }
+  }
+
+  m_precisionMode = viewMode;
+  m_boundaryActive = viewBoundary;
+}
+
+void FractalRenderer::queueView(const FractalState &state,
+                                const QSize &size) {
+  m_iteratedState = state;
+  m_precisionMode = m_precisionPolicy.update(state, size.height());
+  m_pendingTiles.clear();
+  dropCacheFill();
+
+  if (composeFromCache(state, size)) {
+    m_boundaryActive = false;
+    return;
+  }
+
+  // One sample past the last cell on each axis, so every cell is closed
+  const int cellsX = (size.width() + kBoundaryStep - 1) / kBoundaryStep;
+  const int cellsY = (size.height() + kBoundaryStep - 1) / kBoundaryStep;
+  const QSize rowsSize(cellsX * kBoundaryStep + 1, cellsY + 1);
+  const QSize columnsSize(cellsX + 1, cellsY * kBoundaryStep + 1);
+
+  // Sierpinski has no interior to skip, Burning Ship and Tricorn have holes
+  m_boundaryActive = m_boundaryFill &&
+                     Formula::hasNoHoles(state.fractalType) &&
+                     rowsSize.width() <= m_maxTextureSize &&
+                     columnsSize.height() <= m_maxTextureSize;
+  if (m_boundaryActive) {
+    if (!m_boundaryRows || m_boundaryRows->size() != rowsSize) {
+      m_boundaryRows = createIterationBuffer(rowsSize);
+      m_boundaryColumns = createIterationBuffer(columnsSize);
+    }
+    m_boundaryOrigin = QPoint(0, 0);
+    m_pendingTiles.push_back(
+        {QRect(QPoint(0, 0), rowsSize), IterationPass::BoundaryRows});
+    m_pendingTiles.push_back(
+        {QRect(QPoint(0, 0), columnsSize), IterationPass::BoundaryColumns});
+  }
+  m_pendingTiles.push_back(
+      {QRect(0, 0, size.width(), size.height()), IterationPass::Full});
+}
+
+qint64 FractalRenderer::iteratePendingTiles(const QSize &size) {
+  QElapsedTimer frameTimer;
+  frameTimer.start();
+  qint64 pixels = 0;
+
+  while (!m_pendingTiles.empty()) {
+    double remainingMs = m_frameBudgetMs - frameTimer.nsecsElapsed() * 1e-6;
+    if (m_frameBudgetMs > 0.0 && remainingMs <= 0.0)
+      break;
+
+    // Cut the largest band of rows that should fit the remaining budget,
+    // but always make progress by at least one row
+    QRect &pending = m_pendingTiles.front().rect;
+    int rows = pending.height();
+    if (m_frameBudgetMs > 0.0) {
+      int affordable = kInitialTileRows;
+      if (m_msPerPixel > 0.0)
+        affordable = static_cast<int>(std::min<double>(
+            remainingMs / (m_msPerPixel * pending.width()), rows));
+      rows = std::clamp(affordable, 1, rows);
+    }
+    QRect tile(pending.x(), pending.y(), pending.width(), rows);
+
+    QElapsedTimer tileTimer;
+    tileTimer.start();
+    iterate(m_iteratedState, size, tile, m_pendingTiles.front().pass);
+    pixels += static_cast<qint64>(tile.width()) * tile.height();
+
+    // Wait for the GPU so the measured time is the real cost of the tile
+    glFinish();
+    double tilePerPixel =
+        tileTimer.nsecsElapsed() * 1e-6 / (tile.width() * tile.height());
+    m_msPerPixel = m_msPerPixel > 0.0 ? 0.5 * (m_msPerPixel + tilePerPixel)
+                                      : tilePerPixel;
+
+    if (rows == pending.height())
+      m_pendingTiles.pop_front();
+    else
+      pending.setTop(pending.y() + rows);
+  }
+  return pixels;
+}
+
+void FractalRenderer::iterate(const FractalState &state, const QSize &size,
+                              const QRect &region, IterationPass pass,
+                              QOpenGLFramebufferObject *target,
+                              const QVector2D &jitter, OrbitOwner owner) {
+  QOpenGLShaderProgram *program = iterationProgram(state);
+  if (!program || !program->bind())
+    return;
+
+  if (!target) {
+    target = m_iterationBuffer.get();
+    if (pass == IterationPass::BoundaryRows)
+      target = m_boundaryRows.get();
+    else if (pass == IterationPass::BoundaryColumns)
+      target = m_boundaryColumns.get();
+  }
+  target->bind();
+  glViewport(0, 0, target->width(), target->height());
+
+  // The quad still covers the whole view, the scissor limits which
+  // fragments actually iterate
+  if (!region.isEmpty()) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(region.x(), region.y(), region.width(), region.height());
+  }
+
+  updateUniforms(state, size, owner);
+
+  // The sample passes write the textures the main pass reads
+  const bool fill = m_boundaryActive && pass == IterationPass::Full;
+  glActiveTexture(GL_TEXTURE0 + kBoundaryRowsUnit);
+  glBindTexture(GL_TEXTURE_2D, fill ? m_boundaryRows->texture() : 0);
+  glActiveTexture(GL_TEXTURE0 + kBoundaryColumnsUnit);
+  glBindTexture(GL_TEXTURE_2D, fill ? m_boundaryColumns->texture() : 0);
+  program->setUniformValue("u_boundaryRows", kBoundaryRowsUnit);
+  program->setUniformValue("u_boundaryColumns", kBoundaryColumnsUnit);
+  program->setUniformValue("u_boundaryStep",
+                           m_boundaryActive ? kBoundaryStep : 0);
+  program->setUniformValue("u_boundaryPass", static_cast<int>(pass));
+  program->setUniformValue("u_boundaryOrigin",
+                           QVector2D(m_boundaryOrigin.x(),
+                                     m_boundaryOrigin.y()));
+  program->setUniformValue("u_jitter", jitter);
+
+  glBindVertexArray(m_vao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  if (!region.isEmpty())
+    glDisable(GL_SCISSOR_TEST);
+
+  program->release();
+}
+
+bool FractalRenderer::reproject(const FractalState &state, const QSize &size) {
+  if (!state.sameIterationParameters(m_iteratedState))
+    return false;
+
+  // Pan in physical pixels, the difference is taken in arbitrary precision
+  const int width = size.width();
+  const int height = size.height();
+  const double pixelSize = state.zoomSize / height;
+  const double shiftX =
+      (state.deepCenterX - m_iteratedState.deepCenterX).toDouble() / pixelSize;
+  const double shiftY =
+      (state.deepCenterY - m_iteratedState.deepCenterY).toDouble() / pixelSize;
+  const double roundedX = std::round(shiftX);
+  const double roundedY = std::round(shiftY);
+
+  if (std::abs(roundedX) >= width || std::abs(roundedY) >= height)
+    return false;
+  if (!m_interactive && (std::abs(shiftX - roundedX) > kReprojectionTolerance ||
+                         std::abs(shiftY - roundedY) > kReprojectionTolerance))
+    return false;
+
+  const int dx = static_cast<int>(roundedX);
+  const int dy = static_cast<int>(roundedY);
+  if (dx == 0 && dy == 0)
+    return true;
+
+  // The buffer will hold the old view moved by exactly (dx, dy) pixels
+  FractalState shifted = state;
+  shifted.deepCenterX = m_iteratedState.deepCenterX;
+  shifted.deepCenterY = m_iteratedState.deepCenterY;
+  shifted.translate(dx * pixelSize, dy * pixelSize);
+
+  // new(x, y) = old(x + dx, y + dy) over the region both views share
+  const int keepX0 = std::max(0, -dx);
+  const int keepX1 = std::min(width, width - dx);
+  const int keepY0 = std::max(0, -dy);
+  const int keepY1 = std::min(height, height - dy);
+
+  if (!m_spareIterationBuffer)
+    m_spareIterationBuffer = createIterationBuffer(size);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_iterationBuffer->handle());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_spareIterationBuffer->handle());
+  glBlitFramebuffer(keepX0 + dx, keepY0 + dy, keepX1 + dx, keepY1 + dy, keepX0,
+                    keepY0, keepX1, keepY1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  std::swap(m_iterationBuffer, m_spareIterationBuffer);
+
+  // Unfinished tiles move with the image. Boundary samples stay where they
+  // are, only their origin moves.
+  const QRect bounds(0, 0, width, height);
+  std::deque<IterationTile> stillPending;
+  for (const IterationTile &tile : m_pendingTiles) {
+    if (tile.pass != IterationPass::Full) {
+      stillPending.push_back(tile);
+      continue;
+    }
+    QRect moved = tile.rect.translated(-dx, -dy).intersected(bounds);
+    if (!moved.isEmpty())
+      stillPending.push_back({moved, IterationPass::Full});
+  }
+  m_pendingTiles.swap(stillPending);
+  m_boundaryOrigin -= QPoint(dx, dy);
+
+  // Exposed columns span the full height, exposed rows only the kept columns
+  if (dx != 0)
+    m_pendingTiles.push_back(
+        {QRect(dx > 0 ? keepX1 : 0, 0, std::abs(dx), height),
+         IterationPass::Full});
+  if (dy != 0)
+    m_pendingTiles.push_back(
+        {QRect(keepX0, dy > 0 ? keepY1 : 0, keepX1 - keepX0, std::abs(dy)),
+         IterationPass::Full});
+
+  m_iteratedState = shifted;
+  dropCacheFill();
+  return true;
+}
+
+bool FractalRenderer::composeFromCache(const FractalState &state,
+                                       const QSize &size) {
+  TileCache::Cover cover;
+  std::vector<GLuint> textures;
+  if (!m_tileCache || !TileCache::cover(state, size, cover) ||
+      !m_tileCache->acquire(cover.keys, textures))
+    return false;
+
+  QOpenGLShaderProgram *program = m_shaderManager.tileProgram();
+  if (!program || !program->bind())
+    return false;
+
+  m_iterationBuffer->bind();
+  glViewport(0, 0, size.width(), size.height());
+  glEnable(GL_SCISSOR_TEST);
+  glActiveTexture(GL_TEXTURE0 + kTileUnit);
+  program->setUniformValue("u_tile", kTileUnit);
+  program->setUniformValue("u_texelsPerPixel",
+                           static_cast<float>(cover.texelsPerPixel));
+  glBindVertexArray(m_vao);
+
+  // Each tile owns the pixels whose centers fall into it
+  auto firstPixel = [](double edge) {
+    return static_cast<int>(std::ceil(edge - 0.5));
+  };
+  for (int row = 0; row < cover.rows; ++row) {
+    const double y = cover.originY + row * cover.tilePixels;
+    const int y0 = std::max(0, firstPixel(y));
+    const int y1 = std::min(size.height(), firstPixel(y + cover.tilePixels));
+    for (int column = 0; column < cover.columns; ++column) {
+      const double x = cover.originX + column * cover.tilePixels;
+      const int x0 = std::max(0, firstPixel(x));
+      const int x1 = std::min(size.width(), firstPixel(x + cover.tilePixels));
+
+      glScissor(x0, y0, x1 - x0, y1 - y0);
+      glBindTexture(GL_TEXTURE_2D, textures[row * cover.columns + column]);
+      program->setUniformValue("u_tileOrigin", QVector2D(x, y));
+      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+  }
+
+  glDisable(GL_SCISSOR_TEST);
+  program->release();
+  return true;
+}
+
+void FractalRenderer::queueCacheFill(const FractalState &state,
+                                     const QSize &size) {
+  // A view needing more tiles than the GPU holds could never be assembled
+  TileCache::Cover cover;
+  if (!TileCache::cover(state, size, cover) ||
+      static_cast<int>(cover.keys.size()) >= m_tileCache->gpuCapacity())
+    return;
+
+  for (const TileKey &key : cover.keys)
+    if (!m_tileCache->contains(key))
+      m_cacheFill.push_back({key, TileCache::tileState(state, key), 0});
+}
+
+void FractalRenderer::dropCacheFill() {
+  m_cacheFillQueued = false;
+  if (!m_cacheFill.empty() && m_cacheFill.front().rowsDone > 0)
+    m_cacheFill.erase(m_cacheFill.begin() + 1, m_cacheFill.end());
+  else
+    m_cacheFill.clear();
+}
+
+void FractalRenderer::colorize(const FractalState &state, const QSize &size,
+                               GLuint targetFbo,
+                               const QOpenGLFramebufferObject &iterations,
+                               float weight) {
+  glBindFramebuffer(GL_FRAMEBUFFER, targetFbo);
+  glViewport(0, 0, size.width(), size.height());
+  if (weight >= 1.0f) {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+  }
+
+  QOpenGLShaderProgram *program =
+      m_shaderManager.colorProgram(state.fractalType);
+  if (!program || !program->bind())
+    return;
+
+  program->setUniformValue("u_maxIterations", state.maxIterations);
+
+  const QSize bufferSize = iterations.size();
+  program->setUniformValue(
+      "u_bufferScale",
+      QVector2D(static_cast<float>(bufferSize.width()) / size.width(),
+                static_cast<float>(bufferSize.height()) / size.height()));
+
+  glActiveTexture(GL_TEXTURE0 + kIterationUnit);
+  glBindTexture(GL_TEXTURE_2D, iterations.texture());
+  program->setUniformValue("u_iterationTexture", kIterationUnit);
+
+  // Sierpinski always reads the Extreme row, its palette ID shifts the phase
+  const int count = static_cast<int>(m_palettes.size());
+  const int paletteId = std::clamp(state.paletteId, 0, count - 1);
+  const int layer = state.fractalType == Formula::Sierpinski
+                        ? std::min(Palette::kExtremeId, count - 1)
+                        : paletteId;
+  program->setUniformValue("u_paletteLayer", layer);
+  program->setUniformValue("u_paletteCycle", m_palettes[layer].cycleLength);
+  program->setUniformValue("u_palettePhase", static_cast<float>(paletteId));
+
+  if (m_paletteTexture) {
+    glActiveTexture(GL_TEXTURE0 + kPaletteUnit);
+    m_paletteTexture->bind();
+    program->setUniformValue("u_palettes", kPaletteUnit);
+  }
+
+  // Running average: the new color weighs in with 1 / samples
+  if (weight < 1.0f) {
+    glEnable(GL_BLEND);
+    glBlendColor(0.0f, 0.0f, 0.0f, weight);
+    glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+  }
+
+  glBindVertexArray(m_vao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  if (weight < 1.0f)
+    glDisable(GL_BLEND);
+  program->release();
+}
+
+qint64 FractalRenderer::iterateSample(const QSize &size) {
+  if (!m_sampleBuffer || m_sampleBuffer->size() != size) {
+    m_sampleBuffer = createIterationBuffer(size);
+    m_sampleRowsDone = 0;
+  }
+
+  QElapsedTimer frameTimer;
+  frameTimer.start();
+  qint64 pixels = 0;
+  const QVector2D jitter = jitterOffset(m_accumulatedSamples);
+
+  // The boundary samples still hold, the shader iterates the pixels a
+  // jitter can move off them
+  while (m_sampleRowsDone < size.height()) {
+    double remainingMs = m_frameBudgetMs - frameTimer.nsecsElapsed() * 1e-6;
+    if (m_frameBudgetMs > 0.0 && remainingMs <= 0.0)
+      break;
+
+    int rows = size.height() - m_sampleRowsDone;
+    if (m_frameBudgetMs > 0.0) {
+      int affordable = kInitialTileRows;
+      if (m_msPerPixel > 0.0)
+        affordable = static_cast<int>(std::min<double>(
+            remainingMs / (m_msPerPixel * size.width()), rows));
+      rows = std::clamp(affordable, 1, rows);
+    }
+    QRect tile(0, m_sampleRowsDone, size.width(), rows);
+
+    QElapsedTimer tileTimer;
+    tileTimer.start();
+    iterate(m_iteratedState, size, tile, IterationPass::Full,
+            m_sampleBuffer.get(), jitter);
+    pixels += static_cast<qint64>(tile.width()) * tile.height();
+
+    glFinish();
+    double tilePerPixel =
+        tileTimer.nsecsElapsed() * 1e-6 / (tile.width() * tile.height());
+    m_msPerPixel = m_msPerPixel > 0.0 ? 0.5 * (m_msPerPixel + tilePerPixel)
+                                      : tilePerPixel;
+
+    m_sampleRowsDone += rows;
+  }
+  return pixels;
+}
+
+void FractalRenderer::accumulate(const FractalState &state, const QSize &size,
+                                 GLuint targetFbo) {
+  if (!accumulationCurrent(state, size)) {
+    // Blending needs more than 8 bits to keep 1 / 16 steps
+    if (!m_accumulationBuffer || m_accumulationBuffer->size() != size)
+      m_accumulationBuffer = std::make_unique<QOpenGLFramebufferObject>(
+          size, QOpenGLFramebufferObject::NoAttachment, GL_TEXTURE_2D,
+          GL_RGBA16F);
+    colorize(state, size, m_accumulationBuffer->handle(), *m_iterationBuffer);
+    m_accumulatedState = state;
+    m_accumulatedSamples = 1;
+    m_sampleRowsDone = 0;
+  } else if (m_sampleBuffer &&
+             m_sampleRowsDone == m_sampleBuffer->height()) {
+    ++m_accumulatedSamples;
+    colorize(state, size, m_accumulationBuffer->handle(), *m_sampleBuffer,
+             1.0f / m_accumulatedSamples);
+    m_sampleRowsDone = 0;
+  }
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_accumulationBuffer->handle());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFbo);
+  glBlitFramebuffer(0, 0, size.width(), size.height(), 0, 0, size.width(),
+                    size.height(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, targetFbo);
+}
+
+bool FractalRenderer::accumulationCurrent(const FractalState &state,
+                                          const QSize &size) const {
+  return m_accumulatedSamples > 0 && m_accumulationBuffer &&
+         m_accumulationBuffer->size() == size &&
+         state.sameIterationInputs(m_accumulatedState) &&
+         state.paletteId == m_accumulatedState.paletteId;
+}
+
+QOpenGLShaderProgram *
+FractalRenderer::iterationProgram(const FractalState &state) {
+  return m_shaderManager.iterationProgram(state.fractalType, m_precisionMode);
+}
+
+void FractalRenderer::updateUniforms(const FractalState &state,
+                                     const QSize &size, OrbitOwner owner) {
+  QOpenGLShaderProgram *program = iterationProgram(state);
+
+  // Physical pixels, the caller already applied the device pixel ratio
+  program->setUniformValue("u_resolution",
+                           QVector2D(size.width(), size.height()));
+
+  // Zoom Center (Double Precision Emulation)
+  DoubleSplit centerX = splitDouble(state.zoomCenterX);
+  DoubleSplit centerY = splitDouble(state.zoomCenterY);
+  DoubleSplit zoomSize = splitDouble(state.zoomSize);
+
+  program->setUniformValue("u_zoomCenter_x_hi", centerX.hi);
+  program->setUniformValue("u_zoomCenter_x_lo", centerX.lo);
+  program->setUniformValue("u_zoomCenter_y_hi", centerY.hi);
+  program->setUniformValue("u_zoomCenter_y_lo", centerY.lo);
+  program->setUniformValue("u_zoomSize_hi", zoomSize.hi);
+  program->setUniformValue("u_zoomSize_lo", zoomSize.lo);
+
+  // Other uniforms
+  program->setUniformValue("u_maxIterations", state.maxIterations);
+  program->setUniformValue("u_juliaC",
+                           QVector2D(state.juliaCx, state.juliaCy));
+
+  // The program is specialized for the mode, only its inputs are set here
+  using Mode = PrecisionPolicy::Mode;
+  if (m_precisionMode == Mode::Double) {
+    m_doubleFunctions->glUniform2d(program->uniformLocation("u_zoomCenter"),
+                                   state.zoomCenterX, state.zoomCenterY);
+    m_doubleFunctions->glUniform1d(program->uniformLocation("u_zoomSize"),
+                                   state.zoomSize);
+  }
+
+  double periodFloor = kFloatPeriodicityFloor;
+  if (m_precisionMode == Mode::Double)
+    periodFloor = kDoublePeriodicityFloor;
+  else if (m_precisionMode == Mode::DoubleFloat)
+    periodFloor = kDoubleFloatPeriodicityFloor;
+  const double pixelSize = state.zoomSize / std::max(1, size.height());
+  const double periodEpsilon =
+      std::max(kPeriodicityPixelFraction * pixelSize, periodFloor);
+  program->setUniformValue("u_periodEpsilonSq",
+                           static_cast<float>(periodEpsilon * periodEpsilon));
+
+  // Perturbation for deep zooms: pixels iterate offsets from a reference
+  // orbit, scaled by 2^exponent so they stay representable in float
+  if (m_precisionMode == Mode::Perturbation) {
+    const bool view = owner == OrbitOwner::View;
+    if (view)
+      updateReferenceOrbit(state);
+    const ReferenceOrbit &orbit =
+        view ? m_referenceOrbit : updateOffViewOrbit(state);
+    SeriesApproximation &series = view ? m_series : m_offViewSeries;
+
+    const int orbitSlot = m_orbitTextures.find(orbit);
+    if (orbitSlot >= 0) {
+      glActiveTexture(GL_TEXTURE0 + kOrbitUnit);
+      m_orbitTextures.bind(orbitSlot);
+      program->setUniformValue("u_orbitTexture", kOrbitUnit);
+    }
+
+    int exponent = 0;
+    double mantissa = std::frexp(state.zoomSize, &exponent);
+    double offsetX = (state.deepCenterX - orbit.centerX()).toDouble();
+    double offsetY = (state.deepCenterY - orbit.centerY()).toDouble();
+
+    program->setUniformValue("u_orbitLength", orbit.length());
+    program->setUniformValue("u_referenceOffset",
+                             QVector2D(std::ldexp(offsetX, -exponent),
+                                       std::ldexp(offsetY, -exponent)));
+    program->setUniformValue("u_zoomMantissa", static_cast<float>(mantissa));
+    program->setUniformValue("u_zoomExponent", exponent);
+
+    // Series approximation lets every pixel skip the shared early orbit
+    double aspect =
+        static_cast<double>(size.width()) / std::max(1, size.height());
+    if (view && m_nextSeries.computedFor(orbit, offsetX, offsetY,
+                                         state.zoomSize, aspect, exponent,
+                                         state.maxIterations))
+      m_series = m_nextSeries;
+    series.compute(orbit, offsetX, offsetY, state.zoomSize, aspect, exponent,
+                   state.maxIterations);
+
+    auto toVector = [](const std::complex<double> &z) {
+      return QVector2D(static_cast<float>(z.real()),
+                       static_cast<float>(z.imag()));
+    };
+    program->setUniformValue("u_seriesSkip", series.skipIterations());
+    program->setUniformValue("u_seriesA", toVector(series.a()));
+    program->setUniformValue("u_seriesB", toVector(series.b()));
+    program->setUniformValue("u_seriesC", toVector(series.c()));
+    program->setUniformValue("u_seriesExponent", series.exponent());
+  }
+}
+
+void FractalRenderer::updateReferenceOrbit(const FractalState &state) {
+  if (!m_referenceOrbit.covers(state)) {
+    // A prefetch on its way to this view is cheaper to wait for than to
+    // compute the same orbit a second time
+    if (!m_referenceOrbit.extendsTo(state) && m_prefetcher &&
+        m_prefetcher->waitFor(state))
+      collectPrefetchedOrbit();
+
+    if (m_nextOrbit.covers(state)) {
+      m_orbitTextures.retire(m_referenceOrbit);
+      std::swap(m_referenceOrbit, m_nextOrbit);
+      m_nextOrbit.clear();
+    } else if (m_referenceOrbit.extendsTo(state)) {
+      // More iterations at the same reference: only the new points are
+      // computed and uploaded
+      m_referenceOrbit.extend(state.maxIterations);
+    } else {
+      const int limbs = BigReal::limbsForScale(state.zoomSize);
+      BigReal centerX = state.deepCenterX;
+      BigReal centerY = state.deepCenterY;
+      centerX.setLimbCount(limbs);
+      centerY.setLimbCount(limbs);
+
+      // Its texture takes the new orbit, the prefetched one stays resident
+      m_orbitTextures.retire(m_referenceOrbit);
+      m_referenceOrbit.compute(centerX, centerY, state.maxIterations,
+                               state.fractalType, state.juliaCx,
+                               state.juliaCy);
+    }
+  }
+
+  // Nothing to do once resident
+  m_orbitTextures.upload(m_referenceOrbit);
+}
+
+const ReferenceOrbit &
+FractalRenderer::updateOffViewOrbit(const FractalState &state) {
+  if (m_referenceOrbit.covers(state))
+    return m_referenceOrbit;
+
+  if (!m_offViewOrbit.covers(state)) {
+    if (m_offViewOrbit.extendsTo(state)) {
+      m_offViewOrbit.extend(state.maxIterations);
+    } else {
+      const int limbs = BigReal::limbsForScale(state.zoomSize);
+      BigReal centerX = state.deepCenterX;
+      BigReal centerY = state.deepCenterY;
+      centerX.setLimbCount(limbs);
+      centerY.setLimbCount(limbs);
+
+      m_orbitTextures.retire(m_offViewOrbit);
+      m_offViewOrbit.compute(centerX, centerY, state.maxIterations,
+                             state.fractalType, state.juliaCx, state.juliaCy);
+    }
+  }
+  m_orbitTextures.upload(m_offViewOrbit);
+  return m_offViewOrbit;
+}
+
+void FractalRenderer::setReferenceOrbit(const ReferenceOrbit &orbit) {
+  if (orbit.isEmpty())
+    return;
+  m_orbitTextures.retire(m_referenceOrbit);
+  m_referenceOrbit = orbit;
+  m_orbitTextures.upload(m_referenceOrbit);
+}
+
+void FractalRenderer::prefetchReferenceOrbit(const FractalState &state,
+                                             const QSize &size) {
+  if (size.isEmpty() ||
+      m_precisionPolicy.modeFor(state, size.height()) !=
+          PrecisionPolicy::Mode::Perturbation ||
+      m_referenceOrbit.covers(state) || m_nextOrbit.covers(state))
+    return;
+
+  if (!m_prefetcher)
+    m_prefetcher = std::make_unique<OrbitPrefetcher>();
+  m_prefetcher->request(state, size);
+}
+
+void FractalRenderer::collectPrefetchedOrbit() {
+  OrbitPrefetcher::Result result;
+  if (!m_prefetcher || !m_prefetcher->take(result))
+    return;
+
+  m_nextOrbit = std::move(result.orbit);
+  m_nextSeries = result.series;
+  m_orbitTextures.upload(m_nextOrbit);
+}
+
+FractalRenderer::DoubleSplit FractalRenderer::splitDouble(double value) {
+  // Emulate splitDouble from JS/GLSL
+  // Simple cast method is most robust for passing double as two floats
+  float hi = static_cast<float>(value);
+  float lo = static_cast<float>(value - static_cast<double>(hi));
+  return {hi, lo};
+}
+
+void FractalRenderer::setPalettes(std::vector<Palette::Definition> palettes) {
+  if (palettes.empty())
+    return;
+  m_palettes = std::move(palettes);
+  if (m_paletteTexture)
+    createPaletteTexture();
+}
+
+void FractalRenderer::createPaletteTexture() {
+  // One float row per palette. Clamped rather than repeated, so rows that
+  // span maxIterations keep their end colors; the CPU engine samples the
+  // same texels the same way.
+  m_paletteTexture =
+      std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target1DArray);
+  m_paletteTexture->setSize(Palette::kTextureSize);
+  m_paletteTexture->setLayers(static_cast<int>(m_palettes.size()));
+  m_paletteTexture->setFormat(QOpenGLTexture::RGBA32F);
+  m_paletteTexture->setMipLevels(1);
+  m_paletteTexture->allocateStorage(QOpenGLTexture::RGBA,
+                                    QOpenGLTexture::Float32);
+  for (size_t layer = 0; layer < m_palettes.size(); ++layer)
+    m_paletteTexture->setData(0, static_cast<int>(layer), QOpenGLTexture::RGBA,
+                              QOpenGLTexture::Float32,
+                              m_palettes[layer].texels.data());
+
+  m_paletteTexture->setMinificationFilter(QOpenGLTexture::Linear);
+  m_paletteTexture->setMagnificationFilter(QOpenGLTexture::Linear);
+  m_paletteTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+}
+
@@ -0,0 +1,455 @@
+#ifndef FRACTALRENDERER_H
+#define FRACTALRENDERER_H
+
+#include "GpuTimer.h"
+#include "OrbitPrefetcher.h"
+#include "OrbitTextureRing.h"
+#include "PrecisionPolicy.h"
+#include "ShaderManager.h"
+#include "TileCache.h"
+#include "core/FractalState.h"
+#include "core/Palette.h"
+#include "core/ReferenceOrbit.h"
+#include "core/SeriesApproximation.h"
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_4_0_Core>
+#include <QOpenGLTexture>
+#include <QRect>
+#include <QSize>
+#include <QVector2D>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Renders a FractalState with OpenGL, independent of any widget
+ *
+ * Rendering is split into two passes. The iteration pass runs the escape-time
+ * loop and writes a float buffer (RGBA32F):
+ *
+ *   r  smooth iteration count (Sierpinski: orbit trap distance)
+ *   g  1 if the pixel escaped (Sierpinski: 1 if the orbit stayed bounded)
+ *
+ * The coloring pass maps that buffer through the selected palette. The
+ * buffer is kept between frames, so changing anything the iteration does
+ * not depend on (currently the palette) only re-runs the cheap pass. A pan
+ * shifts the previous buffer by whole pixels and only iterates the strips
+ * that scrolled into view.
+ *
+ * Iteration is time-sliced: the work is cut into scissored tiles sized from
+ * the measured cost per pixel, and each render() only runs as many as fit
+ * the frame budget. Finished tiles accumulate in the iteration buffer, so a
+ * frame at a huge iteration count never becomes one long draw that trips
+ * the GPU watchdog.
+ *
+ * Mandelbrot and Julia views are first sampled on every kBoundaryStep-th
+ * row and column. The main pass reuses those samples and fills every grid
+ * cell whose boundary stayed inside the set without iterating it, which is
+ * where deep views spend most of their time.
+ *
+ * Each view is iterated in the cheapest numeric mode PrecisionPolicy finds
+ * sufficient for it, so the overview runs at plain float speed.
+ *
+ * With the tile cache enabled, a view whose tiles are all cached is
+ * assembled from them instead of iterated. Tiles of finished views are
+ * iterated by runBackgroundWork() when there is nothing else to do.
+ *
+ * With temporal samples set, a finished view keeps being refined: each
+ * render() iterates part of a copy jittered by a sub-pixel offset, and every
+ * completed copy is colored and averaged into an accumulation buffer that
+ * is shown instead. Any change to the view starts over.
+ *
+ * All methods must be called with the owning GL context current.
+ */
+class FractalRenderer : protected QOpenGLExtraFunctions {
+public:
+  // What the last render() did, for overlays and traces
+  struct FrameStats {
+    // GPU milliseconds per pass, from a frame or two earlier; -1 if unknown
+    double iterationGpuMs = -1.0;
+    double coloringGpuMs = -1.0;
+
+    // Iteration buffer pixels iterated in this call, boundary samples
+    // included
+    qint64 pixelsIterated = 0;
+
+    // Jittered samples averaged into the shown frame, 0 without temporal
+    // accumulation
+    int temporalSamples = 0;
+
+    // GPU memory held by reference orbit textures
+    qint64 orbitBytes = 0;
+  };
+
+  // GPU time per render() spent on iteration tiles
+  static constexpr double kDefaultFrameBudgetMs = 8.0;
+
+  // Length of the jitter sequence, setTemporalSamples() clamps to it
+  static constexpr int kMaxTemporalSamples = 16;
+
+  FractalRenderer();
+  ~FractalRenderer();
+
+  /**
+   * @brief Compiles shaders and creates the GL resources
+   * @return true if successful, false otherwise
+   */
+  bool initialize();
+
+  /**
+   * @brief Builds the remaining shader variants in the background
+   *
+   * Interactive sessions call this once after initialize(), so switching
+   * fractal, palette or precision later never stalls on a compile. Off the
+   * GUI thread, pass a @p surface created on the GUI thread.
+   */
+  void precompileShaders(QOffscreenSurface *surface = nullptr);
+
+  /**
+   * @brief Draws @p state into the framebuffer @p targetFbo
+   * @param size Physical pixel size of the target, the iteration buffer is
+   * this times resolutionScale()
+   *
+   * The iteration pass is skipped if neither the size nor the iteration
+   * inputs of @p state changed since the last call, and reduced to the newly
+   * exposed strips if the view was only panned.
+   */
+  void render(const FractalState &state, const QSize &size, GLuint targetFbo);
+
+  // Forces the next render() to re-run the iteration pass
+  void invalidate() { m_iterationValid = false; }
+
+  /**
+   * @brief Allows reprojection by sub-pixel pans while the view is moving
+   *
+   * A pan is normally only reprojected when it is a whole number of pixels.
+   * While interactive, any pan is rounded to whole pixels and the view may
+   * be off by up to half a pixel; the first frame after interaction ends
+   * re-iterates the exact view.
+   */
+  void setInteractive(bool interactive) { m_interactive = interactive; }
+
+  /**
+   * @brief Iteration buffer pixels per target pixel along each axis
+   *
+   * Below 1 the fractal is iterated at reduced resolution and upsampled,
+   * whole numbers above 1 supersample. Falls back to 1 if the buffer would
+   * exceed the maximum texture size.
+   */
+  void setResolutionScale(float scale) { m_resolutionScale = scale; }
+  float resolutionScale() const { return m_resolutionScale; }
+
+  /**
+   * @brief Milliseconds of iteration work per render(), 0 for no limit
+   *
+   * At least one row is iterated per call, so progress is guaranteed.
+   */
+  void setFrameBudget(double milliseconds) { m_frameBudgetMs = milliseconds; }
+
+  /**
+   * @brief Fills enclosed in-set cells without iterating them
+   *
+   * On by default. Takes effect with the next view that is iterated from
+   * scratch.
+   */
+  void setBoundaryFill(bool enabled) { m_boundaryFill = enabled; }
+
+  /**
+   * @brief Replaces the palettes paletteId indexes, Palette::builtIn() by
+   * default
+   *
+   * Uploads them as the layers of the palette texture array, so no shader
+   * is rebuilt. Ignored if @p palettes is empty. IDs past the end use the
+   * last palette.
+   */
+  void setPalettes(std::vector<Palette::Definition> palettes);
+  const std::vector<Palette::Definition> &palettes() const {
+    return m_palettes;
+  }
+
+  // True until every tile of the current view has been iterated
+  bool hasPendingWork() const { return !m_pendingTiles.empty(); }
+
+  /**
+   * @brief Samples per pixel to accumulate once a view is complete
+   *
+   * 0 or 1, the default, turns accumulation off. Above that, render()
+   * keeps iterating jittered samples of the finished view until
+   * @p samples are averaged, at most kMaxTemporalSamples. Only applies to
+   * views at rest, not while interactive.
+   */
+  void setTemporalSamples(int samples);
+  int temporalSamples() const { return m_temporalSamples; }
+
+  /**
+   * @brief Iterates @p state at the small @p size and reads the result back
+   * @param data Receives two floats per pixel, bottom row first: smooth
+   * iteration count and escaped flag, as from CpuFractalEngine::iterate()
+   *
+   * One untimed draw in the mode the probe's own pixel size needs, for
+   * estimating how many iterations a view needs. The current view is left
+   * alone.
+   */
+  void probe(const FractalState &state, const QSize &size,
+             std::vector<float> &data);
+
+  // True while the finished view has samples left to accumulate
+  bool hasAccumulationWork() const {
+    return m_temporalSamples > 1 && m_accumulatedSamples > 0 &&
+           m_accumulatedSamples < m_temporalSamples;
+  }
+
+  /**
+   * @brief Assembles views from a TileCache when all their tiles are cached
+   *
+   * Off by default. Tiles persist in the file at @p diskPath if given,
+   * otherwise only on the GPU.
+   *
+   * @return false if the GPU tier could not be created
+   */
+  bool enableTileCache(const QString &diskPath = QString());
+
+  // True while tiles of the finished view are still to be cached
+  bool hasBackgroundWork() const { return !m_cacheFill.empty(); }
+
+  /**
+   * @brief Iterates cache tiles for up to one frame budget, drawing nothing
+   *
+   * Meant for idle time once the view is complete, render() never spends
+   * its budget on the cache.
+   */
+  void runBackgroundWork();
+
+  /**
+   * @brief Uses @p orbit as the perturbation reference
+   *
+   * Lets several renderers share an orbit computed once, such as the
+   * deepest frame's orbit for every frame of a journey. It is replaced as
+   * usual once a view outgrows it.
+   */
+  void setReferenceOrbit(const ReferenceOrbit &orbit);
+
+  /**
+   * @brief Starts computing the reference orbit of a view coming up
+   *
+   * For where the view is heading, such as the end of a zoom. The orbit
+   * and the series of @p state are computed on a worker thread and taken
+   * over once the current orbit no longer covers the view, a view in
+   * between waits for the computation instead of starting its own. Does
+   * nothing if @p state does not need perturbation or the orbit in use
+   * covers it.
+   */
+  void prefetchReferenceOrbit(const FractalState &state, const QSize &size);
+
+  // Numeric mode the iteration buffer is being computed in
+  PrecisionPolicy::Mode precisionMode() const { return m_precisionMode; }
+
+  const FrameStats &frameStats() const { return m_frameStats; }
+
+private:
+  // Below this fraction of a pixel a pan counts as a whole-pixel shift
+  static constexpr double kReprojectionTolerance = 1e-3;
+
+  // An orbit cycling within this fraction of a pixel counts as periodic,
+  // above the resolution of the arithmetic the shader path uses
+  static constexpr double kPeriodicityPixelFraction = 1e-3;
+  static constexpr double kFloatPeriodicityFloor = 1e-6;
+  static constexpr double kDoublePeriodicityFloor = 1e-14;
+  static constexpr double kDoubleFloatPeriodicityFloor = 1e-12;
+
+  // Spacing of the sampled rows and columns of the boundary fill
+  static constexpr int kBoundaryStep = 16;
+
+  // Which buffer an iteration tile writes
+  enum class IterationPass {
+    Full,            // The iteration buffer itself
+    BoundaryRows,    // Every kBoundaryStep-th row
+    BoundaryColumns, // Every kBoundaryStep-th column
+  };
+
+  // Whose reference orbit the perturbation path uses. Probes and cache
+  // tiles have their own, so they never replace or retire the view's.
+  enum class OrbitOwner { View, OffView };
+
+  struct IterationTile {
+    QRect rect; // In the coordinates of the pass's buffer
+    IterationPass pass;
+  };
+
+  struct CacheFillTile {
+    TileKey key;
+    FractalState state; // The view of exactly this tile
+    int rowsDone;
+  };
+
+  /**
+   * @brief Runs the iteration pass for @p state
+   * @param region Pixels to iterate, in GL window coordinates (y up) of the
+   * buffer @p pass writes. An empty region means the whole buffer.
+   * @param target Buffer to write instead of the one of @p pass
+   * @param jitter Sub-pixel offset of the samples, main pass only
+   * @param owner Orbit and series to use if @p state needs perturbation
+   */
+  void iterate(const FractalState &state, const QSize &size,
+               const QRect &region = QRect(),
+               IterationPass pass = IterationPass::Full,
+               QOpenGLFramebufferObject *target = nullptr,
+               const QVector2D &jitter = QVector2D(),
+               OrbitOwner owner = OrbitOwner::View);
+
+  // Queues the whole view, after the boundary samples if the fill applies
+  void queueView(const FractalState &state, const QSize &size);
+
+  /**
+   * @brief Reuses the iteration buffer for a translated view
+   * @return false if @p state is not a reprojectable pan of the buffer
+   */
+  bool reproject(const FractalState &state, const QSize &size);
+
+  /**
+   * @brief Iterates queued tiles of m_iteratedState until the budget is spent
+   * @return Number of pixels iterated
+   */
+  qint64 iteratePendingTiles(const QSize &size);
+
+  /**
+   * @brief Colors @p iterations into the framebuffer @p targetFbo
+   * @param weight Blend factor of the new color, 1 replaces the target
+   */
+  void colorize(const FractalState &state, const QSize &size,
+                GLuint targetFbo, const QOpenGLFramebufferObject &iterations,
+                float weight = 1.0f);
+
+  /**
+   * @brief Iterates the next jittered sample of the finished view until the
+   * budget is spent
+   * @return Number of pixels iterated
+   */
+  qint64 iterateSample(const QSize &size);
+
+  // Averages finished samples into the accumulation buffer and copies it to
+  // @p targetFbo, starting over if the view changed
+  void accumulate(const FractalState &state, const QSize &size,
+                  GLuint targetFbo);
+
+  // True if the accumulation buffer holds samples of @p state at @p size
+  bool accumulationCurrent(const FractalState &state,
+                           const QSize &size) const;
+
+  // Fills the iteration buffer from cached tiles, false if any is missing
+  bool composeFromCache(const FractalState &state, const QSize &size);
+
+  // Queues the uncached tiles of a finished view for runBackgroundWork()
+  void queueCacheFill(const FractalState &state, const QSize &size);
+
+  // Drops queued cache tiles except one already started, which does not
+  // depend on the view
+  void dropCacheFill();
+
+  // Iteration program for @p state in the mode of the current view
+  QOpenGLShaderProgram *iterationProgram(const FractalState &state);
+
+  /**
+   * @brief Times the fp64 program against the emulated path
+   *
+   * Consumer GPUs run doubles at a small fraction of float speed, where
+   * float pairs win. Iterates a short probe view with both programs.
+   */
+  bool nativeDoubleIsFaster();
+
+  void createPaletteTexture();
+  // Sets the uniforms of the program for @p state and binds the orbit of
+  // @p owner
+  void updateUniforms(const FractalState &state, const QSize &size,
+                      OrbitOwner owner);
+
+  // Perturbation: replaces or extends the reference orbit when the view
+  // outgrows it and makes it resident
+  void updateReferenceOrbit(const FractalState &state);
+
+  // The same for probes and cache tiles. Returns the view's orbit if it
+  // covers @p state, m_offViewOrbit otherwise.
+  const ReferenceOrbit &updateOffViewOrbit(const FractalState &state);
+
+  // Moves a finished prefetch into m_nextOrbit and uploads it
+  void collectPrefetchedOrbit();
+
+  // Helper to split double for emulated precision (Dekker's algorithm)
+  struct DoubleSplit {
+    float hi;
+    float lo;
+  };
+  static DoubleSplit splitDouble(double value);
+
+  // Rendering resources
+  ShaderManager m_shaderManager;
+  QOpenGLFunctions_4_0_Core *m_doubleFunctions; // glUniform*d, may be null
+  std::vector<Palette::Definition> m_palettes;
+  std::unique_ptr<QOpenGLTexture> m_paletteTexture; // One layer per palette
+  OrbitTextureRing m_orbitTextures;
+  std::unique_ptr<QOpenGLFramebufferObject> m_iterationBuffer;
+  std::unique_ptr<QOpenGLFramebufferObject> m_spareIterationBuffer;
+  ReferenceOrbit m_referenceOrbit;
+  SeriesApproximation m_series;
+
+  // Of probes and cache tiles outside the view's orbit
+  ReferenceOrbit m_offViewOrbit;
+  SeriesApproximation m_offViewSeries;
+
+  // Prefetched orbit waiting for the view to need it, already uploaded,
+  // with the series of the view it was requested for
+  std::unique_ptr<OrbitPrefetcher> m_prefetcher;
+  ReferenceOrbit m_nextOrbit;
+  SeriesApproximation m_nextSeries;
+
+  // Full screen quad buffers
+  GLuint m_vao;
+  GLuint m_vbo;
+
+  // State the iteration buffer currently holds, and the mode the policy
+  // chose for it when it was queued
+  FractalState m_iteratedState;
+  PrecisionPolicy m_precisionPolicy;
+  PrecisionPolicy::Mode m_precisionMode;
+  bool m_iterationValid;
+  bool m_interactive;
+  float m_resolutionScale;
+  GLint m_maxTextureSize;
+
+  // Boundary fill samples of m_iteratedState, origin in its pixels
+  std::unique_ptr<QOpenGLFramebufferObject> m_boundaryRows;
+  std::unique_ptr<QOpenGLFramebufferObject> m_boundaryColumns;
+  QPoint m_boundaryOrigin;
+  bool m_boundaryFill;
+  bool m_boundaryActive;
+
+  // Time slicing: regions still to iterate, and the running estimate of
+  // the GPU cost that sizes the next tile
+  std::deque<IterationTile> m_pendingTiles;
+  double m_frameBudgetMs;
+  double m_msPerPixel;
+
+  // Tile cache, null unless enabled. Tiles pick their own mode, without
+  // hysteresis from the view's policy.
+  std::unique_ptr<TileCache> m_tileCache;
+  PrecisionPolicy m_tilePolicy;
+  std::deque<CacheFillTile> m_cacheFill;
+  bool m_cacheFillQueued;
+
+  // Temporal accumulation. Sample 0 is the iteration buffer itself, the
+  // others are iterated into m_sampleBuffer row by row.
+  int m_temporalSamples;
+  int m_accumulatedSamples; // 0 if the accumulation buffer is stale
+  FractalState m_accumulatedState;
+  std::unique_ptr<QOpenGLFramebufferObject> m_accumulationBuffer;
+  std::unique_ptr<QOpenGLFramebufferObject> m_sampleBuffer;
+  int m_sampleRowsDone;
+
+  std::unique_ptr<QOpenGLFramebufferObject> m_probeBuffer;
+
+  GpuTimer m_gpuTimer;
+  FrameStats m_frameStats;
+};
+
+#endif // FRACTALRENDERER_H
@@ -0,0 +1,54 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer() : m_current(0), m_available(false) {
+  for (double &ms : m_milliseconds)
+    ms = -1.0;
+}
+
+bool GpuTimer::initialize() {
+  for (Slot &slot : m_slots) {
+    for (auto &query : slot.queries) {
+      query = std::make_unique<QOpenGLTimerQuery>();
+      if (!query->create())
+        return false;
+    }
+  }
+  m_available = true;
+  return true;
+}
+
+void GpuTimer::beginFrame() {
+  if (!m_available)
+    return;
+
+  m_current = (m_current + 1) % kFrameLatency;
+  Slot &slot = m_slots[m_current];
+
+  // A frame counts once all its queries arrived, otherwise keep the last
+  // complete one rather than mixing frames
+  bool complete = true;
+  for (int pass = 0; pass < kPassCount; ++pass)
+    if (slot.issued[pass] && !slot.queries[pass]->isResultAvailable())
+      complete = false;
+
+  if (complete) {
+    for (int pass = 0; pass < kPassCount; ++pass)
+      m_milliseconds[pass] =
+          slot.issued[pass] ? slot.queries[pass]->waitForResult() * 1e-6
+                            : 0.0;
+  }
+  for (bool &issued : slot.issued)
+    issued = false;
+}
+
+void GpuTimer::begin(Pass pass) {
+  if (m_available)
+    m_slots[m_current].queries[pass]->begin();
+}
+
+void GpuTimer::end(Pass pass) {
+  if (!m_available)
+    return;
+  m_slots[m_current].queries[pass]->end();
+  m_slots[m_current].issued[pass] = true;
+}
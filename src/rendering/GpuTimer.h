@@ -0,0 +1,58 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <QOpenGLTimerQuery>
+#include <memory>
+
+/**
+ * @brief GPU time of the render passes, measured without stalling
+ *
+ * Each pass is bracketed by a GL_TIME_ELAPSED query. The queries of a frame
+ * are only read when their slot comes round again kFrameLatency frames
+ * later, and only if the GPU already has the result, so timing never waits
+ * for the GPU. The reported times therefore lag the current frame.
+ *
+ * All methods must be called with the owning GL context current.
+ */
+class GpuTimer {
+public:
+  enum Pass { Iteration, Coloring, kPassCount };
+
+  // Frames in flight, two is double buffering
+  static constexpr int kFrameLatency = 2;
+
+  GpuTimer();
+
+  /**
+   * @brief Creates the query objects
+   * @return false if the context has no timer queries, every result then
+   * stays unknown
+   */
+  bool initialize();
+
+  // Collects the results about to be overwritten and starts a new frame
+  void beginFrame();
+
+  // Passes may be skipped in a frame, but not nested
+  void begin(Pass pass);
+  void end(Pass pass);
+
+  /**
+   * @brief GPU milliseconds @p pass took in the newest collected frame
+   * @return 0 if the pass did not run in that frame, -1 if unknown
+   */
+  double milliseconds(Pass pass) const { return m_milliseconds[pass]; }
+
+private:
+  struct Slot {
+    std::unique_ptr<QOpenGLTimerQuery> queries[kPassCount];
+    bool issued[kPassCount] = {};
+  };
+
+  Slot m_slots[kFrameLatency];
+  int m_current;
+  bool m_available;
+  double m_milliseconds[kPassCount];
+};
+
+#endif // GPUTIMER_H
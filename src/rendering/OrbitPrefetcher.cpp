@@ -0,0 +1,111 @@
+#include "OrbitPrefetcher.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+OrbitPrefetcher::OrbitPrefetcher()
+    : m_hasPending(false), m_running(false), m_stopping(false) {
+  m_thread.reset(QThread::create([this]() { run(); }));
+  m_thread->start(QThread::LowPriority);
+}
+
+OrbitPrefetcher::~OrbitPrefetcher() {
+  {
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_wake.wakeOne();
+  }
+  m_thread->wait();
+}
+
+void OrbitPrefetcher::request(const FractalState &state, const QSize &size) {
+  QMutexLocker locker(&m_mutex);
+  if ((m_result && m_result->orbit.covers(state)) ||
+      (m_running && wouldCover(m_runningState, state)) ||
+      (m_hasPending && wouldCover(m_pending.state, state)))
+    return;
+
+  m_pending.state = state;
+  m_pending.size = size;
+  m_hasPending = true;
+  m_wake.wakeOne();
+}
+
+bool OrbitPrefetcher::take(Result &result) {
+  QMutexLocker locker(&m_mutex);
+  if (!m_result)
+    return false;
+  result = std::move(*m_result);
+  m_result.reset();
+  return true;
+}
+
+bool OrbitPrefetcher::waitFor(const FractalState &state) {
+  QMutexLocker locker(&m_mutex);
+  if (m_running && wouldCover(m_runningState, state)) {
+    while (m_running)
+      m_finished.wait(&m_mutex);
+  }
+  return m_result != nullptr;
+}
+
+void OrbitPrefetcher::run() {
+  QMutexLocker locker(&m_mutex);
+  for (;;) {
+    while (!m_hasPending && !m_stopping)
+      m_wake.wait(&m_mutex);
+    if (m_stopping)
+      return;
+
+    const Request request = m_pending;
+    m_hasPending = false;
+    m_running = true;
+    m_runningState = request.state;
+    locker.unlock();
+
+    // Same orbit the renderer would compute for the view
+    const FractalState &state = request.state;
+    const int limbs = BigReal::limbsForScale(state.zoomSize);
+    BigReal centerX = state.deepCenterX;
+    BigReal centerY = state.deepCenterY;
+    centerX.setLimbCount(limbs);
+    centerY.setLimbCount(limbs);
+
+    auto result = std::make_unique<Result>();
+    result->state = state;
+    result->orbit.compute(centerX, centerY, state.maxIterations,
+                          state.fractalType, state.juliaCx, state.juliaCy);
+
+    // The series with the inputs FractalRenderer will pass for the view
+    int exponent = 0;
+    std::frexp(state.zoomSize, &exponent);
+    const double aspect = static_cast<double>(request.size.width()) /
+                          std::max(1, request.size.height());
+    result->series.compute(
+        result->orbit, (state.deepCenterX - centerX).toDouble(),
+        (state.deepCenterY - centerY).toDouble(), state.zoomSize, aspect,
+        exponent, state.maxIterations);
+
+    locker.relock();
+    m_result = std::move(result);
+    m_running = false;
+    m_finished.wakeAll();
+  }
+}
+
+bool OrbitPrefetcher::wouldCover(const FractalState &reference,
+                                 const FractalState &state) {
+  if (reference.fractalType != state.fractalType ||
+      reference.juliaCx != state.juliaCx ||
+      reference.juliaCy != state.juliaCy ||
+      BigReal::limbsForScale(reference.zoomSize) <
+          BigReal::limbsForScale(state.zoomSize) ||
+      reference.maxIterations < state.maxIterations)
+    return false;
+
+  const double offsetX = (state.deepCenterX - reference.deepCenterX).toDouble();
+  const double offsetY = (state.deepCenterY - reference.deepCenterY).toDouble();
+  return std::abs(offsetX) <= state.zoomSize &&
+         std::abs(offsetY) <= state.zoomSize;
+}
@@ -0,0 +1,82 @@
+#ifndef ORBITPREFETCHER_H
+#define ORBITPREFETCHER_H
+
+#include "core/FractalState.h"
+#include "core/ReferenceOrbit.h"
+#include "core/SeriesApproximation.h"
+#include <QMutex>
+#include <QSize>
+#include <QThread>
+#include <QWaitCondition>
+#include <memory>
+
+/**
+ * @brief Computes reference orbits for upcoming views on a worker thread
+ *
+ * Where the view is heading is often known before it gets there: the
+ * target of the wheel smoothing, the last frame of a journey. An orbit
+ * computed for that view in the background is ready when the current one
+ * goes stale, instead of the frame stalling on BigReal arithmetic. Along
+ * with the orbit comes the series approximation of the requested view
+ * itself, the one the motion settles on.
+ *
+ * Holds one request at a time. A newer request replaces one that has not
+ * started, one being computed runs to completion.
+ */
+class OrbitPrefetcher {
+public:
+  struct Result {
+    FractalState state; // The requested view
+    ReferenceOrbit orbit;
+    SeriesApproximation series; // Of state, computed against orbit
+  };
+
+  OrbitPrefetcher();
+
+  // Waits for the orbit being computed, if any
+  ~OrbitPrefetcher();
+
+  /**
+   * @brief Computes the orbit and series for @p state at @p size
+   *
+   * Ignored if the orbit of the pending, running or finished request
+   * will cover @p state anyway.
+   */
+  void request(const FractalState &state, const QSize &size);
+
+  // Moves the finished result into @p result, false if there is none
+  bool take(Result &result);
+
+  /**
+   * @brief Waits for the running request if its orbit will cover @p state
+   * @return true if a result is ready for take()
+   */
+  bool waitFor(const FractalState &state);
+
+private:
+  struct Request {
+    FractalState state;
+    QSize size;
+  };
+
+  void run();
+
+  // ReferenceOrbit::covers() for the orbit a request for @p reference
+  // will produce
+  static bool wouldCover(const FractalState &reference,
+                         const FractalState &state);
+
+  std::unique_ptr<QThread> m_thread;
+
+  QMutex m_mutex;
+  QWaitCondition m_wake;     // New request or stopping
+  QWaitCondition m_finished; // The running request is done
+  bool m_hasPending;
+  Request m_pending;
+  bool m_running;
+  FractalState m_runningState;
+  std::unique_ptr<Result> m_result;
+  bool m_stopping;
+};
+
+#endif // ORBITPREFETCHER_H
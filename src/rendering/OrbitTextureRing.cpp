@@ -0,0 +1,117 @@
+#include "OrbitTextureRing.h"
+#include <algorithm>
+
+OrbitTextureRing::OrbitTextureRing(int slotCount)
+    : m_slots(std::max(1, slotCount)), m_clock(0), m_initialized(false) {}
+
+OrbitTextureRing::~OrbitTextureRing() {
+  if (m_initialized)
+    release();
+}
+
+void OrbitTextureRing::initialize() {
+  initializeOpenGLFunctions();
+  m_initialized = true;
+}
+
+int OrbitTextureRing::upload(const ReferenceOrbit &orbit) {
+  if (orbit.isEmpty())
+    return -1;
+
+  // The orbit's own slot if it has one, else the least recently used
+  int index = 0;
+  for (int i = 0; i < static_cast<int>(m_slots.size()); ++i) {
+    if (m_slots[i].generation == orbit.generation()) {
+      index = i;
+      break;
+    }
+    if (m_slots[i].lastUse < m_slots[index].lastUse)
+      index = i;
+  }
+  Slot &slot = m_slots[index];
+  slot.lastUse = ++m_clock;
+  if (slot.generation != orbit.generation()) {
+    slot.generation = orbit.generation();
+    slot.length = 0;
+  }
+  if (slot.length == orbit.length())
+    return index;
+
+  const int width = ReferenceOrbit::kTextureWidth;
+  const int rows = orbit.textureHeight();
+  if (!slot.texture) {
+    glGenTextures(1, &slot.texture);
+    glBindTexture(GL_TEXTURE_2D, slot.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  } else {
+    glBindTexture(GL_TEXTURE_2D, slot.texture);
+  }
+
+  // Orbits mostly grow by extension, so leave room for the next steps
+  if (rows > slot.rows) {
+    const int grown = std::max(rows, slot.rows + slot.rows / 2);
+    slot.rows = (grown + kRowGranularity - 1) / kRowGranularity *
+                kRowGranularity;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32I, width, slot.rows, 0,
+                 GL_RG_INTEGER, GL_INT, nullptr);
+    slot.length = 0;
+  }
+
+  // From the row holding the first new point, the last row is partial.
+  // Texels past the orbit's end are never read.
+  const int32_t *points = orbit.packedPoints().data();
+  const int firstRow = slot.length / width;
+  const int fullRows = orbit.length() / width;
+  if (fullRows > firstRow)
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, width, fullRows - firstRow,
+                    GL_RG_INTEGER, GL_INT,
+                    points + 2 * static_cast<size_t>(firstRow) * width);
+  const int rest = orbit.length() - fullRows * width;
+  if (rest > 0)
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, fullRows, rest, 1, GL_RG_INTEGER,
+                    GL_INT,
+                    points + 2 * static_cast<size_t>(fullRows) * width);
+  slot.length = orbit.length();
+  return index;
+}
+
+void OrbitTextureRing::retire(const ReferenceOrbit &orbit) {
+  for (Slot &slot : m_slots) {
+    if (slot.generation == orbit.generation())
+      slot.lastUse = 0;
+  }
+}
+
+int OrbitTextureRing::find(const ReferenceOrbit &orbit) const {
+  for (int i = 0; i < static_cast<int>(m_slots.size()); ++i) {
+    const Slot &slot = m_slots[i];
+    if (slot.texture && slot.generation == orbit.generation() &&
+        slot.length == orbit.length())
+      return i;
+  }
+  return -1;
+}
+
+void OrbitTextureRing::bind(int slot) {
+  m_slots[slot].lastUse = ++m_clock;
+  glBindTexture(GL_TEXTURE_2D, m_slots[slot].texture);
+}
+
+void OrbitTextureRing::release() {
+  for (Slot &slot : m_slots) {
+    if (slot.texture)
+      glDeleteTextures(1, &slot.texture);
+    slot = Slot();
+  }
+}
+
+qint64 OrbitTextureRing::bytes() const {
+  qint64 total = 0;
+  for (const Slot &slot : m_slots)
+    total += static_cast<qint64>(slot.rows) * ReferenceOrbit::kTextureWidth *
+             2 * sizeof(int32_t);
+  return total;
+}
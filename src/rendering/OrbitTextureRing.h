@@ -0,0 +1,72 @@
+#ifndef ORBITTEXTURERING_H
+#define ORBITTEXTURERING_H
+
+#include "core/ReferenceOrbit.h"
+#include <QOpenGLExtraFunctions>
+#include <vector>
+
+/**
+ * @brief Persistent GPU storage for reference orbits
+ *
+ * A small ring of RG32I textures, ReferenceOrbit::kTextureWidth texels
+ * wide, holding ReferenceOrbit::packedPoints(). The textures stay allocated
+ * and are reused by the next orbit, growing with headroom when one needs
+ * more rows. Each slot remembers which orbit generation it holds and how many
+ * points, so uploading an orbit that was extend()ed only sends the rows
+ * past what the slot already has.
+ *
+ * One slot serves the orbit in use, one the prefetched orbit and one the
+ * orbit of probes and cache tiles outside the view's. All methods run with
+ * the owning GL context current. Destroy with it current as well.
+ */
+class OrbitTextureRing : protected QOpenGLExtraFunctions {
+public:
+  static constexpr int kDefaultSlotCount = 3;
+
+  // Texture heights are multiples of this, 64K points
+  static constexpr int kRowGranularity = 16;
+
+  explicit OrbitTextureRing(int slotCount = kDefaultSlotCount);
+  ~OrbitTextureRing();
+
+  void initialize();
+
+  /**
+   * @brief Makes @p orbit resident and returns its slot
+   *
+   * Nothing is uploaded if the slot holding the orbit is current. Otherwise
+   * the least recently used slot is overwritten, the slot of the orbit bound
+   * last is never it.
+   */
+  int upload(const ReferenceOrbit &orbit);
+
+  // Makes the slot of @p orbit the next one upload() overwrites, for an
+  // orbit about to be replaced. The texture stays allocated.
+  void retire(const ReferenceOrbit &orbit);
+
+  // Slot holding @p orbit with all its points, -1 if there is none
+  int find(const ReferenceOrbit &orbit) const;
+
+  // Binds the texture of @p slot to the active texture unit
+  void bind(int slot);
+
+  // GPU memory of all slots
+  qint64 bytes() const;
+
+private:
+  struct Slot {
+    GLuint texture = 0;
+    int rows = 0;       // Allocated height
+    int generation = -1;
+    int length = 0;     // Points uploaded
+    quint64 lastUse = 0;
+  };
+
+  void release();
+
+  std::vector<Slot> m_slots;
+  quint64 m_clock;
+  bool m_initialized;
+};
+
+#endif // ORBITTEXTURERING_H
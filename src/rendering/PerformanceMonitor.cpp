@@ -0,0 +1,145 @@
+#include "PerformanceMonitor.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+PerformanceMonitor::PerformanceMonitor()
+    : m_tracing(false), m_traceStartMs(0.0) {
+  m_clock.start();
+}
+
+void PerformanceMonitor::addFrame(const Sample &sample) {
+  const double now = m_clock.nsecsElapsed() * 1e-6;
+
+  m_window.push_back({now, sample});
+  while (m_window.front().timeMs < now - kWindowMs)
+    m_window.pop_front();
+
+  if (m_tracing)
+    m_trace.push_back({now - m_traceStartMs, sample});
+}
+
+PerformanceMonitor::Summary PerformanceMonitor::summary() const {
+  Summary summary;
+  if (m_window.empty())
+    return summary;
+
+  double frameMs = 0.0;
+  double physicsMs = 0.0;
+  double iterationMs = 0.0;
+  double coloringMs = 0.0;
+  double iterations = 0.0;
+  int iterationSamples = 0;
+  int coloringSamples = 0;
+  for (const Entry &entry : m_window) {
+    const Sample &sample = entry.sample;
+    frameMs += sample.frameMs;
+    physicsMs += sample.physicsMs;
+    if (sample.iterationGpuMs >= 0.0) {
+      iterationMs += sample.iterationGpuMs;
+      ++iterationSamples;
+    }
+    if (sample.coloringGpuMs >= 0.0) {
+      coloringMs += sample.coloringGpuMs;
+      ++coloringSamples;
+    }
+    iterations +=
+        static_cast<double>(sample.pixelsIterated) * sample.maxIterations;
+  }
+
+  const int count = static_cast<int>(m_window.size());
+  summary.frameMs = frameMs / count;
+  summary.physicsMs = physicsMs / count;
+  if (iterationSamples > 0)
+    summary.iterationGpuMs = iterationMs / iterationSamples;
+  if (coloringSamples > 0)
+    summary.coloringGpuMs = coloringMs / coloringSamples;
+
+  // The GPU times lag the pixel counts by a frame or two, which evens out
+  // over the window
+  if (iterationMs > 0.0)
+    summary.iterationsPerSecond = iterations / (iterationMs * 1e-3);
+
+  // Frames only arrive while something changes, an idle view has no rate
+  const double spanMs = m_window.back().timeMs - m_window.front().timeMs;
+  if (count > 1 && spanMs > 0.0)
+    summary.fps = (count - 1) * 1000.0 / spanMs;
+  return summary;
+}
+
+void PerformanceMonitor::startTrace() {
+  m_trace.clear();
+  m_traceStartMs = m_clock.nsecsElapsed() * 1e-6;
+  m_tracing = true;
+}
+
+bool PerformanceMonitor::saveTrace(const QString &path) {
+  m_errorString.clear();
+  if (path.endsWith(".json", Qt::CaseInsensitive))
+    return saveJson(path);
+  return saveCsv(path);
+}
+
+bool PerformanceMonitor::saveCsv(const QString &path) {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate |
+                 QIODevice::Text)) {
+    m_errorString = QString("Cannot write %1: %2").arg(path, file.errorString());
+    return false;
+  }
+
+  QTextStream out(&file);
+  out << "time_ms,frame_ms,physics_ms,iteration_gpu_ms,coloring_gpu_ms,"
+         "pixels_iterated,max_iterations,zoom,resolution_scale,precision\n";
+  for (const Entry &entry : m_trace) {
+    const Sample &sample = entry.sample;
+    out << QString::number(entry.timeMs, 'f', 3) << ','
+        << QString::number(sample.frameMs, 'f', 3) << ','
+        << QString::number(sample.physicsMs, 'f', 3) << ','
+        << QString::number(sample.iterationGpuMs, 'f', 3) << ','
+        << QString::number(sample.coloringGpuMs, 'f', 3) << ','
+        << sample.pixelsIterated << ',' << sample.maxIterations << ','
+        << QString::number(sample.zoomSize, 'g', 17) << ','
+        << sample.resolutionScale << ','
+        << PrecisionPolicy::name(sample.precision) << '\n';
+  }
+
+  out.flush();
+  if (file.error() != QFileDevice::NoError) {
+    m_errorString = QString("Cannot write %1: %2").arg(path, file.errorString());
+    return false;
+  }
+  return true;
+}
+
+bool PerformanceMonitor::saveJson(const QString &path) {
+  QJsonArray frames;
+  for (const Entry &entry : m_trace) {
+    const Sample &sample = entry.sample;
+    QJsonObject frame;
+    frame["timeMs"] = entry.timeMs;
+    frame["frameMs"] = sample.frameMs;
+    frame["physicsMs"] = sample.physicsMs;
+    frame["iterationGpuMs"] = sample.iterationGpuMs;
+    frame["coloringGpuMs"] = sample.coloringGpuMs;
+    frame["pixelsIterated"] = static_cast<double>(sample.pixelsIterated);
+    frame["maxIterations"] = sample.maxIterations;
+    frame["zoom"] = sample.zoomSize;
+    frame["resolutionScale"] = sample.resolutionScale;
+    frame["precision"] = PrecisionPolicy::name(sample.precision);
+    frames.append(frame);
+  }
+
+  QJsonObject root;
+  root["frames"] = frames;
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      file.write(QJsonDocument(root).toJson()) < 0) {
+    m_errorString = QString("Cannot write %1: %2").arg(path, file.errorString());
+    return false;
+  }
+  return true;
+}
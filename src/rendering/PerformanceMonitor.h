@@ -0,0 +1,95 @@
+#ifndef PERFORMANCEMONITOR_H
+#define PERFORMANCEMONITOR_H
+
+#include "PrecisionPolicy.h"
+#include <QElapsedTimer>
+#include <QString>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief Frame timings for the stats overlay and recorded traces
+ *
+ * The widget hands over one Sample per painted frame. summary() averages
+ * the samples of the last kWindowMs, like the 500 ms blocks the web
+ * version logged. While tracing, every sample is also kept, and
+ * saveTrace() writes them as CSV or JSON so runs of different builds can be
+ * diffed.
+ */
+class PerformanceMonitor {
+public:
+  // Averaging window of summary()
+  static constexpr double kWindowMs = 500.0;
+
+  struct Sample {
+    double frameMs = 0.0;   // CPU time of the whole frame on the GUI thread
+    double physicsMs = 0.0; // Part of frameMs spent on smoothing and momentum
+    double iterationGpuMs = -1.0; // -1 if unknown
+    double coloringGpuMs = -1.0;
+    qint64 pixelsIterated = 0;
+    int maxIterations = 0;
+    double zoomSize = 0.0;
+    float resolutionScale = 1.0f;
+    PrecisionPolicy::Mode precision = PrecisionPolicy::Mode::Float;
+  };
+
+  struct Summary {
+    double fps = 0.0;
+    double frameMs = 0.0;
+    double physicsMs = 0.0;
+    double iterationGpuMs = -1.0;
+    double coloringGpuMs = -1.0;
+
+    /**
+     * Iteration pass throughput. An upper bound: the shader does not report
+     * how long each orbit ran, so every pixel counts maxIterations, and
+     * skipped in-set cells count as iterated.
+     */
+    double iterationsPerSecond = 0.0;
+  };
+
+  PerformanceMonitor();
+
+  // Records @p sample, timestamped now
+  void addFrame(const Sample &sample);
+
+  // Averages over the samples of the last kWindowMs
+  Summary summary() const;
+
+  // Starts recording every sample, dropping any previous trace
+  void startTrace();
+  void stopTrace() { m_tracing = false; }
+  bool isTracing() const { return m_tracing; }
+  int traceLength() const { return static_cast<int>(m_trace.size()); }
+
+  /**
+   * @brief Writes the recorded trace to @p path
+   *
+   * JSON if the name ends in .json, CSV otherwise. Times are in
+   * milliseconds from the start of the trace.
+   *
+   * @return false on failure, see errorString()
+   */
+  bool saveTrace(const QString &path);
+
+  QString errorString() const { return m_errorString; }
+
+private:
+  struct Entry {
+    double timeMs;
+    Sample sample;
+  };
+
+  bool saveCsv(const QString &path);
+  bool saveJson(const QString &path);
+
+  QElapsedTimer m_clock;
+  std::deque<Entry> m_window;
+
+  bool m_tracing;
+  double m_traceStartMs;
+  std::vector<Entry> m_trace;
+  QString m_errorString;
+};
+
+#endif // PERFORMANCEMONITOR_H
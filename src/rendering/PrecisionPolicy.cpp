@@ -0,0 +1,71 @@
+#include "PrecisionPolicy.h"
+#include "core/Formula.h"
+#include <algorithm>
+#include <cmath>
+
+PrecisionPolicy::PrecisionPolicy()
+    : m_nativeDouble(false), m_valid(false), m_mode(Mode::Float),
+      m_fractalType(0) {}
+
+PrecisionPolicy::Mode PrecisionPolicy::update(const FractalState &state,
+                                              int height) {
+  const Mode wanted = cheapestMode(state, height, 1.0);
+
+  // A different fractal is a new view, nothing to smooth over
+  if (!m_valid || state.fractalType != m_fractalType) {
+    m_mode = wanted;
+  } else if (wanted > m_mode) {
+    m_mode = wanted;
+  } else if (wanted < m_mode) {
+    // Step down only as far as the cheaper mode holds with margin. The
+    // current mode always holds, so this never goes below it.
+    m_mode = std::min(m_mode, cheapestMode(state, height, kHysteresis));
+  }
+
+  m_valid = true;
+  m_fractalType = state.fractalType;
+  return m_mode;
+}
+
+void PrecisionPolicy::reset() { m_valid = false; }
+
+const char *PrecisionPolicy::name(Mode mode) {
+  switch (mode) {
+  case Mode::Float:
+    return "float";
+  case Mode::Double:
+    return "fp64";
+  case Mode::DoubleFloat:
+    return "double-float";
+  case Mode::Perturbation:
+    return "perturbation";
+  }
+  return "unknown";
+}
+
+PrecisionPolicy::Mode PrecisionPolicy::cheapestMode(const FractalState &state,
+                                                    int height,
+                                                    double margin) const {
+  // Sierpinski folds stay in [-2, 2] and only have a float path
+  if (!Formula::isEscapeTime(state.fractalType))
+    return Mode::Float;
+
+  const double zoomSize = state.zoomSize / margin;
+  const double pixelSize = zoomSize / std::max(1, height);
+
+  // Orbits stay within radius 2 until they escape, the pixel coordinates
+  // themselves may be further out
+  const double magnitude =
+      std::max({2.0, std::abs(state.zoomCenterX) + zoomSize,
+                std::abs(state.zoomCenterY) + zoomSize});
+  const double relative = pixelSize / magnitude;
+
+  if (relative >= kFloatLimit)
+    return Mode::Float;
+  if (zoomSize < kPerturbationZoomThreshold)
+    return Mode::Perturbation;
+  if (m_nativeDouble)
+    return relative >= kDoubleLimit ? Mode::Double : Mode::Perturbation;
+  return relative >= kDoubleFloatLimit ? Mode::DoubleFloat
+                                       : Mode::Perturbation;
+}
@@ -0,0 +1,86 @@
+#ifndef PRECISIONPOLICY_H
+#define PRECISIONPOLICY_H
+
+#include "core/FractalState.h"
+
+/**
+ * @brief Picks the cheapest numeric mode of fractal.frag that resolves a view
+ *
+ * The modes in order of cost:
+ *
+ *   Float         plain float, enough for the overview zoom levels
+ *   Double        native fp64, where the GPU supports it
+ *   DoubleFloat   emulated double as a pair of floats
+ *   Perturbation  float offsets from an arbitrary-precision reference orbit
+ *
+ * A mode resolves a view if one pixel spans enough units in the last place
+ * of the coordinates being iterated, so the limits depend on the pixel size
+ * (zoomSize over viewport height) and the magnitude of the center. Below
+ * kPerturbationZoomThreshold perturbation is the cheapest mode anyway.
+ *
+ * Moving to a more precise mode happens as soon as a view needs it. Moving
+ * back only happens once the cheaper mode would still hold at
+ * kHysteresis times the zoom, so zooming back and forth around a limit does
+ * not toggle the mode on every frame.
+ */
+class PrecisionPolicy {
+public:
+  enum class Mode { Float, Double, DoubleFloat, Perturbation };
+
+  // Below this view size perturbation is both faster and more accurate than
+  // the direct double paths
+  static constexpr double kPerturbationZoomThreshold = 1e-5;
+
+  // Zoom factor past a limit before a cheaper mode is chosen again
+  static constexpr double kHysteresis = 2.0;
+
+  PrecisionPolicy();
+
+  /**
+   * @brief Allows the native double mode, off by default
+   *
+   * Only enable this if the driver exposes fp64 shaders. Without it the
+   * emulated DoubleFloat mode covers the same range.
+   */
+  void setNativeDoubleSupported(bool supported) { m_nativeDouble = supported; }
+  bool nativeDoubleSupported() const { return m_nativeDouble; }
+
+  /**
+   * @brief Chooses the mode for @p state at @p height physical pixels
+   * @return The new current mode
+   */
+  Mode update(const FractalState &state, int height);
+
+  Mode mode() const { return m_mode; }
+
+  // Mode @p state needs on its own, without hysteresis or changing mode()
+  Mode modeFor(const FractalState &state, int height) const {
+    return cheapestMode(state, height, 1.0);
+  }
+
+  // Forgets the current mode, the next update() has no hysteresis
+  void reset();
+
+  // Short name for logs and overlays
+  static const char *name(Mode mode);
+
+private:
+  // Pixel size relative to the coordinate magnitude below which each direct
+  // mode stops resolving neighbouring pixels. About 64 ulps per pixel for
+  // float (24-bit mantissa) and double (53-bit), about 128 for the 48-bit
+  // mantissa of double-float.
+  static constexpr double kFloatLimit = 7.6e-6;
+  static constexpr double kDoubleLimit = 1.4e-14;
+  static constexpr double kDoubleFloatLimit = 4.5e-13;
+
+  // Cheapest mode that still holds with @p state zoomed in by @p margin
+  Mode cheapestMode(const FractalState &state, int height,
+                    double margin) const;
+
+  bool m_nativeDouble;
+  bool m_valid;
+  Mode m_mode;
+  int m_fractalType;
+};
+
+#endif // PRECISIONPOLICY_H
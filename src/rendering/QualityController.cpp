@@ -0,0 +1,152 @@
+#include "QualityController.h"
+#include "core/Formula.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Same set, whatever the view
+bool sameFractal(const FractalState &a, const FractalState &b) {
+  return a.fractalType == b.fractalType && a.juliaCx == b.juliaCx &&
+         a.juliaCy == b.juliaCy;
+}
+} // namespace
+
+QualityController::QualityController()
+    : m_frameBudgetMs(kDefaultFrameBudgetMs), m_probed(false),
+      m_probedIterations(0), m_saturated(false), m_iterationMs(0.0),
+      m_work(0.0), m_coloringMs(0.0) {}
+
+double QualityController::iterationBudget() const {
+  return std::max(kMinIterationBudgetMs, m_frameBudgetMs - m_coloringMs);
+}
+
+int QualityController::iterations(const FractalState &state) const {
+  // Sierpinski runs a fixed number of folds
+  if (!Formula::isEscapeTime(state.fractalType))
+    return state.maxIterations;
+
+  const double zoomSize = std::max(state.zoomSize, 1e-300);
+  if (m_probed && sameFractal(state, m_probedState)) {
+    const double decades = std::log10(m_probedState.zoomSize / zoomSize);
+    return quantize(m_probedIterations + kIterationsPerDecade * decades);
+  }
+
+  const double decades = std::max(0.0, std::log10(kHomeZoomSize / zoomSize));
+  return quantize(kBaseIterations + kIterationsPerDecade * decades);
+}
+
+QualityController::Choice
+QualityController::interactive(const FractalState &state,
+                               const QSize &size) const {
+  const int needed = iterations(state);
+  constexpr int kScaleCount =
+      sizeof(kInteractiveScales) / sizeof(kInteractiveScales[0]);
+  const float smallest = kInteractiveScales[kScaleCount - 1];
+
+  // Nothing measured yet: the cheapest resolution, full iterations
+  if (m_work <= 0.0 || m_iterationMs <= 0.0 ||
+      !Formula::isEscapeTime(state.fractalType))
+    return {needed, smallest};
+
+  const double msPerIteration = m_iterationMs / m_work;
+  const double budget = iterationBudget();
+  const double pixels = static_cast<double>(size.width()) * size.height();
+  for (float scale : kInteractiveScales) {
+    const double cost = msPerIteration * pixels * scale * scale * needed;
+    if (cost <= budget)
+      return {needed, scale};
+  }
+
+  const double affordable =
+      budget / (msPerIteration * pixels * smallest * smallest);
+  const int floor = std::max(kMinIterations, needed / kMaxReduction);
+  return {std::clamp(quantize(affordable), floor, needed), smallest};
+}
+
+bool QualityController::needsProbe(const FractalState &state) const {
+  if (!Formula::isEscapeTime(state.fractalType))
+    return false;
+  if (!m_probed || !sameFractal(state, m_probedState))
+    return true;
+  if (m_saturated && m_probedState.maxIterations < kMaxIterations)
+    return true;
+
+  const double ratio = state.zoomSize / m_probedState.zoomSize;
+  if (ratio < 0.5 || ratio > 2.0)
+    return true;
+  const double offsetX =
+      (state.deepCenterX - m_probedState.deepCenterX).toDouble();
+  const double offsetY =
+      (state.deepCenterY - m_probedState.deepCenterY).toDouble();
+  return std::abs(offsetX) > state.zoomSize ||
+         std::abs(offsetY) > state.zoomSize;
+}
+
+FractalState QualityController::probeState(const FractalState &state) const {
+  FractalState probe = state;
+  probe.maxIterations =
+      std::min(kMaxIterations, kProbeFactor * iterations(state));
+  return probe;
+}
+
+QSize QualityController::probeSize(const QSize &size) {
+  const double aspect =
+      static_cast<double>(size.width()) / std::max(1, size.height());
+  return QSize(std::max(1, static_cast<int>(std::lround(kProbeHeight * aspect))),
+               kProbeHeight);
+}
+
+void QualityController::addProbe(const FractalState &probe,
+                                 const std::vector<float> &data) {
+  std::vector<float> escapes;
+  escapes.reserve(data.size() / 2);
+  for (size_t i = 0; i + 1 < data.size(); i += 2)
+    if (data[i + 1] > 0.5f)
+      escapes.push_back(data[i]);
+
+  m_probed = true;
+  m_probedState = probe;
+  m_saturated = false;
+
+  // Nothing escaped, all interior: the zoom estimate is as good as any
+  if (escapes.empty()) {
+    const double decades =
+        std::max(0.0, std::log10(kHomeZoomSize / probe.zoomSize));
+    m_probedIterations =
+        quantize(kBaseIterations + kIterationsPerDecade * decades);
+    return;
+  }
+
+  const size_t rank = std::min(
+      escapes.size() - 1,
+      static_cast<size_t>(kEscapePercentile * (escapes.size() - 1)));
+  std::nth_element(escapes.begin(), escapes.begin() + rank, escapes.end());
+  const double needed = kMargin * escapes[rank];
+
+  // Pixels escaping this close to the cap suggest more beyond it, the next
+  // probe goes deeper
+  m_saturated = needed > probe.maxIterations;
+  m_probedIterations = quantize(needed);
+}
+
+void QualityController::addFrame(const FractalRenderer::FrameStats &stats,
+                                 int maxIterations) {
+  // GPU times arrive a frame or two after their pixel counts, the decaying
+  // sums even that out
+  if (stats.iterationGpuMs >= 0.0) {
+    m_iterationMs = m_iterationMs * kCostDecay + stats.iterationGpuMs;
+    m_work = m_work * kCostDecay +
+             static_cast<double>(stats.pixelsIterated) * maxIterations;
+  }
+  if (stats.coloringGpuMs >= 0.0)
+    m_coloringMs =
+        m_coloringMs * kCostDecay + stats.coloringGpuMs * (1.0 - kCostDecay);
+}
+
+int QualityController::quantize(double iterations) {
+  const double clamped =
+      std::clamp(iterations, static_cast<double>(kMinIterations),
+                 static_cast<double>(kMaxIterations));
+  const double step = std::pow(10.0, std::floor(std::log10(clamped)) - 1.0);
+  return static_cast<int>(std::round(clamped / step) * step);
+}
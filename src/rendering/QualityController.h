@@ -0,0 +1,123 @@
+#ifndef QUALITYCONTROLLER_H
+#define QUALITYCONTROLLER_H
+
+#include "FractalRenderer.h"
+#include "core/FractalState.h"
+#include <QSize>
+#include <vector>
+
+/**
+ * @brief Picks maxIterations and the moving resolution to fit a frame budget
+ *
+ * How many iterations a view needs depends on where it is far more than on
+ * how deep: a fixed count wastes work on shallow views and leaves black
+ * blobs of unresolved pixels in deep ones. The controller estimates it from
+ * two sources:
+ *
+ *   zoom   kBaseIterations plus kIterationsPerDecade per decade of zoom,
+ *          used until a probe is available
+ *   probe  a small view iterated at kProbeFactor times the estimate. The
+ *          count below which kEscapePercentile of its escaping pixels
+ *          escaped, times kMargin, is what the view needs.
+ *
+ * Between probes the probed count is carried along the zoom at the same
+ * rate per decade. Counts are rounded to two significant digits, so small
+ * zoom steps do not change the colors of palettes that span maxIterations.
+ *
+ * At rest the view always gets the count it needs. While it moves, the GPU
+ * cost per iteration measured by addFrame() predicts the frame time: the
+ * largest of kInteractiveScales that fits the budget at the needed count is
+ * chosen, and only if even the smallest does not fit is the count reduced,
+ * down to a kMaxReduction-th.
+ */
+class QualityController {
+public:
+  struct Choice {
+    int maxIterations;
+    float resolutionScale; // Iteration buffer pixels per target pixel
+  };
+
+  // A 60 Hz frame
+  static constexpr double kDefaultFrameBudgetMs = 16.6;
+
+  static constexpr int kMinIterations = 100;
+  static constexpr int kMaxIterations = 100000;
+
+  // Zoom estimate, from the default view's zoomSize down
+  static constexpr double kHomeZoomSize = 3.0;
+  static constexpr int kBaseIterations = 250;
+  static constexpr int kIterationsPerDecade = 125;
+
+  // Probe view height in pixels, and its iteration cap over the estimate
+  static constexpr int kProbeHeight = 48;
+  static constexpr int kProbeFactor = 4;
+  static constexpr double kEscapePercentile = 0.995;
+  static constexpr double kMargin = 2.0;
+
+  // Resolutions while moving, largest first, and the least share of the
+  // needed iterations a moving frame may drop to
+  static constexpr float kInteractiveScales[] = {1.0f, 0.5f, 0.25f};
+  static constexpr int kMaxReduction = 4;
+
+  QualityController();
+
+  // Budget for a whole frame, iteration and coloring
+  void setFrameBudget(double milliseconds) { m_frameBudgetMs = milliseconds; }
+  double frameBudget() const { return m_frameBudgetMs; }
+
+  // Share of the frame budget left for iteration, for
+  // FractalRenderer::setFrameBudget()
+  double iterationBudget() const;
+
+  // Iterations @p state needs, from the last probe if it still applies
+  int iterations(const FractalState &state) const;
+
+  // Iterations and resolution for a frame of @p state moving at @p size
+  Choice interactive(const FractalState &state, const QSize &size) const;
+
+  /**
+   * @brief True if @p state has no current probe
+   *
+   * A probe applies within a factor of two in zoom and one view size in
+   * distance, and no longer once a probe hit its own cap.
+   */
+  bool needsProbe(const FractalState &state) const;
+
+  // The view to probe for @p state, and the probe size for a view of @p size
+  FractalState probeState(const FractalState &state) const;
+  static QSize probeSize(const QSize &size);
+
+  /**
+   * @brief Takes the escape statistics of a probe
+   * @param data FractalRenderer::probe() output for @p probe
+   */
+  void addProbe(const FractalState &probe, const std::vector<float> &data);
+
+  // Feeds the GPU cost model, @p maxIterations is what the frame ran at
+  void addFrame(const FractalRenderer::FrameStats &stats, int maxIterations);
+
+private:
+  // Weight of the history in the cost averages, per frame
+  static constexpr double kCostDecay = 0.9;
+
+  // Iteration budget never drops below this, so a slow coloring pass can
+  // not stall iteration
+  static constexpr double kMinIterationBudgetMs = 2.0;
+
+  static int quantize(double iterations);
+
+  double m_frameBudgetMs;
+
+  // Last probe, and what it found
+  bool m_probed;
+  FractalState m_probedState;
+  int m_probedIterations;
+  bool m_saturated; // Needed more than the probe iterated
+
+  // Decaying sums for the GPU cost per pixel iteration
+  double m_iterationMs;
+  double m_work;
+  double m_coloringMs;
+};
+
+#endif // QUALITYCONTROLLER_H
@@ -0,0 +1,283 @@
+#include "RenderThread.h"
+#include <QDebug>
+#include <QOpenGLExtraFunctions>
+#include <algorithm>
+
+namespace {
+// Resolution ladder: coarse while the view moves, then one step up per
+// frame once it rests. The last level supersamples and is optional.
+constexpr float kResolutionScales[] = {0.25f, 0.5f, 1.0f, 2.0f};
+constexpr int kInteractiveLevel = 0;
+constexpr int kFullLevel = 2;
+constexpr int kSupersampleLevel = 3;
+
+// Jittered samples averaged at the last level, once the view is at rest
+constexpr int kTemporalSamples = FractalRenderer::kMaxTemporalSamples;
+
+int finalLevel(const RenderThread::Request &request) {
+  return request.supersample ? kSupersampleLevel : kFullLevel;
+}
+} // namespace
+
+bool RenderThread::Request::sameAs(const Request &other) const {
+  return state.sameIterationInputs(other.state) &&
+         state.paletteId == other.state.paletteId && size == other.size &&
+         moving == other.moving && panning == other.panning &&
+         supersample == other.supersample &&
+         target.sameIterationInputs(other.target) &&
+         frameBudgetMs == other.frameBudgetMs;
+}
+
+RenderThread::RenderThread(QObject *parent)
+    : QObject(parent), m_shareContext(nullptr), m_wake(false),
+      m_stopping(false), m_initialized(false), m_tileCache(false),
+      m_resolutionLevel(kInteractiveLevel), m_presentFbo(0),
+      m_presentedFresh(false) {}
+
+RenderThread::~RenderThread() { stop(); }
+
+bool RenderThread::start(QOpenGLContext *shareContext) {
+  if (m_thread || !shareContext)
+    return false;
+  m_shareContext = shareContext;
+
+  // Offscreen surfaces may be backed by a window, so they are created here
+  // on the GUI thread
+  m_surface = std::make_unique<QOffscreenSurface>();
+  m_surface->setFormat(shareContext->format());
+  m_surface->create();
+  m_precompileSurface = std::make_unique<QOffscreenSurface>();
+  m_precompileSurface->setFormat(shareContext->format());
+  m_precompileSurface->create();
+
+  m_thread.reset(QThread::create([this]() { run(); }));
+  m_thread->start(QThread::HighPriority);
+  m_started.acquire();
+
+  if (!m_initialized)
+    stop();
+  return m_initialized;
+}
+
+void RenderThread::enableTileCache(const QString &diskPath) {
+  m_tileCache = true;
+  m_tileCachePath = diskPath;
+}
+
+void RenderThread::stop() {
+  if (m_thread) {
+    {
+      QMutexLocker locker(&m_wakeMutex);
+      m_stopping = true;
+      m_wakeCondition.wakeOne();
+    }
+    m_thread->wait();
+    m_thread.reset();
+  }
+
+  if (m_presentFbo && QOpenGLContext::currentContext()) {
+    QOpenGLContext::currentContext()->extraFunctions()->glDeleteFramebuffers(
+        1, &m_presentFbo);
+    m_presentFbo = 0;
+  }
+}
+
+void RenderThread::request(const Request &request) {
+  m_requests.writeBuffer() = request;
+  m_requests.publish();
+
+  QMutexLocker locker(&m_wakeMutex);
+  m_wake = true;
+  m_wakeCondition.wakeOne();
+}
+
+void RenderThread::waitForWork() {
+  QMutexLocker locker(&m_wakeMutex);
+  while (!m_wake && !m_stopping)
+    m_wakeCondition.wait(&m_wakeMutex);
+  m_wake = false;
+}
+
+void RenderThread::run() {
+  QOpenGLContext context;
+  context.setShareContext(m_shareContext);
+  context.setFormat(m_shareContext->format());
+  if (!context.create() || !context.makeCurrent(m_surface.get())) {
+    qCritical() << "Failed to create the render thread context";
+    m_started.release();
+    return;
+  }
+
+  {
+    FractalRenderer renderer;
+    m_initialized = renderer.initialize();
+    if (m_initialized) {
+      renderer.precompileShaders(m_precompileSurface.get());
+      if (m_tileCache && !renderer.enableTileCache(m_tileCachePath))
+        qWarning() << "Tile cache unavailable";
+    }
+    m_started.release();
+
+    Request current;
+    bool hasRequest = false;
+    bool refining = false;
+    while (m_initialized && !m_stopping) {
+      const bool fresh = m_requests.update();
+      if (fresh) {
+        current = m_requests.readBuffer();
+        hasRequest = true;
+
+        FractalState target = current.target;
+        if (current.frameBudgetMs > 0.0)
+          target.maxIterations = m_quality.iterations(target);
+        renderer.prefetchReferenceOrbit(target, current.size);
+      }
+
+      // Nothing new to show: cache the resting view's tiles, then sleep
+      // until the next request
+      if (!hasRequest || (!fresh && !refining && !renderer.hasPendingWork() &&
+                          !renderer.hasAccumulationWork())) {
+        if (hasRequest && !current.moving && renderer.hasBackgroundWork())
+          renderer.runBackgroundWork();
+        else
+          waitForWork();
+        continue;
+      }
+
+      if (current.moving)
+        m_resolutionLevel = kInteractiveLevel;
+      else if (!current.supersample)
+        m_resolutionLevel = std::min(m_resolutionLevel, kFullLevel);
+
+      Request frame = current;
+      adaptQuality(renderer, frame);
+      renderFrame(renderer, frame);
+      if (frame.frameBudgetMs > 0.0)
+        m_quality.addFrame(renderer.frameStats(), frame.state.maxIterations);
+
+      // At rest, step up a level each time the current one is complete
+      refining = !current.moving && m_resolutionLevel < finalLevel(current);
+      if (refining && !renderer.hasPendingWork())
+        ++m_resolutionLevel;
+    }
+
+    releaseFrames();
+  }
+  context.doneCurrent();
+}
+
+void RenderThread::renderFrame(FractalRenderer &renderer,
+                               const Request &request) {
+  QOpenGLExtraFunctions *gl = QOpenGLContext::currentContext()->extraFunctions();
+  Frame &frame = m_frames.writeBuffer();
+
+  // The GUI context may still be blitting from this texture
+  if (frame.presented) {
+    gl->glWaitSync(frame.presented, 0, GL_TIMEOUT_IGNORED);
+    gl->glDeleteSync(frame.presented);
+    frame.presented = nullptr;
+  }
+  if (frame.rendered) {
+    gl->glDeleteSync(frame.rendered);
+    frame.rendered = nullptr;
+  }
+  if (!frame.target || frame.target->size() != request.size)
+    frame.target = std::make_unique<QOpenGLFramebufferObject>(request.size);
+
+  renderer.setInteractive(request.panning);
+  renderer.setResolutionScale(kResolutionScales[m_resolutionLevel]);
+  renderer.setTemporalSamples(
+      !request.moving && m_resolutionLevel == finalLevel(request)
+          ? kTemporalSamples
+          : 0);
+  renderer.render(request.state, request.size, frame.target->handle());
+
+  frame.info.resolutionScale = kResolutionScales[m_resolutionLevel];
+  frame.info.precision = renderer.precisionMode();
+  frame.info.maxIterations = request.state.maxIterations;
+  frame.info.stats = renderer.frameStats();
+
+  // Flushed so the GUI context can wait for the fence
+  frame.rendered = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  gl->glFlush();
+
+  m_frames.publish();
+  emit frameReady();
+}
+
+void RenderThread::adaptQuality(FractalRenderer &renderer, Request &request) {
+  if (request.frameBudgetMs <= 0.0) {
+    renderer.setFrameBudget(FractalRenderer::kDefaultFrameBudgetMs);
+    return;
+  }
+  m_quality.setFrameBudget(request.frameBudgetMs);
+  renderer.setFrameBudget(m_quality.iterationBudget());
+
+  // Probes stall for one small draw, so only views at rest get them
+  if (!request.moving && m_quality.needsProbe(request.state)) {
+    const FractalState probe = m_quality.probeState(request.state);
+    std::vector<float> data;
+    renderer.probe(probe, QualityController::probeSize(request.size), data);
+    m_quality.addProbe(probe, data);
+  }
+
+  if (!request.moving) {
+    request.state.maxIterations = m_quality.iterations(request.state);
+    return;
+  }
+
+  // The finest level at or below the chosen scale
+  const QualityController::Choice choice =
+      m_quality.interactive(request.state, request.size);
+  request.state.maxIterations = choice.maxIterations;
+  m_resolutionLevel = kInteractiveLevel;
+  while (m_resolutionLevel < kFullLevel &&
+         kResolutionScales[m_resolutionLevel + 1] <= choice.resolutionScale)
+    ++m_resolutionLevel;
+}
+
+void RenderThread::releaseFrames() {
+  QOpenGLExtraFunctions *gl = QOpenGLContext::currentContext()->extraFunctions();
+  Frame *frames = m_frames.buffers();
+  for (int i = 0; i < TripleBuffer<Frame>::kBufferCount; ++i) {
+    if (frames[i].rendered)
+      gl->glDeleteSync(frames[i].rendered);
+    if (frames[i].presented)
+      gl->glDeleteSync(frames[i].presented);
+    frames[i] = Frame();
+  }
+}
+
+bool RenderThread::present(GLuint targetFbo, const QSize &size) {
+  QOpenGLExtraFunctions *gl = QOpenGLContext::currentContext()->extraFunctions();
+  m_presentedFresh = m_frames.update();
+  Frame &frame = m_frames.readBuffer();
+  if (!frame.target)
+    return false;
+
+  if (m_presentedFresh && frame.rendered)
+    gl->glWaitSync(frame.rendered, 0, GL_TIMEOUT_IGNORED);
+
+  // Framebuffer objects are not shared between contexts, the texture is
+  if (!m_presentFbo)
+    gl->glGenFramebuffers(1, &m_presentFbo);
+  gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, m_presentFbo);
+  gl->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_TEXTURE_2D, frame.target->texture(), 0);
+  gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFbo);
+
+  const QSize source = frame.target->size();
+  gl->glBlitFramebuffer(0, 0, source.width(), source.height(), 0, 0,
+                        size.width(), size.height(), GL_COLOR_BUFFER_BIT,
+                        source == size ? GL_NEAREST : GL_LINEAR);
+  gl->glBindFramebuffer(GL_FRAMEBUFFER, targetFbo);
+
+  // The render thread waits for this before drawing into the texture again
+  if (frame.presented)
+    gl->glDeleteSync(frame.presented);
+  frame.presented = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  gl->glFlush();
+
+  m_presentedInfo = frame.info;
+  return true;
+}
@@ -0,0 +1,180 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include "FractalRenderer.h"
+#include "QualityController.h"
+#include "core/FractalState.h"
+#include "core/TripleBuffer.h"
+#include <QMutex>
+#include <QObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Runs FractalRenderer on a thread of its own
+ *
+ * The GUI thread only handles input and physics, publishes a Request per
+ * frame and presents the newest finished frame, so a slow deep-zoom frame
+ * never delays input. Requests and frames cross between the threads
+ * through TripleBuffers without locks.
+ *
+ * The render thread has its own context on an offscreen surface, sharing
+ * with the widget's. It renders each frame into a texture of its own and
+ * fences it. present() waits for that fence on the GPU and fences the
+ * blit in turn, before the render thread may reuse the texture.
+ *
+ * The resolution ladder lives here as well: coarse while the view moves,
+ * then one step up each time the current level is complete. Without new
+ * requests the thread keeps rendering until the view is fully refined and
+ * its temporal samples are accumulated, then fills the tile cache if
+ * enabled, then sleeps.
+ *
+ * Requests with a frame budget hand iterations and the moving resolution
+ * to a QualityController fed with the renderer's GPU timings.
+ */
+class RenderThread : public QObject {
+  Q_OBJECT
+
+public:
+  // What the GUI thread wants to see next
+  struct Request {
+    FractalState state;
+    QSize size;               // Physical pixels
+    bool moving = false;      // Render at the interactive level
+    bool panning = false;     // Lets the renderer reproject sub-pixel pans
+    bool supersample = false; // Refine up to 2x2 samples per pixel
+
+    // Where the view is heading, its reference orbit is prefetched
+    FractalState target;
+
+    // Frame time the QualityController aims for by choosing maxIterations
+    // and the moving resolution. 0 renders state.maxIterations as is.
+    double frameBudgetMs = 0.0;
+
+    // True if rendering @p other would produce the same frame
+    bool sameAs(const Request &other) const;
+  };
+
+  // About the presented frame, for overlays and traces
+  struct FrameInfo {
+    float resolutionScale = 1.0f;
+    PrecisionPolicy::Mode precision = PrecisionPolicy::Mode::Float;
+    int maxIterations = 0; // As rendered, after the quality controller
+    FractalRenderer::FrameStats stats;
+  };
+
+  explicit RenderThread(QObject *parent = nullptr);
+  ~RenderThread() override;
+
+  /**
+   * @brief Starts the thread with a context sharing with @p shareContext
+   * @return false if the renderer failed to initialize
+   *
+   * Call from the GUI thread. Blocks until the renderer is initialized.
+   */
+  bool start(QOpenGLContext *shareContext);
+
+  /**
+   * @brief Lets the renderer assemble revisited views from a tile cache
+   *
+   * Call before start(). Tiles persist in the file at @p diskPath, or only
+   * on the GPU if it is empty.
+   */
+  void enableTileCache(const QString &diskPath = QString());
+
+  // Waits for the current frame and ends the thread
+  void stop();
+
+  /**
+   * @brief Hands @p request to the render thread
+   *
+   * GUI thread only. Requests the thread has not picked up yet are
+   * replaced.
+   */
+  void request(const Request &request);
+
+  /**
+   * @brief Draws the newest finished frame into @p targetFbo
+   * @return false if no frame has been finished yet
+   *
+   * GUI thread only, with the context passed to start() current. Frames
+   * of another size are scaled.
+   */
+  bool present(GLuint targetFbo, const QSize &size);
+
+  // Valid once present() returned true
+  const FrameInfo &presentedInfo() const { return m_presentedInfo; }
+
+  // True if the frame just presented had not been presented before
+  bool presentedFresh() const { return m_presentedFresh; }
+
+signals:
+  // Emitted on the render thread whenever a new frame can be presented
+  void frameReady();
+
+private:
+  struct Frame {
+    std::unique_ptr<QOpenGLFramebufferObject> target;
+    GLsync rendered = nullptr;  // Set by the render thread
+    GLsync presented = nullptr; // Set by present()
+    FrameInfo info;
+  };
+
+  void run();
+
+  // Renders @p request at the current level into the write buffer
+  void renderFrame(FractalRenderer &renderer, const Request &request);
+
+  /**
+   * @brief Applies the quality controller's choice to @p request
+   *
+   * Probes the view at rest if the controller asks for it, then sets the
+   * iterations and, while moving, the resolution level.
+   */
+  void adaptQuality(FractalRenderer &renderer, Request &request);
+
+  // Blocks until request() or stop() is called
+  void waitForWork();
+
+  // Releases the frames with the render context current
+  void releaseFrames();
+
+  std::unique_ptr<QThread> m_thread;
+  QOpenGLContext *m_shareContext;
+  std::unique_ptr<QOffscreenSurface> m_surface;
+  std::unique_ptr<QOffscreenSurface> m_precompileSurface;
+
+  TripleBuffer<Request> m_requests;
+  TripleBuffer<Frame> m_frames;
+
+  // Sleeping only, the handoff itself needs no lock
+  QMutex m_wakeMutex;
+  QWaitCondition m_wakeCondition;
+  bool m_wake;
+  std::atomic<bool> m_stopping;
+
+  // start() waits here for the renderer to initialize
+  QSemaphore m_started;
+  bool m_initialized;
+  bool m_tileCache;
+  QString m_tileCachePath;
+
+  // Render thread: progressive refinement, index into kResolutionScales
+  int m_resolutionLevel;
+  QualityController m_quality;
+
+  // GUI thread
+  GLuint m_presentFbo;
+  bool m_hasPresented;
+  bool m_presentedFresh;
+  FrameInfo m_presentedInfo;
+};
+
+#endif // RENDERTHREAD_H
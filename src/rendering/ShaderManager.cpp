@@ -1,40 +1,173 @@
 #include "ShaderManager.h"
+#include "core/Formula.h"
 #include <QDebug>
 #include <QFile>
+#include <QOpenGLContext>
 
-ShaderManager::ShaderManager() : m_program(nullptr) {}
+ShaderManager::ShaderManager() {}
 
 ShaderManager::~ShaderManager() {
-  // QOpenGLShaderProgram is automatically cleaned up by unique_ptr
-  // but we need to ensure context is active if we were doing manual cleanup
+  // Programs are released by their unique_ptr with the owner's context
+  // current. A running precompile stops after its current variant.
+  m_stopPrecompiling = true;
+  if (m_precompiler)
+    m_precompiler->wait();
 }
 
-bool ShaderManager::loadFractalShader() {
-  m_program = std::make_unique<QOpenGLShaderProgram>();
+QOpenGLShaderProgram *
+ShaderManager::iterationProgram(int fractalType, PrecisionPolicy::Mode mode) {
+  return cachedProgram(m_iterationPrograms, iterationVariant(fractalType, mode));
+}
+
+QOpenGLShaderProgram *ShaderManager::colorProgram(int fractalType) {
+  return cachedProgram(m_colorPrograms, colorVariant(fractalType));
+}
+
+QOpenGLShaderProgram *ShaderManager::tileProgram() {
+  return cachedProgram(m_tilePrograms, tileVariant());
+}
+
+ShaderManager::Variant
+ShaderManager::iterationVariant(int fractalType, PrecisionPolicy::Mode mode) {
+  if (!Formula::isEscapeTime(fractalType))
+    mode = PrecisionPolicy::Mode::Float;
+
+  // Values of the PRECISION_* symbols in fractal.frag
+  const int precision = static_cast<int>(mode);
+  return {{fractalType, precision},
+          ":/shaders/shaders/fractal.frag",
+          QStringList() << QString("FRACTAL_TYPE %1").arg(fractalType)
+                        << QString("FORMULA_POWER %1")
+                               .arg(Formula::power(fractalType))
+                        << QString("PRECISION %1").arg(precision)};
+}
 
-  // Load and compile vertex shader
-  if (!m_program->addShaderFromSourceFile(QOpenGLShader::Vertex,
-                                          ":/shaders/shaders/fractal.vert")) {
-    qCritical() << "Failed to compile vertex shader:" << m_program->log();
+ShaderManager::Variant ShaderManager::colorVariant(int fractalType) {
+  // Only Sierpinski is colored differently, palettes are texture layers
+  if (fractalType != Formula::Sierpinski)
+    fractalType = 0;
+  return {{fractalType, 0},
+          ":/shaders/shaders/colorize.frag",
+          QStringList() << QString("FRACTAL_TYPE %1").arg(fractalType)};
+}
+
+ShaderManager::Variant ShaderManager::tileVariant() {
+  return {{0, 0}, ":/shaders/shaders/tile.frag", QStringList()};
+}
+
+bool ShaderManager::supportsNativeDouble() {
+  // Doubles are core in GLSL 4.00, older contexts need the extension
+  const QOpenGLContext *context = QOpenGLContext::currentContext();
+  if (!context || (context->format().version() < qMakePair(4, 0) &&
+                   !context->hasExtension("GL_ARB_gpu_shader_fp64")))
     return false;
+  return iterationProgram(0, PrecisionPolicy::Mode::Double) != nullptr;
+}
+
+void ShaderManager::precompileVariants(bool nativeDouble,
+                                       QOffscreenSurface *surface) {
+  QOpenGLContext *shareContext = QOpenGLContext::currentContext();
+  if (!shareContext || m_precompiler)
+    return;
+
+  // Roughly in the order a session reaches them: zooming in, then the
+  // other fractals
+  using Mode = PrecisionPolicy::Mode;
+  std::vector<Mode> modes = {Mode::Float, Mode::DoubleFloat,
+                             Mode::Perturbation};
+  if (nativeDouble)
+    modes.insert(modes.begin() + 1, Mode::Double);
+
+  std::vector<Variant> variants;
+  for (Mode mode : modes)
+    variants.push_back(iterationVariant(0, mode));
+  variants.push_back(colorVariant(0));
+  variants.push_back(tileVariant());
+  for (Mode mode : modes)
+    variants.push_back(iterationVariant(1, mode));
+  variants.push_back(iterationVariant(Formula::Sierpinski, Mode::Float));
+  variants.push_back(colorVariant(Formula::Sierpinski));
+  for (int type = Formula::BurningShip; type < Formula::kCount; ++type) {
+    for (Mode mode : modes)
+      variants.push_back(iterationVariant(type, mode));
+  }
+
+  if (!surface) {
+    m_precompileSurface = std::make_unique<QOffscreenSurface>();
+    m_precompileSurface->setFormat(shareContext->format());
+    m_precompileSurface->create();
+    surface = m_precompileSurface.get();
+  }
+
+  m_precompiler.reset(QThread::create([this, shareContext, surface,
+                                       variants]() {
+    QOpenGLContext context;
+    context.setShareContext(shareContext);
+    context.setFormat(shareContext->format());
+    if (!context.create() || !context.makeCurrent(surface)) {
+      qWarning() << "Shader precompilation unavailable";
+      return;
+    }
+    for (const Variant &variant : variants) {
+      if (m_stopPrecompiling)
+        break;
+      buildProgram(variant.fragmentPath, variant.defines);
+    }
+    context.doneCurrent();
+  }));
+  m_precompiler->start(QThread::LowPriority);
+}
+
+QOpenGLShaderProgram *ShaderManager::cachedProgram(ProgramCache &cache,
+                                                   const Variant &variant) {
+  auto it = cache.find(variant.key);
+  if (it == cache.end())
+    it = cache
+             .emplace(variant.key,
+                      buildProgram(variant.fragmentPath, variant.defines))
+             .first;
+  return it->second.get();
+}
+
+std::unique_ptr<QOpenGLShaderProgram>
+ShaderManager::buildProgram(const QString &fragmentPath,
+                            const QStringList &defines) {
+  auto program = std::make_unique<QOpenGLShaderProgram>();
+
+  // Cacheable shaders are compiled at link(), or not at all if the binary
+  // cache has the linked program
+  if (!program->addCacheableShaderFromSourceFile(
+          QOpenGLShader::Vertex, ":/shaders/shaders/fractal.vert")) {
+    qCritical() << "Failed to compile vertex shader:" << program->log();
+    return nullptr;
   }
 
   // Load and compile fragment shader
-  if (!m_program->addShaderFromSourceFile(QOpenGLShader::Fragment,
-                                          ":/shaders/shaders/fractal.frag")) {
-    qCritical() << "Failed to compile fragment shader:" << m_program->log();
-    return false;
+  QFile file(fragmentPath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qCritical() << "Failed to open fragment shader" << fragmentPath;
+    return nullptr;
   }
+  QByteArray source = file.readAll();
 
-  // Link shader program
-  if (!m_program->link()) {
-    qCritical() << "Failed to link shader program:" << m_program->log();
-    return false;
+  // #version must stay the first line
+  QByteArray prelude;
+  for (const QString &define : defines)
+    prelude += "#define " + define.toLatin1() + "\n";
+  source.insert(source.indexOf('\n') + 1, prelude);
+
+  if (!program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment,
+                                                source)) {
+    qCritical() << "Failed to compile fragment shader" << fragmentPath << ":"
+                << program->log();
+    return nullptr;
   }
 
-  return true;
-}
+  // Link shader program
+  if (!program->link()) {
+    qCritical() << "Failed to link shader program:" << program->log();
+    return nullptr;
+  }
 
-QOpenGLShaderProgram *ShaderManager::getProgram() const {
-  return m_program.get();
+  return program;
 }
@@ -1,15 +1,38 @@
 #ifndef SHADERMANAGER_H
 #define SHADERMANAGER_H
 
+#include "PrecisionPolicy.h"
+#include <QOffscreenSurface>
 #include <QOpenGLShaderProgram>
 #include <QString>
+#include <QStringList>
+#include <QThread>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 /**
  * @brief Manages OpenGL shader programs for fractal rendering
  *
  * Handles loading, compiling, and linking of vertex and fragment shaders.
- * Provides access to the compiled QOpenGLShaderProgram.
+ * Provides access to the compiled QOpenGLShaderProgram for each pass: the
+ * iteration pass (fractal.frag), the coloring pass (colorize.frag) and the
+ * tile cache pass (tile.frag).
+ *
+ * Every pass comes in specialized variants, built from the same source with
+ * preprocessor symbols defined right after its #version line. A variant is
+ * keyed on the fractal type and the precision mode, and the type implies
+ * the formula power (FORMULA_POWER). All three are fixed per variant, so
+ * the per-pixel code has no branches on them. Variants are built on first
+ * use and kept.
+ *
+ * Programs go through Qt's program binary cache, which stores linked
+ * binaries on disk keyed by the source hash and checks the GL vendor,
+ * renderer and version they were built with. precompileVariants() fills
+ * it from a background context, so a variant used for the first time only
+ * loads a binary instead of compiling.
  */
 class ShaderManager {
 public:
@@ -17,19 +40,89 @@ public:
   ~ShaderManager();
 
   /**
-   * @brief Loads and compiles the fractal shader program
-   * @return true if successful, false otherwise
+   * @brief Returns the iteration program for @p fractalType in @p mode
+   *
+   * Sierpinski only has a float path, its mode is ignored.
+   *
+   * @return Pointer to QOpenGLShaderProgram, or nullptr if it failed to
+   * build
+   */
+  QOpenGLShaderProgram *iterationProgram(int fractalType,
+                                         PrecisionPolicy::Mode mode);
+
+  /**
+   * @brief Returns the coloring program for @p fractalType
+   *
+   * Mandelbrot and Julia share their program. The palette is a texture
+   * layer chosen by uniform, see FractalRenderer::setPalettes().
+   *
+   * @return Pointer to QOpenGLShaderProgram, or nullptr if it failed to
+   * build
    */
-  bool loadFractalShader();
+  QOpenGLShaderProgram *colorProgram(int fractalType);
 
   /**
-   * @brief Returns the active shader program
-   * @return Pointer to QOpenGLShaderProgram, or nullptr if not loaded
+   * @brief Returns the program copying cached tiles into the iteration
+   * buffer (tile.frag), nullptr if it failed to build
    */
-  QOpenGLShaderProgram *getProgram() const;
+  QOpenGLShaderProgram *tileProgram();
+
+  /**
+   * @brief True if the iteration pass can be built with native fp64
+   *
+   * Needs GLSL 4.00 doubles or the GL_ARB_gpu_shader_fp64 extension, and
+   * the Mandelbrot variant to compile.
+   */
+  bool supportsNativeDouble();
+
+  /**
+   * @brief Builds every variant once on a thread of its own
+   *
+   * Uses a context sharing with the current one. The programs are thrown
+   * away, building them only fills the binary cache. @p nativeDouble adds
+   * the fp64 variants. Does nothing if already started.
+   *
+   * The background context renders to @p surface, which must outlive this
+   * manager. If null, one is created, which is only allowed on the GUI
+   * thread.
+   */
+  void precompileVariants(bool nativeDouble,
+                          QOffscreenSurface *surface = nullptr);
 
 private:
-  std::unique_ptr<QOpenGLShaderProgram> m_program;
+  // Fractal type and precision, FORMULA_POWER is implied by the type
+  using VariantKey = std::pair<int, int>;
+  using ProgramCache =
+      std::map<VariantKey, std::unique_ptr<QOpenGLShaderProgram>>;
+
+  struct Variant {
+    VariantKey key;
+    QString fragmentPath;
+    QStringList defines;
+  };
+
+  static Variant iterationVariant(int fractalType, PrecisionPolicy::Mode mode);
+  static Variant colorVariant(int fractalType);
+  static Variant tileVariant();
+
+  // Looks up @p variant, building it on a miss. Failed builds are cached
+  // too, so they are only reported once.
+  static QOpenGLShaderProgram *cachedProgram(ProgramCache &cache,
+                                             const Variant &variant);
+
+  static std::unique_ptr<QOpenGLShaderProgram>
+  buildProgram(const QString &fragmentPath,
+               const QStringList &defines = QStringList());
+
+  ProgramCache m_iterationPrograms;
+  ProgramCache m_colorPrograms;
+  ProgramCache m_tilePrograms;
+
+  // Background precompilation, the surface has to be created on the GUI
+  // thread
+  std::unique_ptr<QOffscreenSurface> m_precompileSurface;
+  std::unique_ptr<QThread> m_precompiler;
+  std::atomic<bool> m_stopPrecompiling{false};
 };
 
 #endif // SHADERMANAGER_H
@@ -0,0 +1,246 @@
+#include "TileCache.h"
+#include "core/Formula.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Every orbit starting this far out escapes at once, and tile indices stay
+// well inside int range
+constexpr double kMaxCoordinate = 16.0;
+
+std::unique_ptr<QOpenGLFramebufferObject> createTileBuffer() {
+  return std::make_unique<QOpenGLFramebufferObject>(
+      QSize(TileCache::kTileSize, TileCache::kTileSize),
+      QOpenGLFramebufferObject::NoAttachment, GL_TEXTURE_2D, GL_RG32F);
+}
+
+// Leaves out what the iteration of @p state does not depend on, so tiles
+// are shared across those fields
+TileKey tileKey(const FractalState &state, int level, int x, int y) {
+  TileKey key;
+  key.fractalType = state.fractalType;
+  if (state.fractalType == Formula::Julia) {
+    key.juliaCx = state.juliaCx;
+    key.juliaCy = state.juliaCy;
+  }
+  if (Formula::isEscapeTime(state.fractalType))
+    key.maxIterations = state.maxIterations;
+  key.level = level;
+  key.x = x;
+  key.y = y;
+  return key;
+}
+} // namespace
+
+TileCache::TileCache() : m_reserved(-1), m_clock(1) {}
+
+TileCache::~TileCache() = default;
+
+bool TileCache::initialize(int gpuTiles) {
+  initializeOpenGLFunctions();
+  m_slots.clear();
+  m_slots.resize(std::max(1, gpuTiles));
+
+  // Tiles are created on first use, the first one checks the format works
+  m_slots[0].buffer = createTileBuffer();
+  if (!m_slots[0].buffer->isValid()) {
+    m_slots.clear();
+    return false;
+  }
+  return true;
+}
+
+bool TileCache::openDiskTier(const QString &path, int capacity) {
+  if (!m_disk.open(path, capacity)) {
+    qWarning() << "Tile cache stays in memory:" << m_disk.errorString();
+    return false;
+  }
+  return true;
+}
+
+double TileCache::tileSpan(int level) {
+  return std::ldexp(TileStore::kRootSpan, -level);
+}
+
+bool TileCache::cover(const FractalState &state, const QSize &size,
+                      Cover &cover) {
+  if (size.isEmpty())
+    return false;
+
+  // Finest level whose texels are no larger than a pixel
+  const double pixelSize = state.zoomSize / size.height();
+  const int level = static_cast<int>(
+      std::ceil(std::log2(TileStore::kRootSpan / (kTileSize * pixelSize))));
+  if (level < 0 || level > kMaxLevel)
+    return false;
+
+  const double halfWidth = 0.5 * size.width() * pixelSize;
+  const double halfHeight = 0.5 * size.height() * pixelSize;
+  if (std::abs(state.zoomCenterX) + halfWidth > kMaxCoordinate ||
+      std::abs(state.zoomCenterY) + halfHeight > kMaxCoordinate)
+    return false;
+
+  const double span = tileSpan(level);
+  cover.level = level;
+  cover.texelsPerPixel = pixelSize * kTileSize / span;
+  cover.tilePixels = span / pixelSize;
+
+  // Indices from the double center are only approximate at fine levels,
+  // positions are taken relative to the exact one. A pixel belongs to the
+  // tile its center falls into.
+  auto firstTile = [&](double center, const BigReal &deepCenter,
+                       double halfExtent, int extent, int &index,
+                       double &origin) {
+    index = static_cast<int>(std::floor((center - halfExtent) / span));
+    origin = 0.5 * extent +
+             (BigReal(index * span, deepCenter.limbCount()) - deepCenter)
+                     .toDouble() /
+                 pixelSize;
+    while (origin + cover.tilePixels <= 0.5) {
+      ++index;
+      origin += cover.tilePixels;
+    }
+    while (origin > 0.5) {
+      --index;
+      origin -= cover.tilePixels;
+    }
+    return static_cast<int>(
+               std::floor((extent - 0.5 - origin) / cover.tilePixels)) +
+           1;
+  };
+  cover.columns = firstTile(state.zoomCenterX, state.deepCenterX, halfWidth,
+                            size.width(), cover.firstX, cover.originX);
+  cover.rows = firstTile(state.zoomCenterY, state.deepCenterY, halfHeight,
+                         size.height(), cover.firstY, cover.originY);
+
+  cover.keys.clear();
+  for (int row = 0; row < cover.rows; ++row)
+    for (int column = 0; column < cover.columns; ++column)
+      cover.keys.push_back(tileKey(state, level, cover.firstX + column,
+                                   cover.firstY + row));
+  return true;
+}
+
+FractalState TileCache::tileState(const FractalState &state,
+                                  const TileKey &key) {
+  const double span = tileSpan(key.level);
+  FractalState tile = state;
+  tile.zoomCenterX = (key.x + 0.5) * span;
+  tile.zoomCenterY = (key.y + 0.5) * span;
+  tile.deepCenterX = BigReal(tile.zoomCenterX);
+  tile.deepCenterY = BigReal(tile.zoomCenterY);
+  tile.zoomSize = span;
+  return tile;
+}
+
+bool TileCache::contains(const TileKey &key) const {
+  return m_resident.count(key) != 0 || m_disk.contains(key);
+}
+
+bool TileCache::acquire(const std::vector<TileKey> &keys,
+                        std::vector<GLuint> &textures) {
+  const int available = gpuCapacity() - (m_reserved >= 0 ? 1 : 0);
+  if (static_cast<int>(keys.size()) > available)
+    return false;
+  for (const TileKey &key : keys)
+    if (!contains(key))
+      return false;
+
+  // Touch the resident tiles first, so loading the others from disk only
+  // ever replaces tiles this view does not need
+  for (const TileKey &key : keys) {
+    auto it = m_resident.find(key);
+    if (it != m_resident.end())
+      m_slots[it->second].lastUse = m_clock++;
+  }
+
+  textures.clear();
+  for (const TileKey &key : keys) {
+    auto it = m_resident.find(key);
+    int slot;
+    if (it != m_resident.end()) {
+      slot = it->second;
+    } else {
+      const float *texels = m_disk.find(key);
+      slot = replaceableSlot();
+      release(slot);
+      Slot &loaded = m_slots[slot];
+      if (!loaded.buffer)
+        loaded.buffer = createTileBuffer();
+      glBindTexture(GL_TEXTURE_2D, loaded.buffer->texture());
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kTileSize, kTileSize, GL_RG,
+                      GL_FLOAT, texels);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      loaded.key = key;
+      loaded.ready = true;
+      m_resident[key] = slot;
+    }
+    m_slots[slot].lastUse = m_clock++;
+    textures.push_back(m_slots[slot].buffer->texture());
+  }
+  return true;
+}
+
+QOpenGLFramebufferObject *TileCache::beginTile(const TileKey &key) {
+  if (m_reserved >= 0) {
+    if (m_slots[m_reserved].key == key)
+      return m_slots[m_reserved].buffer.get();
+    m_reserved = -1;
+  }
+
+  const int slot = replaceableSlot();
+  if (slot < 0)
+    return nullptr;
+  release(slot);
+  Slot &reserved = m_slots[slot];
+  if (!reserved.buffer)
+    reserved.buffer = createTileBuffer();
+  reserved.key = key;
+  m_reserved = slot;
+  return reserved.buffer.get();
+}
+
+void TileCache::finishTile() {
+  if (m_reserved < 0)
+    return;
+  Slot &finished = m_slots[m_reserved];
+
+  auto it = m_resident.find(finished.key);
+  if (it != m_resident.end())
+    release(it->second);
+  finished.ready = true;
+  finished.lastUse = m_clock++;
+  m_resident[finished.key] = m_reserved;
+  m_reserved = -1;
+
+  // Written through once, so evicting it from the GPU later costs nothing
+  if (m_disk.isOpen()) {
+    m_transfer.resize(TileStore::kTexelFloats);
+    finished.buffer->bind();
+    glReadPixels(0, 0, kTileSize, kTileSize, GL_RG, GL_FLOAT,
+                 m_transfer.data());
+    finished.buffer->release();
+    m_disk.store(finished.key, m_transfer.data());
+  }
+}
+
+int TileCache::replaceableSlot() const {
+  int oldest = -1;
+  for (int slot = 0; slot < gpuCapacity(); ++slot) {
+    if (slot == m_reserved)
+      continue;
+    if (!m_slots[slot].ready)
+      return slot;
+    if (oldest < 0 || m_slots[slot].lastUse < m_slots[oldest].lastUse)
+      oldest = slot;
+  }
+  return oldest;
+}
+
+void TileCache::release(int slot) {
+  Slot &released = m_slots[slot];
+  if (released.ready)
+    m_resident.erase(released.key);
+  released.ready = false;
+}
@@ -0,0 +1,131 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include "core/FractalState.h"
+#include "core/TileStore.h"
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QSize>
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Quadtree cache of iteration data tiles for revisited views
+ *
+ * A tile is a fixed kTileSize square of iteration data (the r and g
+ * channels of the iteration buffer) on the grid of its level, see TileKey.
+ * A view can be assembled from the tiles of the level whose texels are at
+ * most one buffer pixel and more than half of one, so revisiting a view, or
+ * any view at that scale over the same area, needs no iteration at all.
+ *
+ * Two tiers: a fixed number of GPU-resident tiles, replaced least recently
+ * used first, and an optional TileStore on disk that every finished tile
+ * is written through to. Tiles missing on the GPU are uploaded from disk
+ * when a view needs them.
+ *
+ * Only levels 0 to kMaxLevel are cached. Finer tiles would need their own
+ * perturbation reference orbit each.
+ *
+ * All methods must be called with the owning GL context current.
+ */
+class TileCache : protected QOpenGLExtraFunctions {
+public:
+  static constexpr int kTileSize = TileStore::kTileSize;
+  static constexpr int kMaxLevel = 18;
+
+  // 512 KiB per tile
+  static constexpr int kDefaultGpuTiles = 192;
+  static constexpr int kDefaultDiskTiles = 512;
+
+  // The tiles one view is assembled from, in rows bottom up
+  struct Cover {
+    int level = -1;
+    double texelsPerPixel = 0.0; // 1 to 2
+    double tilePixels = 0.0;     // Tile side in buffer pixels
+    int firstX = 0;
+    int firstY = 0;
+    int columns = 0;
+    int rows = 0;
+    double originX = 0.0; // Buffer position of tile (firstX, firstY)
+    double originY = 0.0;
+    std::vector<TileKey> keys;
+  };
+
+  TileCache();
+  ~TileCache();
+
+  // Creates the GPU tier, false if its buffers could not be created
+  bool initialize(int gpuTiles = kDefaultGpuTiles);
+
+  /**
+   * @brief Adds the disk tier at @p path, see TileStore::open()
+   * @return false if the file could not be opened, the cache then stays
+   * GPU only
+   */
+  bool openDiskTier(const QString &path, int capacity = kDefaultDiskTiles);
+
+  int gpuCapacity() const { return static_cast<int>(m_slots.size()); }
+
+  // Fractal units the side of a tile of @p level spans
+  static double tileSpan(int level);
+
+  /**
+   * @brief Tiles covering @p state iterated at @p size
+   * @return false if the view's pixel size is outside the cached levels or
+   * the view lies far outside the bailout radius
+   */
+  static bool cover(const FractalState &state, const QSize &size,
+                    Cover &cover);
+
+  // @p state iterated at kTileSize x kTileSize shows exactly tile @p key
+  static FractalState tileState(const FractalState &state,
+                                const TileKey &key);
+
+  // True if either tier holds the finished tile
+  bool contains(const TileKey &key) const;
+
+  /**
+   * @brief Makes all of @p keys GPU-resident at the same time
+   * @param textures Receives the tile textures in the order of @p keys
+   * @return false if a tile is in neither tier or there are more tiles than
+   * the GPU tier holds
+   */
+  bool acquire(const std::vector<TileKey> &keys,
+               std::vector<GLuint> &textures);
+
+  /**
+   * @brief Reserves a GPU tile for iterating @p key into
+   *
+   * The tile stays reserved and invisible to lookups until finishTile().
+   * Asking for the reserved key again returns the same buffer, asking for
+   * another one drops it.
+   *
+   * @return nullptr if every GPU tile is in use
+   */
+  QOpenGLFramebufferObject *beginTile(const TileKey &key);
+
+  // Publishes the reserved tile and writes it to the disk tier
+  void finishTile();
+
+private:
+  struct Slot {
+    std::unique_ptr<QOpenGLFramebufferObject> buffer;
+    TileKey key;
+    quint64 lastUse = 0;
+    bool ready = false;
+  };
+
+  // A free or least recently used ready slot, not the reserved one
+  int replaceableSlot() const;
+  void release(int slot);
+
+  std::vector<Slot> m_slots;
+  std::map<TileKey, int> m_resident; // Ready slots by key
+  int m_reserved;
+  quint64 m_clock;
+  TileStore m_disk;
+  std::vector<float> m_transfer; // Disk tier readback and upload
+};
+
+#endif // TILECACHE_H